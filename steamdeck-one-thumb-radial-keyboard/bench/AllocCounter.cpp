@@ -0,0 +1,98 @@
+#include "AllocCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local std::uint64_t t_allocations = 0;
+
+void *countedAlloc(std::size_t size) {
+    ++t_allocations;
+    if (size == 0) {
+        size = 1;
+    }
+    if (void *ptr = std::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *countedAlignedAlloc(std::size_t size, std::align_val_t align) {
+    ++t_allocations;
+    const std::size_t alignment = static_cast<std::size_t>(align);
+    // aligned_alloc requires the size to be a multiple of the alignment.
+    const std::size_t rounded = ((size + alignment - 1) / alignment) * alignment;
+    if (void *ptr = std::aligned_alloc(alignment, rounded == 0 ? alignment : rounded)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+namespace radialkb {
+
+std::uint64_t threadAllocationCount() {
+    return t_allocations;
+}
+
+} // namespace radialkb
+
+void *operator new(std::size_t size) {
+    return countedAlloc(size);
+}
+
+void *operator new[](std::size_t size) {
+    return countedAlloc(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    ++t_allocations;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    ++t_allocations;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+    return countedAlignedAlloc(size, align);
+}
+
+void *operator new[](std::size_t size, std::align_val_t align) {
+    return countedAlignedAlloc(size, align);
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
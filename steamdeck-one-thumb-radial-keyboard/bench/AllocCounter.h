@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+// Replaces the global operator new/delete for the binary it is linked into and counts
+// heap allocations per thread. Link only into benchmark and test executables.
+
+namespace radialkb {
+
+// Allocations made so far by the calling thread.
+std::uint64_t threadAllocationCount();
+
+// Allocations made by the calling thread while it is alive.
+class AllocationScope {
+public:
+    AllocationScope() : m_start(threadAllocationCount()) {}
+    std::uint64_t count() const { return threadAllocationCount() - m_start; }
+
+private:
+    std::uint64_t m_start;
+};
+
+} // namespace radialkb
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "../src/core/GestureRecognizer.h"
+#include "../src/core/SelectionRules.h"
+#include "../src/core/StaticRadialLayout.h"
+#include "../src/core/TouchSession.h"
+
+// Microbenchmarks for radialkb_core. Links nothing but the core, so it runs on hosts without
+// Qt (configure with -DRADIALKB_CORE_ONLY=ON). Same JSON shape as radialkb_bench.
+
+using namespace radialkb;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    long long minTimeMs = 300;
+    std::string filter;
+    std::string outputPath;
+};
+
+struct BenchResult {
+    std::string name;
+    long long iterations = 0;
+    double nsPerOp = 0.0;
+    double allocsPerOp = 0.0;
+};
+
+template <typename T>
+inline void keepAlive(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+long long elapsedNs(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+template <typename Fn>
+BenchResult runBenchmark(const char *name, const BenchOptions &options, Fn &&op) {
+    const long long minTimeNs = options.minTimeMs * 1000000LL;
+
+    // Warm up and pick a batch size that takes roughly a tenth of the measuring window.
+    long long batch = 1;
+    for (;;) {
+        const Clock::time_point start = Clock::now();
+        for (long long i = 0; i < batch; ++i) {
+            op();
+        }
+        if (elapsedNs(start) * 10 >= minTimeNs || batch >= (1LL << 30)) {
+            break;
+        }
+        batch *= 2;
+    }
+
+    long long iterations = 0;
+    long long elapsed = 0;
+    const AllocationScope allocations;
+    const Clock::time_point start = Clock::now();
+    while (elapsed < minTimeNs) {
+        for (long long i = 0; i < batch; ++i) {
+            op();
+        }
+        iterations += batch;
+        elapsed = elapsedNs(start);
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.nsPerOp = static_cast<double>(elapsed) / static_cast<double>(iterations);
+    result.allocsPerOp = static_cast<double>(allocations.count()) / static_cast<double>(iterations);
+    return result;
+}
+
+struct Point {
+    double x;
+    double y;
+};
+
+std::vector<Point> arcPoints(int count, double radius) {
+    std::vector<Point> points;
+    points.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const double angle = (2.0 * M_PI * i) / count;
+        points.push_back(Point{0.5 + radius * std::cos(angle), 0.5 + radius * std::sin(angle)});
+    }
+    return points;
+}
+
+class CountingListener final : public TouchListener {
+public:
+    void selectionChanged(const SelectionState &) override { ++selections; }
+    void committed(const TouchCommit &) override { ++commits; }
+    void cancelled() override {}
+
+    long long selections = 0;
+    long long commits = 0;
+};
+
+void usage() {
+    std::fprintf(stderr, "usage: radialkb_core_bench [--min-time-ms ms] [--filter text] [--output file]\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--min-time-ms") == 0 && hasValue) {
+            options.minTimeMs = std::max(10LL, std::atoll(argv[++i]));
+        } else if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+            options.filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--output") == 0 && hasValue) {
+            options.outputPath = argv[++i];
+        } else {
+            usage();
+            return std::strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    auto selected = [&options](const char *name) {
+        return options.filter.empty() || std::string(name).find(options.filter) != std::string::npos;
+    };
+    const DefaultRadialLayout layout(kDefaultRadialTables);
+
+    if (selected("core.hitTestStatic")) {
+        const std::vector<Point> points = arcPoints(97, 0.35);
+        std::size_t next = 0;
+        results.push_back(runBenchmark("core.hitTestStatic", options, [&]() {
+            const Point &p = points[next];
+            const double angle = layout.angleForPoint(p.x, p.y);
+            const int sector = layout.angleToSectorWithHysteresis(angle, -1, 0.0);
+            const int key = layout.angleToKeyIndexWithHysteresis(angle, sector, -1, 0.0);
+            keepAlive(key);
+            next = (next + 1) % points.size();
+        }));
+    }
+
+    if (selected("core.resolveSelection")) {
+        const std::vector<Point> points = arcPoints(256, 0.38);
+        SelectionState state;
+        std::size_t next = 0;
+        results.push_back(runBenchmark("core.resolveSelection", options, [&]() {
+            state = resolveSelection(layout, points[next].x, points[next].y, state);
+            keepAlive(state);
+            next = (next + 1) % points.size();
+        }));
+    }
+
+    if (selected("core.gestureClassify")) {
+        GestureRecognizer recognizer;
+        const TouchSample starts[] = {{0.5, 0.5, 1000}, {0.5, 0.5, 1000}, {0.5, 0.5, 1000}, {0.5, 0.5, 1000}};
+        const TouchSample ends[] = {{0.8, 0.5, 1100}, {0.2, 0.5, 1100}, {0.5, 0.8, 1100}, {0.52, 0.51, 1100}};
+        int next = 0;
+        results.push_back(runBenchmark("core.gestureClassify", options, [&]() {
+            recognizer.onTouchDown(starts[next]);
+            keepAlive(recognizer.onTouchUp(ends[next]));
+            next = (next + 1) & 3;
+        }));
+    }
+
+    if (selected("core.touchMove")) {
+        // Counterpart of router.updateSelection in radialkb_bench, without the Qt adapter.
+        CountingListener listener;
+        TouchSession session(layout, listener);
+        const std::vector<Point> points = arcPoints(256, 0.38);
+        std::int64_t timeMs = 0;
+        session.touchDown(TouchSample{points[0].x, points[0].y, timeMs});
+        std::size_t next = 0;
+        results.push_back(runBenchmark("core.touchMove", options, [&]() {
+            session.touchMove(TouchSample{points[next].x, points[next].y, ++timeMs});
+            next = (next + 1) % points.size();
+        }));
+        keepAlive(listener.selections);
+    }
+
+    if (selected("core.tapCommit")) {
+        // A whole letter-ring tap: down, a few moves toward the key, lift and commit.
+        CountingListener listener;
+        TouchSession session(layout, listener);
+        const LayoutPoint anchor = layout.keyAnchor(1, 2);
+        std::int64_t timeMs = 0;
+        results.push_back(runBenchmark("core.tapCommit", options, [&]() {
+            timeMs += 1000;
+            session.touchDown(TouchSample{anchor.x, anchor.y, timeMs});
+            for (int i = 1; i <= 4; ++i) {
+                session.touchMove(TouchSample{anchor.x + 0.002 * i, anchor.y, timeMs + 30 * i});
+            }
+            session.touchUp(TouchSample{anchor.x + 0.01, anchor.y, timeMs + 150});
+        }));
+        keepAlive(listener.commits);
+    }
+
+    std::string json = "{\n    \"tool\": \"radialkb_core_bench\",\n";
+    char line[256];
+    std::snprintf(line, sizeof(line), "    \"timestamp\": %lld,\n    \"min_time_ms\": %lld,\n    \"results\": [\n",
+                  static_cast<long long>(std::time(nullptr)), options.minTimeMs);
+    json += line;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &result = results[i];
+        std::snprintf(line, sizeof(line),
+                      "        {\"name\": \"%s\", \"iterations\": %lld, \"ns_per_op\": %.3f, \"allocs_per_op\": %.3f}%s\n",
+                      result.name.c_str(), result.iterations, result.nsPerOp, result.allocsPerOp,
+                      i + 1 < results.size() ? "," : "");
+        json += line;
+        std::fprintf(stderr, "%-28s %10.1f ns/op %8.2f allocs/op\n", result.name.c_str(), result.nsPerOp,
+                     result.allocsPerOp);
+    }
+    json += "    ]\n}\n";
+
+    if (options.outputPath.empty()) {
+        std::fputs(json.c_str(), stdout);
+        return 0;
+    }
+    FILE *out = std::fopen(options.outputPath.c_str(), "w");
+    if (!out) {
+        std::fprintf(stderr, "radialkb_core_bench: cannot write %s\n", options.outputPath.c_str());
+        return 1;
+    }
+    std::fputs(json.c_str(), out);
+    std::fclose(out);
+    return 0;
+}
@@ -0,0 +1,372 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QVector>
+#include <QtMath>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cmath>
+
+#include "AllocCounter.h"
+#include "../src/engine/Autocorrect.h"
+#include "../src/core/GestureRecognizer.h"
+#include "../src/engine/HapticsSink.h"
+#include "../src/engine/InputRouter.h"
+#include "../src/engine/Logging.h"
+#include "../src/engine/PointCloudRecognizer.h"
+#include "../src/engine/RadialLayout.h"
+#include "../src/core/StaticRadialLayout.h"
+#include "../src/engine/UInputKeyboard.h"
+#include "../src/engine/swipe/SwipeDecoder.h"
+
+// Microbenchmarks for the engine hot paths. Results (ns/op, allocations/op) are written as
+// JSON so runs on the same machine can be diffed across commits.
+
+using namespace radialkb;
+
+namespace {
+
+struct BenchOptions {
+    qint64 minTimeMs = 300;
+    QString filter;
+    QString recordingPath;
+};
+
+struct BenchResult {
+    QString name;
+    qint64 iterations = 0;
+    double nsPerOp = 0.0;
+    double allocsPerOp = 0.0;
+};
+
+template <typename T>
+inline void keepAlive(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+template <typename Fn>
+BenchResult runBenchmark(const QString &name, const BenchOptions &options, Fn &&op) {
+    const qint64 minTimeNs = options.minTimeMs * 1000000LL;
+
+    // Warm up and pick a batch size that takes roughly a tenth of the measuring window.
+    qint64 batch = 1;
+    QElapsedTimer timer;
+    for (;;) {
+        timer.start();
+        for (qint64 i = 0; i < batch; ++i) {
+            op();
+        }
+        if (timer.nsecsElapsed() * 10 >= minTimeNs || batch >= (qint64(1) << 30)) {
+            break;
+        }
+        batch *= 2;
+    }
+
+    qint64 iterations = 0;
+    qint64 elapsedNs = 0;
+    const AllocationScope allocations;
+    timer.start();
+    while (elapsedNs < minTimeNs) {
+        for (qint64 i = 0; i < batch; ++i) {
+            op();
+        }
+        iterations += batch;
+        elapsedNs = timer.nsecsElapsed();
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.nsPerOp = static_cast<double>(elapsedNs) / static_cast<double>(iterations);
+    result.allocsPerOp = static_cast<double>(allocations.count()) / static_cast<double>(iterations);
+    return result;
+}
+
+QString touchLine(const char *type, double x, double y) {
+    return QString("{\"type\":\"%1\",\"x\":%2,\"y\":%3}")
+        .arg(QLatin1String(type))
+        .arg(x, 0, 'f', 4)
+        .arg(y, 0, 'f', 4);
+}
+
+// One canned gesture: press near the center, sweep through every sector on the group ring,
+// move out into the letter ring, then lift.
+QVector<QString> cannedTouchLines() {
+    QVector<QString> lines;
+    lines.push_back(touchLine("touch_down", 0.5, 0.35));
+    for (int i = 0; i < 64; ++i) {
+        const double angle = (2.0 * M_PI * i) / 64.0;
+        lines.push_back(touchLine("touch_move", 0.5 + 0.2 * std::cos(angle), 0.5 + 0.2 * std::sin(angle)));
+    }
+    for (int i = 0; i < 32; ++i) {
+        const double angle = M_PI / 8.0 + (M_PI / 4.0) * (i / 32.0);
+        lines.push_back(touchLine("touch_move", 0.5 + 0.4 * std::cos(angle), 0.5 + 0.4 * std::sin(angle)));
+    }
+    lines.push_back(touchLine("touch_up", 0.5 + 0.4 * std::cos(M_PI / 4.0), 0.5 + 0.4 * std::sin(M_PI / 4.0)));
+    return lines;
+}
+
+// Recordings are the newline-delimited JSON messages the UI sends on radialkb.sock.
+QVector<QString> loadTouchLines(const QString &path) {
+    QVector<QString> lines;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream(stderr) << "radialkb_bench: cannot open recording " << path << "\n";
+        return lines;
+    }
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (!line.isEmpty()) {
+            lines.push_back(QString::fromUtf8(line));
+        }
+    }
+    return lines;
+}
+
+QVector<QPointF> arcPoints(int count, double radius) {
+    QVector<QPointF> points;
+    points.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const double angle = (2.0 * M_PI * i) / count;
+        points.push_back(QPointF(0.5 + radius * std::cos(angle), 0.5 + radius * std::sin(angle)));
+    }
+    return points;
+}
+
+QJsonObject toJson(const BenchResult &result) {
+    QJsonObject obj;
+    obj.insert("name", result.name);
+    obj.insert("iterations", result.iterations);
+    obj.insert("ns_per_op", result.nsPerOp);
+    obj.insert("allocs_per_op", result.allocsPerOp);
+    return obj;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("radialkb_bench");
+    Logging::init("BENCH");
+    Logging::setMinLevel(LogLevel::Error);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Engine hot-path microbenchmarks (JSON output).");
+    parser.addHelpOption();
+    QCommandLineOption minTimeOpt("min-time-ms", "Measuring window per benchmark.", "ms", "300");
+    QCommandLineOption filterOpt("filter", "Only run benchmarks whose name contains this.", "text");
+    QCommandLineOption outputOpt("output", "Write JSON here instead of stdout.", "file");
+    QCommandLineOption recordingOpt("recording", "Newline-delimited touch messages to replay.", "file");
+    parser.addOption(minTimeOpt);
+    parser.addOption(filterOpt);
+    parser.addOption(outputOpt);
+    parser.addOption(recordingOpt);
+    parser.process(app);
+
+    BenchOptions options;
+    options.minTimeMs = qMax<qint64>(10, parser.value(minTimeOpt).toLongLong());
+    options.filter = parser.value(filterOpt);
+    options.recordingPath = parser.value(recordingOpt);
+
+    QVector<BenchResult> results;
+    auto selected = [&options](const QString &name) {
+        return options.filter.isEmpty() || name.contains(options.filter);
+    };
+    auto nullCommit = [](const KeyAction &) {};
+
+    if (selected("router.handleMessage")) {
+        const QVector<QString> lines = options.recordingPath.isEmpty()
+            ? cannedTouchLines()
+            : loadTouchLines(options.recordingPath);
+        if (!lines.isEmpty()) {
+            QVector<QByteArray> utf8Lines;
+            for (const QString &line : lines) {
+                utf8Lines.push_back(line.toUtf8());
+            }
+            InputRouter router(nullCommit, std::make_unique<NullHapticsSink>());
+            int next = 0;
+            results.push_back(runBenchmark("router.handleMessage", options, [&]() {
+                keepAlive(router.handleMessageUtf8(utf8Lines.at(next)));
+                next = (next + 1) % utf8Lines.size();
+            }));
+        }
+    }
+
+    if (selected("layout.hitTest")) {
+        const RadialLayout layout(RadialLayoutConfig{8, 0.5, 0.5, M_PI / 2.0});
+        const QVector<QPointF> points = arcPoints(97, 0.35);
+        int next = 0;
+        results.push_back(runBenchmark("layout.hitTest", options, [&]() {
+            const QPointF &p = points.at(next);
+            const double angle = layout.angleForPoint(p.x(), p.y());
+            const int sector = layout.angleToSector(angle);
+            const int key = layout.angleToKeyIndex(angle, sector);
+            keepAlive(key);
+            next = (next + 1) % points.size();
+        }));
+    }
+
+    if (selected("layout.hitTestStatic")) {
+        const DefaultRadialLayout layout(kDefaultRadialTables);
+        const QVector<QPointF> points = arcPoints(97, 0.35);
+        int next = 0;
+        results.push_back(runBenchmark("layout.hitTestStatic", options, [&]() {
+            const QPointF &p = points.at(next);
+            const double angle = layout.angleForPoint(p.x(), p.y());
+            const int sector = layout.angleToSectorWithHysteresis(angle, -1, 0.0);
+            const int key = layout.angleToKeyIndexWithHysteresis(angle, sector, -1, 0.0);
+            keepAlive(key);
+            next = (next + 1) % points.size();
+        }));
+    }
+
+    if (selected("router.updateSelection")) {
+        InputRouter router(nullCommit, std::make_unique<NullHapticsSink>());
+        const QVector<QPointF> points = arcPoints(256, 0.38);
+        router.handleTouchDown(points.first().x(), points.first().y());
+        int next = 0;
+        results.push_back(runBenchmark("router.updateSelection", options, [&]() {
+            const QPointF &p = points.at(next);
+            router.handleTouchMove(p.x(), p.y());
+            next = (next + 1) % points.size();
+        }));
+    }
+
+    if (selected("autocorrect.finishWord")) {
+        // Worst case for the space commit path: a long unknown word, every tap aimed.
+        const DefaultRadialLayout layout(kDefaultRadialTables);
+        Autocorrector autocorrect(layout);
+        const QByteArray word("carefuly");
+        QVector<double> angles;
+        for (char ch : word) {
+            for (int sector = 0; sector < layout.sectors(); ++sector) {
+                for (int key = 0; key < layout.keyCount(sector); ++key) {
+                    if (layout.keyAction(sector, key).ch == ch) {
+                        const LayoutPoint anchor = layout.keyAnchor(sector, key);
+                        angles.push_back(layout.angleForPoint(anchor.x, anchor.y));
+                    }
+                }
+            }
+        }
+        results.push_back(runBenchmark("autocorrect.finishWord", options, [&]() {
+            for (int i = 0; i < word.size(); ++i) {
+                autocorrect.noteLetter(word.at(i), angles.at(i), true);
+            }
+            keepAlive(autocorrect.finishWord());
+        }));
+    }
+
+    if (selected("gesture.classify")) {
+        GestureRecognizer recognizer;
+        const TouchSample starts[] = {{0.5, 0.5, 1000}, {0.5, 0.5, 1000}, {0.5, 0.5, 1000}, {0.5, 0.5, 1000}};
+        const TouchSample ends[] = {{0.8, 0.5, 1100}, {0.2, 0.5, 1100}, {0.5, 0.8, 1100}, {0.52, 0.51, 1100}};
+        int next = 0;
+        results.push_back(runBenchmark("gesture.classify", options, [&]() {
+            recognizer.onTouchDown(starts[next]);
+            keepAlive(recognizer.onTouchUp(ends[next]));
+            next = (next + 1) & 3;
+        }));
+    }
+
+    if (selected("gesture.shape32")) {
+        // Touch-up cost of shape matching: a 40-sample check mark against 32 templates with
+        // the router's acceptance limit, so the early abandon behaves as in production.
+        PointCloudRecognizer shapes;
+        while (shapes.size() < 32) {
+            shapes.addBuiltInTemplates();
+        }
+        QVector<CloudPoint> stroke;
+        for (int i = 0; i < 40; ++i) {
+            const double t = i / 39.0;
+            stroke.push_back(t < 0.3 ? CloudPoint{0.3 + 0.4 * t, 0.5 + 0.4 * t}
+                                     : CloudPoint{0.42 + 0.4 * (t - 0.3), 0.62 - 0.46 * (t - 0.3)});
+        }
+        results.push_back(runBenchmark("gesture.shape32", options, [&]() {
+            keepAlive(shapes.recognize(stroke.constData(), stroke.size(), 1.4));
+        }));
+    }
+
+    if (selected("swipe.templates") || selected("swipe.decode")) {
+        const DefaultRadialLayout layout(kDefaultRadialTables);
+        const SwipeTemplateSource source = SwipeTemplateSource::capture(layout, Dictionary());
+        if (selected("swipe.templates")) {
+            // First-start cost of the built-in word list on all cores.
+            results.push_back(runBenchmark("swipe.templates", options, [&]() {
+                keepAlive(SwipeTemplateSet::build(source));
+            }));
+        }
+        if (selected("swipe.decode")) {
+            // Lift-time cost: a 60-sample swipe of "there" against every built-in word.
+            const std::shared_ptr<const SwipeTemplateSet> templates = SwipeTemplateSet::build(source);
+            SwipePath path;
+            const QByteArray word("there");
+            for (int i = 0; i + 1 < word.size(); ++i) {
+                const LayoutPoint from = source.anchors[word.at(i) - 'a'];
+                const LayoutPoint to = source.anchors[word.at(i + 1) - 'a'];
+                for (int step = 0; step < 15; ++step) {
+                    const double t = step / 15.0;
+                    path.addPoint(QPointF(from.x + (to.x - from.x) * t, from.y + (to.y - from.y) * t));
+                }
+            }
+            const SwipeDecoderConfig config;
+            float points[SwipeTemplateSet::kPoints * 2];
+            results.push_back(runBenchmark("swipe.decode", options, [&]() {
+                path.resample(points, SwipeTemplateSet::kPoints);
+                keepAlive(SwipeDecoder::decode(*templates, points, 3, config));
+            }));
+        }
+    }
+
+    if (selected("uinput.sendText")) {
+        const int nullFd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+        if (nullFd >= 0) {
+            UInputKeyboard keyboard(nullFd);
+            const QString word = QStringLiteral("radial");
+            results.push_back(runBenchmark("uinput.sendText", options, [&]() {
+                keyboard.sendText(word);
+            }));
+        }
+    }
+
+    QJsonArray resultArray;
+    QTextStream err(stderr);
+    for (const BenchResult &result : results) {
+        resultArray.append(toJson(result));
+        err << QString("%1 %2 ns/op %3 allocs/op\n")
+                   .arg(result.name, -28)
+                   .arg(result.nsPerOp, 10, 'f', 1)
+                   .arg(result.allocsPerOp, 8, 'f', 2);
+    }
+
+    QJsonObject report;
+    report.insert("tool", "radialkb_bench");
+    report.insert("timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    report.insert("host", QSysInfo::machineHostName());
+    report.insert("cpu_arch", QSysInfo::currentCpuArchitecture());
+    report.insert("qt_version", QString::fromLatin1(qVersion()));
+    report.insert("min_time_ms", options.minTimeMs);
+    report.insert("results", resultArray);
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    const QString outputPath = parser.value(outputOpt);
+    if (outputPath.isEmpty()) {
+        QTextStream(stdout) << json;
+        return 0;
+    }
+    QFile out(outputPath);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        err << "radialkb_bench: cannot write " << outputPath << "\n";
+        return 1;
+    }
+    out.write(json);
+    return 0;
+}
@@ -0,0 +1,389 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QVector>
+#include <QtMath>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+
+#include "AllocCounter.h"
+#include "../src/engine/HapticsSink.h"
+#include "../src/engine/InputRouter.h"
+#include "../src/engine/Logging.h"
+
+// Drives InputRouter in-process with synthetic gestures at a configurable event rate and
+// reports throughput, tail latency and heap allocations per event. Intended to run for
+// minutes unattended; --baseline turns it into a regression check (exit code 3).
+
+using namespace radialkb;
+
+namespace {
+
+enum class GestureKind { Arc, RingTransition, Swipe, Cancel, Count };
+
+const char *gestureKindName(GestureKind kind) {
+    switch (kind) {
+    case GestureKind::Arc:
+        return "arc";
+    case GestureKind::RingTransition:
+        return "ring_transition";
+    case GestureKind::Swipe:
+        return "swipe";
+    case GestureKind::Cancel:
+        return "cancel";
+    case GestureKind::Count:
+        break;
+    }
+    return "unknown";
+}
+
+QByteArray touchLine(const char *type, double x, double y) {
+    return QString("{\"type\":\"%1\",\"x\":%2,\"y\":%3}")
+        .arg(QLatin1String(type))
+        .arg(qBound(0.0, x, 1.0), 0, 'f', 4)
+        .arg(qBound(0.0, y, 1.0), 0, 'f', 4)
+        .toUtf8();
+}
+
+// Produces the message lines for one realistic gesture.
+class GestureGenerator {
+public:
+    explicit GestureGenerator(quint32 seed) : m_rng(seed) {}
+
+    GestureKind next(QVector<QByteArray> &lines) {
+        lines.clear();
+        const double roll = uniform(0.0, 1.0);
+        GestureKind kind = GestureKind::Arc;
+        if (roll < 0.40) {
+            kind = GestureKind::Arc;
+            arc(lines);
+        } else if (roll < 0.75) {
+            kind = GestureKind::RingTransition;
+            ringTransition(lines);
+        } else if (roll < 0.92) {
+            kind = GestureKind::Swipe;
+            swipe(lines);
+        } else {
+            kind = GestureKind::Cancel;
+            cancel(lines);
+        }
+        return kind;
+    }
+
+private:
+    double uniform(double lo, double hi) {
+        return std::uniform_real_distribution<double>(lo, hi)(m_rng);
+    }
+
+    double jitter() { return std::normal_distribution<double>(0.0, 0.003)(m_rng); }
+
+    void polar(QVector<QByteArray> &lines, const char *type, double angle, double radius) {
+        lines.push_back(touchLine(type, 0.5 + radius * std::cos(angle) + jitter(),
+                                  0.5 + radius * std::sin(angle) + jitter()));
+    }
+
+    // Sweep through one to four sectors on the group ring, then lift to commit.
+    void arc(QVector<QByteArray> &lines) {
+        const double start = uniform(0.0, 2.0 * M_PI);
+        const double span = uniform(M_PI / 4.0, M_PI) * (uniform(0.0, 1.0) < 0.5 ? -1.0 : 1.0);
+        const double radius = uniform(0.16, 0.24);
+        const int steps = static_cast<int>(uniform(20.0, 80.0));
+        polar(lines, "touch_down", start, radius);
+        for (int i = 1; i <= steps; ++i) {
+            polar(lines, "touch_move", start + span * i / steps, radius);
+        }
+        polar(lines, "touch_up", start + span, radius);
+    }
+
+    // Pick a group, slide out into the letter ring, wander across keys, lift.
+    void ringTransition(QVector<QByteArray> &lines) {
+        const double angle = uniform(0.0, 2.0 * M_PI);
+        const int outSteps = static_cast<int>(uniform(10.0, 30.0));
+        const int wanderSteps = static_cast<int>(uniform(10.0, 60.0));
+        const double wander = uniform(-M_PI / 8.0, M_PI / 8.0);
+        polar(lines, "touch_down", angle, 0.18);
+        for (int i = 1; i <= outSteps; ++i) {
+            polar(lines, "touch_move", angle, 0.18 + 0.2 * i / outSteps);
+        }
+        for (int i = 1; i <= wanderSteps; ++i) {
+            polar(lines, "touch_move", angle + wander * i / wanderSteps, 0.38);
+        }
+        polar(lines, "touch_up", angle + wander, 0.38);
+    }
+
+    // Short, fast straight stroke left or right (backspace/space).
+    void swipe(QVector<QByteArray> &lines) {
+        const double dir = uniform(0.0, 1.0) < 0.5 ? -1.0 : 1.0;
+        const double y = uniform(0.4, 0.6);
+        const int steps = static_cast<int>(uniform(4.0, 12.0));
+        lines.push_back(touchLine("touch_down", 0.5 - dir * 0.15, y));
+        for (int i = 1; i <= steps; ++i) {
+            lines.push_back(touchLine("touch_move", 0.5 - dir * 0.15 + dir * 0.3 * i / steps, y + jitter()));
+        }
+        lines.push_back(touchLine("touch_up", 0.5 + dir * 0.15, y));
+    }
+
+    // Either a downward swipe or an explicit cancel action mid-selection.
+    void cancel(QVector<QByteArray> &lines) {
+        const double x = uniform(0.4, 0.6);
+        lines.push_back(touchLine("touch_down", x, 0.3));
+        const int steps = static_cast<int>(uniform(4.0, 10.0));
+        for (int i = 1; i <= steps; ++i) {
+            lines.push_back(touchLine("touch_move", x + jitter(), 0.3 + 0.4 * i / steps));
+        }
+        if (uniform(0.0, 1.0) < 0.5) {
+            lines.push_back(QByteArrayLiteral("{\"type\":\"action\",\"action\":\"cancel\"}"));
+        }
+        lines.push_back(touchLine("touch_up", x, 0.7));
+    }
+
+    std::mt19937 m_rng;
+};
+
+// Fixed-memory latency histogram: 50 ns buckets up to 1 ms, 10 us buckets up to 100 ms.
+class LatencyHistogram {
+public:
+    LatencyHistogram() : m_buckets(kFineBuckets + kCoarseBuckets + 1, 0) {}
+
+    void record(qint64 ns) {
+        ++m_count;
+        m_maxNs = qMax(m_maxNs, ns);
+        m_buckets[bucketFor(ns)] += 1;
+    }
+
+    qint64 count() const { return m_count; }
+    qint64 maxNs() const { return m_maxNs; }
+
+    qint64 percentileNs(double p) const {
+        if (m_count == 0) {
+            return 0;
+        }
+        const qint64 rank = qMax<qint64>(1, static_cast<qint64>(std::ceil(p * m_count)));
+        qint64 seen = 0;
+        for (int i = 0; i < m_buckets.size(); ++i) {
+            seen += m_buckets.at(i);
+            if (seen >= rank) {
+                return qMin(upperBoundNs(i), m_maxNs);
+            }
+        }
+        return m_maxNs;
+    }
+
+private:
+    static constexpr int kFineBuckets = 20000;   // 50 ns * 20000 = 1 ms
+    static constexpr int kCoarseBuckets = 9900;  // 10 us * 9900 = 99 ms
+    static constexpr qint64 kFineNs = 50;
+    static constexpr qint64 kCoarseNs = 10000;
+    static constexpr qint64 kFineLimitNs = kFineNs * kFineBuckets;
+
+    static int bucketFor(qint64 ns) {
+        if (ns < kFineLimitNs) {
+            return static_cast<int>(ns / kFineNs);
+        }
+        const qint64 coarse = (ns - kFineLimitNs) / kCoarseNs;
+        return kFineBuckets + static_cast<int>(qMin<qint64>(coarse, kCoarseBuckets));
+    }
+
+    static qint64 upperBoundNs(int bucket) {
+        if (bucket < kFineBuckets) {
+            return (bucket + 1) * kFineNs;
+        }
+        return kFineLimitNs + (bucket - kFineBuckets + 1) * kCoarseNs;
+    }
+
+    QVector<qint64> m_buckets;
+    qint64 m_count = 0;
+    qint64 m_maxNs = 0;
+};
+
+struct Regression {
+    QString metric;
+    double baseline;
+    double current;
+};
+
+// Lower is better for every compared metric except capacity.
+void compareMetric(const QJsonObject &baseline, const QJsonObject &current, const QString &key,
+                   double tolerance, bool higherIsBetter, QVector<Regression> &out) {
+    if (!baseline.contains(key)) {
+        return;
+    }
+    const double base = baseline.value(key).toDouble();
+    const double now = current.value(key).toDouble();
+    // Allocation counts start at zero; allow a small absolute slack there.
+    const double slack = (key == "allocs_per_event") ? 0.01 : 0.0;
+    const bool worse = higherIsBetter ? (now < base * (1.0 - tolerance))
+                                      : (now > base * (1.0 + tolerance) + slack);
+    if (worse) {
+        out.push_back({key, base, now});
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("radialkb_stress");
+    Logging::init("STRESS");
+    Logging::setMinLevel(LogLevel::Error);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Synthetic high-rate gesture stress test for InputRouter.");
+    parser.addHelpOption();
+    QCommandLineOption rateOpt("rate", "Input events per second (0 = as fast as possible).", "hz", "1000");
+    QCommandLineOption durationOpt("duration", "Run time in seconds.", "s", "60");
+    QCommandLineOption seedOpt("seed", "Random seed for the gesture generator.", "n", "1");
+    QCommandLineOption baselineOpt("baseline", "Compare against this report; exit 3 on regression.", "file");
+    QCommandLineOption toleranceOpt("tolerance", "Allowed relative slowdown vs. baseline.", "fraction", "0.25");
+    QCommandLineOption writeBaselineOpt("write-baseline", "Save this run's report as a baseline.", "file");
+    QCommandLineOption progressOpt("progress", "Seconds between progress lines on stderr (0 = off).", "s", "10");
+    parser.addOption(rateOpt);
+    parser.addOption(durationOpt);
+    parser.addOption(seedOpt);
+    parser.addOption(baselineOpt);
+    parser.addOption(toleranceOpt);
+    parser.addOption(writeBaselineOpt);
+    parser.addOption(progressOpt);
+    parser.process(app);
+
+    const double rateHz = qMax(0.0, parser.value(rateOpt).toDouble());
+    const double durationS = qMax(1.0, parser.value(durationOpt).toDouble());
+    const double tolerance = qMax(0.0, parser.value(toleranceOpt).toDouble());
+    const qint64 progressNs = static_cast<qint64>(parser.value(progressOpt).toDouble() * 1e9);
+
+    std::atomic<qint64> commits{0};
+    InputRouter router([&commits](const KeyAction &) { commits.fetch_add(1, std::memory_order_relaxed); },
+                       std::make_unique<NullHapticsSink>());
+    GestureGenerator generator(parser.value(seedOpt).toUInt());
+    LatencyHistogram latency;
+
+    qint64 gestureCounts[static_cast<int>(GestureKind::Count)] = {};
+    qint64 allocations = 0;
+    qint64 busyNs = 0;
+    qint64 lateEvents = 0;
+    QVector<QByteArray> lines;
+    lines.reserve(128);
+
+    using Clock = std::chrono::steady_clock;
+    const auto period = rateHz > 0.0
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rateHz))
+        : Clock::duration::zero();
+    const qint64 durationNs = static_cast<qint64>(durationS * 1e9);
+    auto nextDue = Clock::now();
+
+    QElapsedTimer wall;
+    QElapsedTimer opTimer;
+    wall.start();
+    qint64 nextProgressNs = progressNs;
+    QTextStream err(stderr);
+
+    while (wall.nsecsElapsed() < durationNs) {
+        const GestureKind kind = generator.next(lines);
+        ++gestureCounts[static_cast<int>(kind)];
+        for (const QByteArray &line : lines) {
+            if (period != Clock::duration::zero()) {
+                const auto now = Clock::now();
+                if (now < nextDue) {
+                    std::this_thread::sleep_until(nextDue);
+                } else if (now - nextDue > period) {
+                    ++lateEvents;
+                }
+                nextDue += period;
+            }
+            const AllocationScope scope;
+            opTimer.start();
+            const QByteArray reply = router.handleMessageUtf8(line);
+            const qint64 ns = opTimer.nsecsElapsed();
+            Q_UNUSED(reply);
+            allocations += static_cast<qint64>(scope.count());
+            busyNs += ns;
+            latency.record(ns);
+        }
+        if (progressNs > 0 && wall.nsecsElapsed() >= nextProgressNs) {
+            nextProgressNs += progressNs;
+            err << QString("[%1 s] events=%2 p99=%3 ns allocs/event=%4\n")
+                       .arg(wall.elapsed() / 1000)
+                       .arg(latency.count())
+                       .arg(latency.percentileNs(0.99))
+                       .arg(static_cast<double>(allocations) / qMax<qint64>(1, latency.count()), 0, 'f', 2);
+            err.flush();
+        }
+    }
+    const double wallS = wall.nsecsElapsed() / 1e9;
+    const qint64 events = latency.count();
+
+    QJsonObject gestures;
+    for (int i = 0; i < static_cast<int>(GestureKind::Count); ++i) {
+        gestures.insert(gestureKindName(static_cast<GestureKind>(i)), gestureCounts[i]);
+    }
+    QJsonObject report;
+    report.insert("tool", "radialkb_stress");
+    report.insert("timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    report.insert("rate_hz", rateHz);
+    report.insert("duration_s", wallS);
+    report.insert("events", events);
+    report.insert("late_events", lateEvents);
+    report.insert("commits", commits.load());
+    report.insert("gestures", gestures);
+    report.insert("throughput_eps", events / wallS);
+    report.insert("capacity_eps", busyNs > 0 ? events / (busyNs / 1e9) : 0.0);
+    report.insert("latency_p50_ns", latency.percentileNs(0.50));
+    report.insert("latency_p99_ns", latency.percentileNs(0.99));
+    report.insert("latency_p999_ns", latency.percentileNs(0.999));
+    report.insert("latency_max_ns", latency.maxNs());
+    report.insert("allocs_per_event", static_cast<double>(allocations) / qMax<qint64>(1, events));
+
+    int exitCode = 0;
+    const QString baselinePath = parser.value(baselineOpt);
+    if (!baselinePath.isEmpty()) {
+        QFile file(baselinePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << "radialkb_stress: cannot read baseline " << baselinePath << "\n";
+            return 1;
+        }
+        const QJsonObject baseline = QJsonDocument::fromJson(file.readAll()).object();
+        QVector<Regression> regressions;
+        compareMetric(baseline, report, "latency_p99_ns", tolerance, false, regressions);
+        compareMetric(baseline, report, "latency_p999_ns", tolerance, false, regressions);
+        compareMetric(baseline, report, "allocs_per_event", tolerance, false, regressions);
+        compareMetric(baseline, report, "capacity_eps", tolerance, true, regressions);
+        QJsonArray flagged;
+        for (const Regression &r : regressions) {
+            QJsonObject obj;
+            obj.insert("metric", r.metric);
+            obj.insert("baseline", r.baseline);
+            obj.insert("current", r.current);
+            flagged.append(obj);
+            err << QString("REGRESSION %1: baseline=%2 current=%3\n").arg(r.metric).arg(r.baseline).arg(r.current);
+        }
+        report.insert("regressions", flagged);
+        if (!regressions.isEmpty()) {
+            exitCode = 3;
+        }
+    }
+
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    QTextStream(stdout) << json;
+
+    const QString writeBaselinePath = parser.value(writeBaselineOpt);
+    if (!writeBaselinePath.isEmpty()) {
+        QFile out(writeBaselinePath);
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err << "radialkb_stress: cannot write baseline " << writeBaselinePath << "\n";
+            return 1;
+        }
+        out.write(json);
+    }
+    return exitCode;
+}
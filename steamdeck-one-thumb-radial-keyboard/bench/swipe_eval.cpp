@@ -0,0 +1,394 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QVector>
+#include <QtMath>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../src/engine/Dictionary.h"
+#include "../src/engine/Logging.h"
+#include "../src/engine/RadialLayout.h"
+#include "../src/core/StaticRadialLayout.h"
+#include "../src/engine/swipe/SwipeDecoder.h"
+
+// Offline accuracy and latency evaluation of the swipe decoder. Every trace of a corpus goes
+// through the production conditioning (SwipePath) and decoding (SwipeDecoder) on a pool of
+// worker threads; the JSON report carries top-1/top-3 accuracy, the per-trace latency
+// distribution and the most frequent confusions, together with the settings that produced
+// them, so two runs with different thresholds, layouts or weights can be diffed directly.
+
+using namespace radialkb;
+
+namespace {
+
+struct Trace {
+    QByteArray word;
+    // (x, y, dtMs) triples, the touch_batch layout; dt is carried but not used by the decoder.
+    QVector<double> points;
+};
+
+struct TraceResult {
+    // Position of the intended word in the candidate list, or -1.
+    int rank = -1;
+    QByteArray decoded;
+    // Top score minus the intended word's score, when it was among the candidates.
+    double gap = 0.0;
+    qint64 latencyNs = 0;
+};
+
+// One JSON object per line: {"word":"there","points":[x0,y0,dt0,x1,y1,dt1,...]}.
+bool loadCorpus(const QString &path, QVector<Trace> &out, QTextStream &err) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        err << "radialkb_swipe_eval: cannot open corpus " << path << "\n";
+        return false;
+    }
+    int lineNumber = 0;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        const QJsonObject obj = QJsonDocument::fromJson(line).object();
+        const QJsonArray values = obj.value("points").toArray();
+        Trace trace;
+        trace.word = obj.value("word").toString().toLower().toLatin1();
+        if (trace.word.isEmpty() || values.size() < 3) {
+            err << QString("radialkb_swipe_eval: skipping %1:%2\n").arg(path).arg(lineNumber);
+            continue;
+        }
+        trace.points.reserve(values.size());
+        for (const QJsonValue &value : values) {
+            trace.points.push_back(value.toDouble());
+        }
+        out.push_back(trace);
+    }
+    return true;
+}
+
+// Noisy swipes over the layout's anchors: every letter is aimed with Gaussian error and the
+// thumb moves between letters in evenly timed samples with a little jitter. Words are drawn by
+// their prior, so the mix resembles real text.
+QVector<Trace> syntheticCorpus(const SwipeTemplateSource &source, int count, double noise, quint32 seed) {
+    QVector<QByteArray> words;
+    QVector<double> weights;
+    for (int length = 2; length <= Dictionary::kMaxWordLength; ++length) {
+        const Dictionary::Bucket &bucket = source.dictionary.wordsOfLength(length);
+        for (int index = 0; index < bucket.size(); ++index) {
+            const char *word = bucket.word(index);
+            if (!std::all_of(word, word + length, [&](char ch) { return source.onLayout[ch - 'a']; })) {
+                continue;
+            }
+            words.push_back(QByteArray(word, length));
+            weights.push_back(std::exp(bucket.logPrior.at(index)));
+        }
+    }
+    QVector<Trace> corpus;
+    if (words.isEmpty()) {
+        return corpus;
+    }
+    std::mt19937 rng(seed);
+    std::discrete_distribution<int> pick(weights.cbegin(), weights.cend());
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    constexpr int kSamplesPerLetter = 8;
+    constexpr double kSampleMs = 8.0;
+    corpus.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Trace trace;
+        trace.word = words.at(pick(rng));
+        QVector<LayoutPoint> aims;
+        for (char ch : trace.word) {
+            const LayoutPoint anchor = source.anchors[ch - 'a'];
+            aims.push_back(LayoutPoint{anchor.x + noise * gauss(rng), anchor.y + noise * gauss(rng)});
+        }
+        for (int letter = 0; letter + 1 < aims.size(); ++letter) {
+            const LayoutPoint from = aims.at(letter);
+            const LayoutPoint to = aims.at(letter + 1);
+            for (int step = 0; step < kSamplesPerLetter; ++step) {
+                const double t = static_cast<double>(step) / kSamplesPerLetter;
+                trace.points << from.x + (to.x - from.x) * t + 0.1 * noise * gauss(rng)
+                             << from.y + (to.y - from.y) * t + 0.1 * noise * gauss(rng) << kSampleMs;
+            }
+        }
+        trace.points << aims.last().x << aims.last().y << kSampleMs;
+        corpus.push_back(trace);
+    }
+    return corpus;
+}
+
+qint64 percentile(const QVector<qint64> &sorted, double p) {
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+    const int rank = qMax(1, static_cast<int>(std::ceil(p * sorted.size())));
+    return sorted.at(qMin<qsizetype>(rank, sorted.size()) - 1);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("radialkb_swipe_eval");
+    Logging::init("EVAL");
+    Logging::setMinLevel(LogLevel::Error);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Swipe decoder accuracy and latency evaluation.");
+    parser.addHelpOption();
+    QCommandLineOption corpusOpt("corpus", "Traces to decode, one JSON object per line.", "file");
+    QCommandLineOption syntheticOpt("synthetic", "Generate this many noisy traces instead of reading a corpus.", "n", "0");
+    QCommandLineOption noiseOpt("noise", "Aiming error of synthetic traces, in pad units.", "d", "0.03");
+    QCommandLineOption seedOpt("seed", "Random seed for synthetic traces.", "n", "1");
+    QCommandLineOption dictionaryOpt("dictionary", "Word list (default: built-in words).", "file");
+    QCommandLineOption sectorsOpt("sectors", "Use the runtime RadialLayout with this many sectors.", "n", "0");
+    QCommandLineOption sigmaOpt("sigma", "SwipeDecoderConfig::sigma.", "d");
+    QCommandLineOption priorOpt("prior-weight", "SwipeDecoderConfig::priorWeight.", "w");
+    QCommandLineOption radiusOpt("endpoint-radius", "SwipeDecoderConfig::endpointRadius.", "d");
+    QCommandLineOption smoothingOpt("smoothing", "SwipePathConfig::smoothing.", "a");
+    QCommandLineOption minStepOpt("min-step", "SwipePathConfig::minStep.", "d");
+    QCommandLineOption threadsOpt("threads", "Worker threads (0 = one per core).", "n", "0");
+    QCommandLineOption confusionsOpt("confusions", "Confusions to list.", "n", "20");
+    QCommandLineOption outputOpt("output", "Also write the report to this file.", "file");
+    parser.addOptions({corpusOpt, syntheticOpt, noiseOpt, seedOpt, dictionaryOpt, sectorsOpt, sigmaOpt, priorOpt,
+                       radiusOpt, smoothingOpt, minStepOpt, threadsOpt, confusionsOpt, outputOpt});
+    parser.process(app);
+    QTextStream err(stderr);
+
+    SwipeDecoderConfig decoderConfig;
+    if (parser.isSet(sigmaOpt)) {
+        decoderConfig.sigma = parser.value(sigmaOpt).toDouble();
+    }
+    if (parser.isSet(priorOpt)) {
+        decoderConfig.priorWeight = parser.value(priorOpt).toDouble();
+    }
+    if (parser.isSet(radiusOpt)) {
+        decoderConfig.endpointRadius = parser.value(radiusOpt).toDouble();
+    }
+    SwipePathConfig pathConfig;
+    if (parser.isSet(smoothingOpt)) {
+        pathConfig.smoothing = parser.value(smoothingOpt).toDouble();
+    }
+    if (parser.isSet(minStepOpt)) {
+        pathConfig.minStep = parser.value(minStepOpt).toDouble();
+    }
+
+    Dictionary dictionary;
+    const QString dictionaryPath = parser.value(dictionaryOpt);
+    if (!dictionaryPath.isEmpty() && !dictionary.load(dictionaryPath)) {
+        err << "radialkb_swipe_eval: cannot load dictionary " << dictionaryPath << "\n";
+        return 1;
+    }
+    const int sectors = parser.value(sectorsOpt).toInt();
+    std::unique_ptr<RadialHitTester> layout;
+    if (sectors > 0) {
+        RadialLayoutConfig layoutConfig;
+        layoutConfig.sectors = sectors;
+        layoutConfig.angleOffsetRad = M_PI / 2.0;
+        layout = std::make_unique<RadialLayout>(layoutConfig);
+    } else {
+        layout = std::make_unique<DefaultRadialLayout>(kDefaultRadialTables);
+    }
+
+    QElapsedTimer buildTimer;
+    buildTimer.start();
+    const SwipeTemplateSource source = SwipeTemplateSource::capture(*layout, dictionary);
+    const std::shared_ptr<const SwipeTemplateSet> templates = SwipeTemplateSet::build(source);
+    const qint64 buildMs = buildTimer.elapsed();
+
+    QVector<Trace> corpus;
+    const int synthetic = parser.value(syntheticOpt).toInt();
+    if (synthetic > 0) {
+        corpus = syntheticCorpus(source, synthetic, parser.value(noiseOpt).toDouble(), parser.value(seedOpt).toUInt());
+    } else if (!parser.isSet(corpusOpt)) {
+        err << "radialkb_swipe_eval: pass --corpus or --synthetic\n";
+        return 1;
+    } else if (!loadCorpus(parser.value(corpusOpt), corpus, err)) {
+        return 1;
+    }
+    if (corpus.isEmpty()) {
+        err << "radialkb_swipe_eval: no traces\n";
+        return 1;
+    }
+    QHash<QByteArray, int> vocabulary;
+    for (int i = 0; i < templates->size(); ++i) {
+        vocabulary.insert(templates->word(i), i);
+    }
+
+    // Workers claim traces from a shared counter and fill their own result slots.
+    QVector<TraceResult> results(corpus.size());
+    TraceResult *const slots = results.data();
+    std::atomic<int> next{0};
+    auto work = [&]() {
+        float points[SwipeTemplateSet::kPoints * 2];
+        for (int index = next.fetch_add(1); index < corpus.size(); index = next.fetch_add(1)) {
+            const Trace &trace = corpus.at(index);
+            TraceResult &result = slots[index];
+            const auto start = std::chrono::steady_clock::now();
+            SwipePath path(pathConfig);
+            for (int i = 0; i + 2 < trace.points.size(); i += 3) {
+                path.addPoint(QPointF(trace.points.at(i), trace.points.at(i + 1)));
+            }
+            QVector<SwipeCandidate> candidates;
+            if (path.resample(points, SwipeTemplateSet::kPoints)) {
+                candidates = SwipeDecoder::decode(*templates, points, SwipeDecoder::kMaxCandidates, decoderConfig);
+            }
+            result.latencyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+            if (!candidates.isEmpty()) {
+                result.decoded = candidates.constFirst().word;
+            }
+            for (int rank = 0; rank < candidates.size(); ++rank) {
+                if (candidates.at(rank).word == trace.word) {
+                    result.rank = rank;
+                    result.gap = candidates.constFirst().score - candidates.at(rank).score;
+                    break;
+                }
+            }
+        }
+    };
+    int threads = parser.value(threadsOpt).toInt();
+    if (threads <= 0) {
+        threads = qMax(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    threads = qMin<int>(threads, corpus.size());
+    QElapsedTimer wall;
+    wall.start();
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+    const qint64 wallMs = wall.elapsed();
+
+    struct Confusion {
+        QByteArray expected;
+        QByteArray decoded;
+        int count = 0;
+        // Only traces whose intended word was still a candidate have a gap.
+        int ranked = 0;
+        double gapSum = 0.0;
+    };
+    QHash<QByteArray, Confusion> confusions;
+    int top1 = 0;
+    int top3 = 0;
+    int outOfVocabulary = 0;
+    QVector<qint64> latencies;
+    latencies.reserve(results.size());
+    for (int index = 0; index < results.size(); ++index) {
+        const TraceResult &result = results.at(index);
+        const QByteArray &word = corpus.at(index).word;
+        latencies.push_back(result.latencyNs);
+        top1 += result.rank == 0 ? 1 : 0;
+        top3 += result.rank >= 0 && result.rank < 3 ? 1 : 0;
+        outOfVocabulary += vocabulary.contains(word) ? 0 : 1;
+        if (result.rank != 0) {
+            Confusion &confusion = confusions[word + ' ' + result.decoded];
+            confusion.expected = word;
+            confusion.decoded = result.decoded;
+            ++confusion.count;
+            if (result.rank > 0) {
+                ++confusion.ranked;
+                confusion.gapSum += result.gap;
+            }
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+    QVector<Confusion> worst = confusions.values();
+    std::sort(worst.begin(), worst.end(), [](const Confusion &a, const Confusion &b) {
+        if (a.count != b.count) {
+            return a.count > b.count;
+        }
+        return a.expected + a.decoded < b.expected + b.decoded;
+    });
+    QJsonArray confusionArray;
+    const int listed = qMin<int>(worst.size(), qMax(0, parser.value(confusionsOpt).toInt()));
+    for (int i = 0; i < listed; ++i) {
+        const Confusion &confusion = worst.at(i);
+        QJsonObject entry;
+        entry.insert("expected", QString::fromLatin1(confusion.expected));
+        entry.insert("decoded", QString::fromLatin1(confusion.decoded));
+        entry.insert("count", confusion.count);
+        // How often the intended word was still among the candidates, and by how much it lost.
+        entry.insert("in_candidates", confusion.ranked);
+        if (confusion.ranked > 0) {
+            entry.insert("mean_score_gap", confusion.gapSum / confusion.ranked);
+        }
+        confusionArray.append(entry);
+    }
+
+    const int traces = corpus.size();
+    QJsonObject config;
+    config.insert("layout", sectors > 0 ? QString("radial%1").arg(sectors) : QString("default"));
+    config.insert("dictionary", dictionaryPath.isEmpty() ? QString("builtin") : dictionaryPath);
+    config.insert("templates", templates->size());
+    config.insert("template_points", SwipeTemplateSet::kPoints);
+    config.insert("sigma", decoderConfig.sigma);
+    config.insert("prior_weight", decoderConfig.priorWeight);
+    config.insert("endpoint_radius", decoderConfig.endpointRadius);
+    config.insert("smoothing", pathConfig.smoothing);
+    config.insert("min_step", pathConfig.minStep);
+    if (synthetic > 0) {
+        config.insert("synthetic_noise", parser.value(noiseOpt).toDouble());
+        config.insert("synthetic_seed", parser.value(seedOpt).toInt());
+    } else {
+        config.insert("corpus", parser.value(corpusOpt));
+    }
+
+    QJsonObject report;
+    report.insert("tool", "radialkb_swipe_eval");
+    report.insert("timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    report.insert("config", config);
+    report.insert("threads", threads);
+    report.insert("traces", traces);
+    report.insert("out_of_vocabulary", outOfVocabulary);
+    report.insert("top1", static_cast<double>(top1) / traces);
+    report.insert("top3", static_cast<double>(top3) / traces);
+    report.insert("template_build_ms", buildMs);
+    report.insert("wall_ms", wallMs);
+    report.insert("latency_p50_ns", percentile(latencies, 0.50));
+    report.insert("latency_p90_ns", percentile(latencies, 0.90));
+    report.insert("latency_p99_ns", percentile(latencies, 0.99));
+    report.insert("latency_max_ns", latencies.constLast());
+    report.insert("confusions", confusionArray);
+
+    err << QString("top1 %1%  top3 %2%  p50 %3 us  p99 %4 us  (%5 traces, %6 threads)\n")
+               .arg(100.0 * top1 / traces, 0, 'f', 1)
+               .arg(100.0 * top3 / traces, 0, 'f', 1)
+               .arg(percentile(latencies, 0.50) / 1000.0, 0, 'f', 1)
+               .arg(percentile(latencies, 0.99) / 1000.0, 0, 'f', 1)
+               .arg(traces)
+               .arg(threads);
+
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    QTextStream(stdout) << json;
+    const QString outputPath = parser.value(outputOpt);
+    if (!outputPath.isEmpty()) {
+        QFile out(outputPath);
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err << "radialkb_swipe_eval: cannot write " << outputPath << "\n";
+            return 1;
+        }
+        out.write(json);
+    }
+    return 0;
+}
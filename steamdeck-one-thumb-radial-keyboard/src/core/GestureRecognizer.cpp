@@ -25,6 +25,9 @@ SwipeDir GestureRecognizer::onTouchUp(const TouchSample &sample) {
         return SwipeDir::None;
     }
     m_active = false;
+    m_last.distance = std::hypot(sample.x - m_start.x, sample.y - m_start.y);
+    m_last.durationMs = static_cast<double>(sample.timestampMs - m_start.timestampMs);
+    m_last.velocity = m_last.durationMs > 0.0 ? m_last.distance / m_last.durationMs : 0.0;
     return classifySwipe(sample, true);
 }
 
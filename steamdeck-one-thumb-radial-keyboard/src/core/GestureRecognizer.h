@@ -12,6 +12,13 @@ struct GestureThresholds {
     double minVelocityNormPerMs = 0.0009;
 };
 
+// Net movement of one touch from down to up; what the swipe gates look at.
+struct GestureFeatures {
+    double distance = 0.0;
+    double durationMs = 0.0;
+    double velocity = 0.0;
+};
+
 struct TouchSample {
     double x = 0.0;
     double y = 0.0;
@@ -27,12 +34,17 @@ public:
     SwipeDir onTouchUp(const TouchSample &sample);
 
     const GestureThresholds &thresholds() const;
+    // Applies from the next touch down; call between gestures.
+    void setThresholds(const GestureThresholds &thresholds) { m_thresholds = thresholds; }
+    // Features of the touch ended by the last onTouchUp().
+    const GestureFeatures &lastGesture() const { return m_last; }
 
 private:
     SwipeDir classifySwipe(const TouchSample &sample, bool enforceDuration) const;
 
     GestureThresholds m_thresholds;
     TouchSample m_start;
+    GestureFeatures m_last;
     bool m_active{false};
 };
 
@@ -0,0 +1,231 @@
+#include "GestureTuner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace radialkb {
+
+namespace {
+
+constexpr char kTunerMagic[4] = {'R', 'K', 'G', 'T'};
+constexpr std::uint32_t kTunerVersion = 1;
+
+enum Feature { LogDistance, LogDuration, LogVelocity };
+
+// Log scale: all three are positive and right-skewed. Near-zero taps are floored so a tap
+// that never moved does not drag the tap mean to minus infinity.
+std::array<double, 3> featureVector(const GestureFeatures &features) {
+    return {std::log(std::max(features.distance, 1e-3)), std::log(std::max(features.durationMs, 1.0)),
+            std::log(std::max(features.velocity, 1e-6))};
+}
+
+bool usable(const GestureFeatures &features) {
+    return std::isfinite(features.distance) && std::isfinite(features.durationMs) && features.durationMs > 0.0
+        && features.distance >= 0.0;
+}
+
+// Where the two classes are equally many standard deviations away, or nan when the swipe side
+// of this feature is not where the gate expects it (swipeAbove: swipes are larger). The gates
+// are applied together, so tightening one past current stops where it would reject more
+// than the swipes beyond keep deviations; loosening stops at the balance point itself.
+double boundary(double tapMean, double tapSpread, double swipeMean, double swipeSpread, bool swipeAbove,
+                double keep, double current) {
+    if (swipeAbove ? swipeMean <= tapMean : swipeMean >= tapMean) {
+        return std::nan("");
+    }
+    const double equal = (tapMean * swipeSpread + swipeMean * tapSpread) / (tapSpread + swipeSpread);
+    if (swipeAbove) {
+        return equal <= current ? equal : std::max(current, std::min(equal, swipeMean - keep * swipeSpread));
+    }
+    return equal >= current ? equal : std::min(current, std::max(equal, swipeMean + keep * swipeSpread));
+}
+
+// File layout, host byte order: header, then per class the three (mean, variance) pairs.
+struct TunerHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t counts[2];
+};
+
+} // namespace
+
+GestureTuner::GestureTuner(GestureThresholds defaults, GestureTunerConfig config)
+    : m_config(config) {
+    m_defaults.minDistanceNorm = std::clamp(defaults.minDistanceNorm, config.lower.minDistanceNorm,
+                                            config.upper.minDistanceNorm);
+    m_defaults.maxDurationMs = std::clamp(defaults.maxDurationMs, config.lower.maxDurationMs,
+                                          config.upper.maxDurationMs);
+    m_defaults.minVelocityNormPerMs = std::clamp(defaults.minVelocityNormPerMs, config.lower.minVelocityNormPerMs,
+                                                 config.upper.minVelocityNormPerMs);
+    m_thresholds = m_defaults;
+}
+
+void GestureTuner::observeLift(const GestureFeatures &features, SwipeDir swipe, const KeyAction &committed,
+                               std::int64_t nowMs) {
+    const bool swiped = swipe != SwipeDir::None;
+    // The first lift after an undo that types something says what the undone one should have
+    // been. A cancel or empty tap leaves it waiting; another backspace erases on and drops it.
+    if (m_undone.valid && committed.type != KeyAction::None) {
+        if (committed.type != KeyAction::Backspace && nowMs - m_undone.ms <= m_config.correctionWindowMs
+            && swiped != m_undone.swiped) {
+            learn(m_undone.features, swiped ? Swipe : Tap);
+        }
+        m_undone.valid = false;
+    }
+    if (committed.type == KeyAction::Backspace) {
+        settleBackspace(nowMs);
+    } else if (m_pending.valid) {
+        learn(m_pending.features, m_pending.swiped ? Swipe : Tap);
+    }
+    m_pending = Lift{usable(features), features, swiped,
+                     committed.type != KeyAction::None && committed.type != KeyAction::Backspace, nowMs};
+}
+
+void GestureTuner::observeBackspace(std::int64_t nowMs) {
+    m_undone.valid = false;
+    settleBackspace(nowMs);
+    m_pending.valid = false;
+}
+
+void GestureTuner::observeShapeLift() {
+    m_undone.valid = false;
+    if (m_pending.valid) {
+        learn(m_pending.features, m_pending.swiped ? Swipe : Tap);
+    }
+    m_pending.valid = false;
+}
+
+void GestureTuner::settleBackspace(std::int64_t nowMs) {
+    if (!m_pending.valid) {
+        return;
+    }
+    if (m_pending.undoable && nowMs - m_pending.ms <= m_config.correctionWindowMs) {
+        // Undone: learned once the redo shows which kind was meant, or not at all.
+        m_undone = m_pending;
+        m_undone.ms = nowMs;
+    } else {
+        // Erasing earlier text (or a late backspace) says nothing against this lift.
+        learn(m_pending.features, m_pending.swiped ? Swipe : Tap);
+    }
+    m_pending.valid = false;
+}
+
+void GestureTuner::learn(const GestureFeatures &features, Class type) {
+    if (!usable(features)) {
+        return;
+    }
+    ClassStats &stats = m_classes[type];
+    const std::array<double, kFeatures> values = featureVector(features);
+    const double alpha = stats.count == 0 ? 1.0 : m_config.learningRate;
+    for (int i = 0; i < kFeatures; ++i) {
+        FeatureStats &feature = stats.features[i];
+        const double delta = values[i] - feature.mean;
+        feature.mean = static_cast<float>(feature.mean + alpha * delta);
+        feature.variance = static_cast<float>((1.0 - alpha) * (feature.variance + alpha * delta * delta));
+    }
+    if (stats.count < UINT32_MAX) {
+        ++stats.count;
+    }
+    ++m_unsaved;
+    refit();
+}
+
+void GestureTuner::refit() {
+    const ClassStats &taps = m_classes[Tap];
+    const ClassStats &swipes = m_classes[Swipe];
+    const double n = std::min(taps.count, swipes.count);
+    m_thresholds = m_defaults;
+    if (n < m_config.minSamples) {
+        return;
+    }
+    const double weight = n / (n + m_config.priorSamples);
+    // Moves one gate from its default toward the fitted boundary, in log space, then clamps it.
+    auto fit = [&](int feature, bool swipeAbove, double fallback, double lower, double upper) {
+        // A floor on the spread keeps a class that never varies from owning the boundary.
+        const double tapSpread = std::sqrt(std::max(0.0, double(taps.features[feature].variance))) + 0.05;
+        const double swipeSpread = std::sqrt(std::max(0.0, double(swipes.features[feature].variance))) + 0.05;
+        const double logFallback = std::log(fallback);
+        const double fitted = boundary(taps.features[feature].mean, tapSpread, swipes.features[feature].mean,
+                                       swipeSpread, swipeAbove, m_config.swipeKeepDeviations, logFallback);
+        if (!std::isfinite(fitted)) {
+            return fallback;
+        }
+        return std::clamp(std::exp(logFallback + weight * (fitted - logFallback)), lower, upper);
+    };
+    const GestureThresholds &lower = m_config.lower;
+    const GestureThresholds &upper = m_config.upper;
+    m_thresholds.minDistanceNorm = fit(LogDistance, true, m_defaults.minDistanceNorm, lower.minDistanceNorm,
+                                       upper.minDistanceNorm);
+    m_thresholds.maxDurationMs = static_cast<int>(std::lround(
+        fit(LogDuration, false, m_defaults.maxDurationMs, lower.maxDurationMs, upper.maxDurationMs)));
+    m_thresholds.minVelocityNormPerMs = fit(LogVelocity, true, m_defaults.minVelocityNormPerMs,
+                                            lower.minVelocityNormPerMs, upper.minVelocityNormPerMs);
+}
+
+void GestureTuner::reset() {
+    m_classes = {};
+    m_pending = Lift{};
+    m_undone = Lift{};
+    m_unsaved = 0;
+    m_thresholds = m_defaults;
+}
+
+bool GestureTuner::load(const std::string &path) {
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    TunerHeader header{};
+    std::array<ClassStats, 2> loaded{};
+    bool ok = std::fread(&header, sizeof(header), 1, file) == 1;
+    for (ClassStats &stats : loaded) {
+        ok = ok && std::fread(stats.features.data(), sizeof(FeatureStats), kFeatures, file) == kFeatures;
+    }
+    std::fclose(file);
+    if (!ok || std::memcmp(header.magic, kTunerMagic, 4) != 0 || header.version != kTunerVersion) {
+        return false;
+    }
+    for (int type = 0; type < 2; ++type) {
+        loaded[type].count = header.counts[type];
+        for (const FeatureStats &feature : loaded[type].features) {
+            if (!std::isfinite(feature.mean) || !std::isfinite(feature.variance) || feature.variance < 0.0f) {
+                return false;
+            }
+        }
+    }
+    m_classes = loaded;
+    m_pending = Lift{};
+    m_undone = Lift{};
+    m_unsaved = 0;
+    // The envelope applies to loaded statistics exactly as to learned ones.
+    refit();
+    return true;
+}
+
+bool GestureTuner::save(const std::string &path) {
+    TunerHeader header{};
+    std::memcpy(header.magic, kTunerMagic, 4);
+    header.version = kTunerVersion;
+    header.counts[Tap] = m_classes[Tap].count;
+    header.counts[Swipe] = m_classes[Swipe].count;
+    const std::string temporary = path + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    for (const ClassStats &stats : m_classes) {
+        ok = ok && std::fwrite(stats.features.data(), sizeof(FeatureStats), kFeatures, file) == kFeatures;
+    }
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    m_unsaved = 0;
+    return true;
+}
+
+} // namespace radialkb
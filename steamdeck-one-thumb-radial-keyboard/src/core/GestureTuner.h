@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "GestureRecognizer.h"
+#include "KeyAction.h"
+
+// INTENT: Per-user swipe gates. Every lift is kept as a tap or swipe sample of log distance,
+// INTENT: duration and velocity until the next action shows whether it stood. A lift undone by
+// INTENT: a backspace and redone as the other kind is learned as that kind; only a lift that
+// INTENT: types something other than a backspace counts as the redo. Each gate sits
+// INTENT: where the two classes are equally many deviations away, but never cuts into the
+// INTENT: bulk of the swipes. It is shrunk toward the defaults while samples are few and
+// INTENT: clamped to a fixed envelope.
+
+namespace radialkb {
+
+struct GestureTunerConfig {
+    // EMA weight of one new sample.
+    double learningRate = 0.05;
+    // Samples of each class needed before any gate moves.
+    int minSamples = 20;
+    // Shrinks young boundaries toward the defaults: weight = n / (n + priorSamples).
+    double priorSamples = 40.0;
+    // A gate is never tightened past the swipes within this many deviations of their mean.
+    double swipeKeepDeviations = 2.0;
+    // A backspace and the redo after it must each follow within this window.
+    std::int64_t correctionWindowMs = 1500;
+    // Hard safety envelope: no data or file can move a gate outside [lower, upper].
+    // maxDurationMs runs the other way: lower is the strictest, upper the loosest.
+    GestureThresholds lower{0.08, 150, 0.0006};
+    GestureThresholds upper{0.20, 300, 0.0016};
+};
+
+class GestureTuner {
+public:
+    enum Class { Tap, Swipe };
+
+    explicit GestureTuner(GestureThresholds defaults = {}, GestureTunerConfig config = {});
+
+    // Every touch that ended in a swipe or a tap. committed is what the lift typed (None for a
+    // cancel or an empty tap); a Backspace also counts as observeBackspace().
+    void observeLift(const GestureFeatures &features, SwipeDir swipe, const KeyAction &committed,
+                     std::int64_t nowMs);
+    // A backspace that did not come from a touch (UI button, key action).
+    void observeBackspace(std::int64_t nowMs);
+    // A lift that was neither a tap nor a swipe (a shape gesture). It confirms the lift before it
+    // and is no sample itself, so a backspace after it is never blamed on an earlier lift.
+    void observeShapeLift();
+
+    // The gates to classify with: the defaults until both classes have minSamples.
+    const GestureThresholds &thresholds() const { return m_thresholds; }
+    const GestureThresholds &defaults() const { return m_defaults; }
+    int samples(Class type) const { return static_cast<int>(m_classes[type].count); }
+    // Learned samples since the last load/save.
+    int unsavedUpdates() const { return m_unsaved; }
+
+    // Forgets everything learned; the gates return to the defaults.
+    void reset();
+
+    bool load(const std::string &path);
+    // Written to a temporary file and renamed over path.
+    bool save(const std::string &path);
+
+private:
+    static constexpr int kFeatures = 3;
+
+    struct FeatureStats {
+        float mean = 0.0f;
+        float variance = 0.0f;
+    };
+    struct ClassStats {
+        std::array<FeatureStats, kFeatures> features{};
+        std::uint32_t count = 0;
+    };
+    struct Lift {
+        bool valid = false;
+        GestureFeatures features;
+        bool swiped = false;
+        // Typed something a backspace can take back.
+        bool undoable = false;
+        std::int64_t ms = 0;
+    };
+
+    void settleBackspace(std::int64_t nowMs);
+    void learn(const GestureFeatures &features, Class type);
+    void refit();
+
+    GestureThresholds m_defaults;
+    GestureTunerConfig m_config;
+    GestureThresholds m_thresholds;
+    std::array<ClassStats, 2> m_classes{};
+    Lift m_pending;
+    Lift m_undone;
+    int m_unsaved{0};
+};
+
+} // namespace radialkb
@@ -0,0 +1,48 @@
+#include "KeyAction.h"
+
+#include <array>
+
+namespace radialkb {
+
+namespace {
+
+// One NUL-terminated upper-case label per ASCII character; the rest are typed but unlabeled.
+constexpr std::array<std::array<char, 2>, 128> makeCharLabels() {
+    std::array<std::array<char, 2>, 128> labels{};
+    for (int c = 0; c < 128; ++c) {
+        labels[c][0] = static_cast<char>(c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c);
+    }
+    return labels;
+}
+
+constexpr std::array<std::array<char, 2>, 128> kCharLabels = makeCharLabels();
+
+} // namespace
+
+const char *keyLabel(const KeyAction &action) {
+    switch (action.type) {
+    case KeyAction::Char: {
+        const auto code = static_cast<unsigned char>(action.ch);
+        return code > 0 && code < kCharLabels.size() ? kCharLabels[code].data() : "?";
+    }
+    case KeyAction::Space:
+        return "␠";
+    case KeyAction::Backspace:
+        return "⌫";
+    case KeyAction::Enter:
+        return "↵";
+    case KeyAction::Tab:
+        return "⇥";
+    case KeyAction::Escape:
+        return "Esc";
+    case KeyAction::CapsLock:
+        return "⇪";
+    case KeyAction::DeleteWord:
+        return "⌦w";
+    case KeyAction::None:
+        break;
+    }
+    return "None";
+}
+
+} // namespace radialkb
@@ -0,0 +1,29 @@
+#pragma once
+
+namespace radialkb {
+
+struct KeyAction {
+    // CapsLock and DeleteWord (ctrl+backspace) come from shape gestures, not layout keys.
+    enum Type { None, Char, Space, Backspace, Enter, Tab, Escape, CapsLock, DeleteWord };
+    Type type{None};
+    char ch{'\0'};
+
+    static constexpr KeyAction makeChar(char value) {
+        KeyAction action;
+        action.type = Char;
+        action.ch = value;
+        return action;
+    }
+
+    static constexpr KeyAction make(Type value) {
+        KeyAction action;
+        action.type = value;
+        return action;
+    }
+};
+
+// UTF-8 display label: the upper-case character, or a symbol for the command keys
+// ("␠", "⌫", "↵", ...). Points to static storage.
+const char *keyLabel(const KeyAction &action);
+
+}
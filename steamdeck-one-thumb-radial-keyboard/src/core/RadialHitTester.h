@@ -0,0 +1,34 @@
+#pragma once
+
+#include "KeyAction.h"
+
+namespace radialkb {
+
+struct LayoutPoint {
+    double x = 0.0;
+    double y = 0.0;
+};
+
+// Hit-testing surface shared by the runtime RadialLayout (loaded/configurable layouts) and
+// the compile-time StaticRadialLayout (the fixed production layout). InputRouter only
+// talks to this interface. It is Qt-free; display labels come from keyLabel(KeyAction).
+class RadialHitTester {
+public:
+    virtual ~RadialHitTester() = default;
+
+    virtual int sectors() const = 0;
+    virtual int keyCount(int sectorIndex) const = 0;
+
+    virtual double angleForPoint(double xNorm, double yNorm) const = 0;
+    virtual double radiusForPoint(double xNorm, double yNorm) const = 0;
+
+    virtual int angleToSectorWithHysteresis(double angleRad, int previousSector, double hysteresisRad) const = 0;
+    virtual int angleToKeyIndexWithHysteresis(double angleRad, int sectorIndex, int previousIndex,
+                                              double hysteresisRad) const = 0;
+
+    virtual KeyAction keyAction(int sectorIndex, int keyIndex) const = 0;
+    // Normalized pad position at the angular center of a key on the letter ring.
+    virtual LayoutPoint keyAnchor(int sectorIndex, int keyIndex) const = 0;
+};
+
+} // namespace radialkb
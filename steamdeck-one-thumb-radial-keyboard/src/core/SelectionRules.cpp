@@ -0,0 +1,35 @@
+#include "SelectionRules.h"
+
+namespace radialkb {
+
+SelectionState resolveSelection(const RadialHitTester &layout, double xNorm, double yNorm,
+                                const SelectionState &previous, const SelectionThresholds &thresholds) {
+    const double angle = layout.angleForPoint(xNorm, yNorm);
+    const double radius = layout.radiusForPoint(xNorm, yNorm);
+
+    SelectionState next = previous;
+    if (!next.trackingLetter && radius >= thresholds.innerRadius) {
+        next.trackingLetter = true;
+    } else if (next.trackingLetter && radius < (thresholds.innerRadius - thresholds.innerHysteresis)) {
+        next.trackingLetter = false;
+    }
+
+    if (radius < thresholds.deadzoneRadius) {
+        return SelectionState{};
+    }
+
+    const int sector = layout.angleToSectorWithHysteresis(angle, previous.sector, thresholds.angleHysteresisRad);
+    if (sector != next.sector) {
+        next.sector = sector;
+        next.key = -1;
+    }
+
+    if (next.trackingLetter && next.sector >= 0) {
+        next.key = layout.angleToKeyIndexWithHysteresis(angle, next.sector, next.key, thresholds.angleHysteresisRad);
+    } else if (!next.trackingLetter) {
+        next.key = -1;
+    }
+    return next;
+}
+
+} // namespace radialkb
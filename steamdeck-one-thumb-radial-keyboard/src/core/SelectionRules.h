@@ -0,0 +1,29 @@
+#pragma once
+
+#include "RadialHitTester.h"
+
+// INTENT: One definition of how a pad position maps to a selection (deadzone, group/letter
+// INTENT: ring with hysteresis, angular hysteresis). Shared by the engine and the UI so the
+// INTENT: provisional highlight can never disagree with what the engine will commit.
+
+namespace radialkb {
+
+struct SelectionThresholds {
+    double deadzoneRadius = 0.12;
+    double innerRadius = 0.28;
+    double innerHysteresis = 0.03;
+    double angleHysteresisRad = 3.0 * 3.14159265358979323846 / 180.0;
+};
+
+struct SelectionState {
+    int sector = -1;
+    int key = -1;
+    bool trackingLetter = false;
+};
+
+// Pure function of the previous selection and one normalized sample. A sample inside the
+// deadzone yields the cleared state {-1, -1, false}.
+SelectionState resolveSelection(const RadialHitTester &layout, double xNorm, double yNorm,
+                                const SelectionState &previous, const SelectionThresholds &thresholds = {});
+
+} // namespace radialkb
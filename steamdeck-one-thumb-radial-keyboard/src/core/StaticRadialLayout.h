@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#include "KeyAction.h"
+#include "RadialHitTester.h"
+
+// Compile-time specialized radial layout. Sector/key boundary tables, key anchors and the
+// key-action lookup are generated by constexpr code, so hit testing reduces to a multiply,
+// a table comparison or two and an array load. Loaded layouts keep using RadialLayout.
+
+namespace radialkb {
+
+namespace layout_detail {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kTwoPi = 2.0 * kPi;
+
+constexpr double constexprSin(double x) {
+    while (x > kPi) {
+        x -= kTwoPi;
+    }
+    while (x < -kPi) {
+        x += kTwoPi;
+    }
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 14; ++n) {
+        term *= -x * x / static_cast<double>((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double constexprCos(double x) {
+    return constexprSin(x + kPi / 2.0);
+}
+
+constexpr int constexprLength(const char *text) {
+    int length = 0;
+    while (text[length] != '\0') {
+        ++length;
+    }
+    return length;
+}
+
+// ' ' = space, '\b' = backspace, '\n' = enter; anything else is typed as-is.
+constexpr KeyAction actionForKey(char key) {
+    switch (key) {
+    case ' ':
+        return KeyAction::make(KeyAction::Space);
+    case '\b':
+        return KeyAction::make(KeyAction::Backspace);
+    case '\n':
+        return KeyAction::make(KeyAction::Enter);
+    case '\t':
+        return KeyAction::make(KeyAction::Tab);
+    default:
+        return KeyAction::makeChar(key);
+    }
+}
+
+// Same metric as RadialLayout: both angles are already normalized to [0, 2pi].
+constexpr double angularDistance(double a, double b) {
+    double diff = a > b ? a - b : b - a;
+    if (diff > kPi) {
+        diff = kTwoPi - diff;
+    }
+    return diff;
+}
+
+} // namespace layout_detail
+
+template <int Sectors, int... KeysPerSector>
+class RadialTables {
+    static_assert(Sectors > 0, "at least one sector");
+    static_assert(sizeof...(KeysPerSector) == Sectors, "one key count per sector");
+    static_assert(((KeysPerSector > 0) && ...), "every sector needs a key");
+
+public:
+    static constexpr int kSectors = Sectors;
+    static constexpr int kMaxKeys = std::max({KeysPerSector...});
+    static constexpr std::array<int, Sectors> kKeyCounts{{KeysPerSector...}};
+    static constexpr double kSectorAngle = layout_detail::kTwoPi / Sectors;
+    static constexpr double kSectorScale = Sectors / layout_detail::kTwoPi;
+
+    // keys: one string per sector, one character per key (see layout_detail::actionForKey).
+    constexpr RadialTables(const char *const (&keys)[Sectors], double angleOffsetRad,
+                           double centerX = 0.5, double centerY = 0.5, double anchorRadius = 0.38)
+        : m_angleOffset(angleOffsetRad), m_centerX(centerX), m_centerY(centerY) {
+        for (int s = 0; s <= Sectors; ++s) {
+            m_sectorStart[s] = kSectorAngle * s;
+        }
+        for (int s = 0; s < Sectors; ++s) {
+            const int count = kKeyCounts[s];
+            if (layout_detail::constexprLength(keys[s]) != count) {
+                throw std::logic_error("key string length does not match KeysPerSector");
+            }
+            const double keyAngle = kSectorAngle / count;
+            m_keyScale[s] = count / kSectorAngle;
+            for (int k = 0; k <= count; ++k) {
+                m_keyStart[s][k] = m_sectorStart[s] + keyAngle * k;
+            }
+            for (int k = 0; k < count; ++k) {
+                m_keys[s][k] = keys[s][k];
+                m_actions[s][k] = layout_detail::actionForKey(keys[s][k]);
+                // Undo the layout's angle offset to get back to pad coordinates.
+                const double screenAngle = m_sectorStart[s] + keyAngle * (k + 0.5) - angleOffsetRad;
+                m_anchors[s][k] = LayoutPoint{centerX + anchorRadius * layout_detail::constexprCos(screenAngle),
+                                              centerY + anchorRadius * layout_detail::constexprSin(screenAngle)};
+            }
+        }
+    }
+
+    constexpr double angleOffset() const { return m_angleOffset; }
+    constexpr double centerX() const { return m_centerX; }
+    constexpr double centerY() const { return m_centerY; }
+    constexpr char keyChar(int sector, int key) const { return m_keys[sector][key]; }
+    constexpr KeyAction action(int sector, int key) const { return m_actions[sector][key]; }
+    constexpr LayoutPoint anchor(int sector, int key) const { return m_anchors[sector][key]; }
+    constexpr double sectorStart(int sector) const { return m_sectorStart[sector]; }
+    constexpr double keyStart(int sector, int key) const { return m_keyStart[sector][key]; }
+
+    constexpr int sectorForAngle(double angleRad) const {
+        int sector = static_cast<int>(angleRad * kSectorScale);
+        // The multiply can land one ulp off at a boundary; the table decides.
+        if (sector < Sectors && angleRad >= m_sectorStart[sector + 1]) {
+            ++sector;
+        } else if (sector > 0 && angleRad < m_sectorStart[sector]) {
+            --sector;
+        }
+        return sector < 0 ? 0 : (sector >= Sectors ? Sectors - 1 : sector);
+    }
+
+    constexpr int sectorWithHysteresis(double angleRad, int previousSector, double hysteresisRad) const {
+        const int raw = sectorForAngle(angleRad);
+        if (previousSector < 0 || previousSector >= Sectors || raw == previousSector) {
+            return raw;
+        }
+        if (layout_detail::angularDistance(angleRad, m_sectorStart[previousSector]) < hysteresisRad ||
+            layout_detail::angularDistance(angleRad, m_sectorStart[previousSector + 1]) < hysteresisRad) {
+            return previousSector;
+        }
+        return raw;
+    }
+
+    constexpr int keyForAngle(double angleRad, int sector) const {
+        if (sector < 0 || sector >= Sectors) {
+            return -1;
+        }
+        const int count = kKeyCounts[sector];
+        const double local = angleRad - m_sectorStart[sector];
+        // Angles before the sector wrap around and land on the last key, as in RadialLayout.
+        if (local < 0.0) {
+            return count - 1;
+        }
+        int key = static_cast<int>(local * m_keyScale[sector]);
+        if (key < count && angleRad >= m_keyStart[sector][key + 1]) {
+            ++key;
+        } else if (key > 0 && key <= count && angleRad < m_keyStart[sector][key]) {
+            --key;
+        }
+        return key < 0 ? 0 : (key >= count ? count - 1 : key);
+    }
+
+    constexpr int keyWithHysteresis(double angleRad, int sector, int previousKey, double hysteresisRad) const {
+        const int raw = keyForAngle(angleRad, sector);
+        if (sector < 0 || sector >= Sectors) {
+            return raw;
+        }
+        if (previousKey < 0 || previousKey >= kKeyCounts[sector] || raw == previousKey) {
+            return raw;
+        }
+        if (layout_detail::angularDistance(angleRad, m_keyStart[sector][previousKey]) < hysteresisRad ||
+            layout_detail::angularDistance(angleRad, m_keyStart[sector][previousKey + 1]) < hysteresisRad) {
+            return previousKey;
+        }
+        return raw;
+    }
+
+private:
+    double m_angleOffset{0.0};
+    double m_centerX{0.5};
+    double m_centerY{0.5};
+    std::array<double, Sectors + 1> m_sectorStart{};
+    std::array<double, Sectors> m_keyScale{};
+    std::array<std::array<double, kMaxKeys + 1>, Sectors> m_keyStart{};
+    std::array<std::array<char, kMaxKeys>, Sectors> m_keys{};
+    std::array<std::array<KeyAction, kMaxKeys>, Sectors> m_actions{};
+    std::array<std::array<LayoutPoint, kMaxKeys>, Sectors> m_anchors{};
+};
+
+template <int Sectors, int... KeysPerSector>
+class StaticRadialLayout final : public RadialHitTester {
+public:
+    using Tables = RadialTables<Sectors, KeysPerSector...>;
+
+    explicit StaticRadialLayout(const Tables &tables) : m_tables(tables) {}
+
+    const Tables &tables() const { return m_tables; }
+
+    int sectors() const override { return Sectors; }
+
+    int keyCount(int sectorIndex) const override {
+        if (sectorIndex < 0 || sectorIndex >= Sectors) {
+            return 0;
+        }
+        return Tables::kKeyCounts[sectorIndex];
+    }
+
+    double angleForPoint(double xNorm, double yNorm) const override {
+        double angle = std::atan2(yNorm - m_tables.centerY(), xNorm - m_tables.centerX()) + m_tables.angleOffset();
+        // atan2 is within [-pi, pi], so one correction step is enough for offsets within one turn.
+        if (angle < 0.0) {
+            angle += layout_detail::kTwoPi;
+        } else if (angle >= layout_detail::kTwoPi) {
+            angle -= layout_detail::kTwoPi;
+        }
+        return angle;
+    }
+
+    double radiusForPoint(double xNorm, double yNorm) const override {
+        return std::hypot(xNorm - m_tables.centerX(), yNorm - m_tables.centerY());
+    }
+
+    int angleToSectorWithHysteresis(double angleRad, int previousSector, double hysteresisRad) const override {
+        return m_tables.sectorWithHysteresis(angleRad, previousSector, hysteresisRad);
+    }
+
+    int angleToKeyIndexWithHysteresis(double angleRad, int sectorIndex, int previousIndex,
+                                      double hysteresisRad) const override {
+        return m_tables.keyWithHysteresis(angleRad, sectorIndex, previousIndex, hysteresisRad);
+    }
+
+    KeyAction keyAction(int sectorIndex, int keyIndex) const override {
+        if (keyIndex < 0 || keyIndex >= keyCount(sectorIndex)) {
+            return KeyAction::make(KeyAction::None);
+        }
+        return m_tables.action(sectorIndex, keyIndex);
+    }
+
+    LayoutPoint keyAnchor(int sectorIndex, int keyIndex) const override {
+        if (keyIndex < 0 || keyIndex >= keyCount(sectorIndex)) {
+            return LayoutPoint{m_tables.centerX(), m_tables.centerY()};
+        }
+        return m_tables.anchor(sectorIndex, keyIndex);
+    }
+
+private:
+    Tables m_tables;
+};
+
+// Production layout: 8 sectors, sector 0 at the top (pi/2 offset), same keys as RadialLayout.
+using DefaultRadialTables = RadialTables<8, 4, 4, 4, 4, 4, 4, 5, 3>;
+using DefaultRadialLayout = StaticRadialLayout<8, 4, 4, 4, 4, 4, 4, 5, 3>;
+
+inline constexpr const char *kDefaultLayoutKeys[8] = {
+    "etao", "insh", "rdlu", "cmfw", "gpby", "vkjx", "qz.,?", " \b\n"
+};
+
+inline constexpr DefaultRadialTables kDefaultRadialTables{kDefaultLayoutKeys, layout_detail::kPi / 2.0};
+
+static_assert(kDefaultRadialTables.sectorForAngle(0.1) == 0, "sector 0 starts at the top");
+static_assert(kDefaultRadialTables.sectorForAngle(layout_detail::kTwoPi - 0.1) == 7, "last sector wraps");
+static_assert(kDefaultRadialTables.keyForAngle(DefaultRadialTables::kSectorAngle * 6.9, 6) == 4, "5-key sector");
+static_assert(kDefaultRadialTables.action(7, 1).type == KeyAction::Backspace, "command sector");
+
+} // namespace radialkb
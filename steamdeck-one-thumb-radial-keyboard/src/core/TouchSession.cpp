@@ -0,0 +1,110 @@
+#include "TouchSession.h"
+
+namespace radialkb {
+
+TouchSession::TouchSession(const RadialHitTester &layout, TouchListener &listener, GestureThresholds gestures,
+                           SelectionThresholds selection)
+    : m_layout(&layout),
+      m_listener(listener),
+      m_gestures(gestures),
+      m_thresholds(selection) {
+}
+
+void TouchSession::setLayout(const RadialHitTester &layout) {
+    m_layout = &layout;
+    resetSelection();
+}
+
+void TouchSession::touchDown(const TouchSample &sample) {
+    m_gestures.onTouchDown(sample);
+    updateSelection(sample.x, sample.y);
+}
+
+void TouchSession::touchMove(const TouchSample &sample) {
+    m_gestures.onTouchMove(sample);
+    updateSelection(sample.x, sample.y);
+}
+
+void TouchSession::touchUp(const TouchSample &sample) {
+    const SwipeDir swipe = m_gestures.onTouchUp(sample);
+    const SelectionState lift = resolveSelection(*m_layout, sample.x, sample.y, m_selection, m_thresholds);
+    if (m_listener.interceptLift(swipe, lift)) {
+        return;
+    }
+    const KeyAction committed = commitLift(swipe, lift);
+    // Nothing is bound to swipe up; such a lift acts as a tap.
+    m_listener.lifted(m_gestures.lastGesture(), swipe == SwipeDir::Up ? SwipeDir::None : swipe, committed);
+}
+
+KeyAction TouchSession::commitLift(SwipeDir swipe, const SelectionState &lift) {
+    switch (swipe) {
+    case SwipeDir::Left:
+        commit(TouchCommit{KeyAction::make(KeyAction::Backspace), -1, -1, false, swipe});
+        return KeyAction::make(KeyAction::Backspace);
+    case SwipeDir::Right:
+        commit(TouchCommit{KeyAction::make(KeyAction::Space), -1, -1, false, swipe});
+        return KeyAction::make(KeyAction::Space);
+    case SwipeDir::Down:
+        cancel();
+        return KeyAction::make(KeyAction::None);
+    case SwipeDir::Up:
+    case SwipeDir::None:
+        break;
+    }
+
+    applySelection(lift);
+    if (m_selection.sector < 0) {
+        return KeyAction::make(KeyAction::None);
+    }
+    // Outside the letter ring the sector's first key is committed.
+    const int keyCount = m_layout->keyCount(m_selection.sector);
+    const int wanted = m_selection.trackingLetter && m_selection.key >= 0 ? m_selection.key : 0;
+    const int key = keyCount > 0 && wanted < keyCount ? wanted : 0;
+    const KeyAction action = m_layout->keyAction(m_selection.sector, key);
+    if (action.type != KeyAction::None) {
+        commit(TouchCommit{action, m_selection.sector, key, m_selection.trackingLetter && m_selection.key == key});
+    }
+    return action;
+}
+
+void TouchSession::cancel() {
+    m_listener.cancelled();
+    clearSelection();
+}
+
+void TouchSession::updateSelection(double xNorm, double yNorm) {
+    applySelection(resolveSelection(*m_layout, xNorm, yNorm, m_selection, m_thresholds));
+}
+
+void TouchSession::applySelection(const SelectionState &next) {
+    if (next.sector < 0) {
+        clearSelection();
+        return;
+    }
+    m_selection.trackingLetter = next.trackingLetter;
+    if (next.sector != m_selection.sector) {
+        m_selection.sector = next.sector;
+        m_selection.key = -1;
+        m_listener.selectionChanged(m_selection);
+    }
+    if (next.key != m_selection.key) {
+        m_selection.key = next.key;
+        if (m_selection.trackingLetter) {
+            m_listener.selectionChanged(m_selection);
+        }
+    }
+}
+
+void TouchSession::clearSelection() {
+    if (m_selection.sector != -1 || m_selection.key != -1 || m_selection.trackingLetter) {
+        m_selection = SelectionState{};
+        m_listener.selectionChanged(m_selection);
+    }
+}
+
+void TouchSession::commit(const TouchCommit &commit) {
+    // Like InputRouter, the selection survives a commit; the next touch down replaces it.
+    m_listener.committed(commit);
+}
+
+} // namespace radialkb
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "GestureRecognizer.h"
+#include "KeyAction.h"
+#include "RadialHitTester.h"
+#include "SelectionRules.h"
+
+// INTENT: The single-pad typing loop without Qt: touch samples in, selection changes and key
+// INTENT: commits out through a listener (swipe left/right/down, commit on lift). InputRouter's
+// INTENT: single-pad path runs on it and adds shape gestures, autocorrect, learning and metrics
+// INTENT: through the listener hooks.
+
+namespace radialkb {
+
+struct TouchCommit {
+    KeyAction action;
+    // Selection the action came from; -1 for swipes.
+    int sector = -1;
+    int key = -1;
+    // A letter-ring tap: the lift position was aimed at this key.
+    bool aimed = false;
+    // The swipe that typed the action; None for a key.
+    SwipeDir swipe = SwipeDir::None;
+};
+
+// Called synchronously from the TouchSession entry points; must not re-enter the session.
+class TouchListener {
+public:
+    virtual ~TouchListener() = default;
+
+    // Sector changes (key -1), key changes in the letter ring and clears ({-1, -1, false}).
+    virtual void selectionChanged(const SelectionState &selection) = 0;
+    virtual void committed(const TouchCommit &commit) = 0;
+    // Swipe down, or cancel().
+    virtual void cancelled() = 0;
+
+    // At touch up, with the swipe and the selection the lift lands on, before anything is
+    // committed. Returning true ends the touch there: nothing is committed, the selection is
+    // left as it is and lifted() is not called.
+    virtual bool interceptLift(SwipeDir, const SelectionState &) { return false; }
+    // Every touch up that was not intercepted, after its commit or cancel: the touch's features,
+    // the swipe that acted (None when it acted as a tap) and what it committed (None for a cancel
+    // or a lift on nothing).
+    virtual void lifted(const GestureFeatures &, SwipeDir, const KeyAction &) {}
+};
+
+class TouchSession {
+public:
+    // The layout must outlive the session.
+    TouchSession(const RadialHitTester &layout, TouchListener &listener, GestureThresholds gestures = {},
+                 SelectionThresholds selection = {});
+
+    // Clears the selection without reporting it; takes effect from the next sample.
+    void setLayout(const RadialHitTester &layout);
+    void setGestureThresholds(const GestureThresholds &thresholds) { m_gestures.setThresholds(thresholds); }
+
+    void touchDown(const TouchSample &sample);
+    void touchMove(const TouchSample &sample);
+    void touchUp(const TouchSample &sample);
+    void cancel();
+    // Clears the selection without reporting it, for owners that report it themselves.
+    void resetSelection() { m_selection = SelectionState{}; }
+
+    const SelectionState &selection() const { return m_selection; }
+    // Features of the touch ended by the last touchUp().
+    const GestureFeatures &lastGesture() const { return m_gestures.lastGesture(); }
+
+private:
+    // What the lift committed, if anything.
+    KeyAction commitLift(SwipeDir swipe, const SelectionState &lift);
+    void updateSelection(double xNorm, double yNorm);
+    void applySelection(const SelectionState &next);
+    void clearSelection();
+    void commit(const TouchCommit &commit);
+
+    const RadialHitTester *m_layout;
+    TouchListener &m_listener;
+    GestureRecognizer m_gestures;
+    SelectionThresholds m_thresholds;
+    SelectionState m_selection;
+};
+
+} // namespace radialkb
@@ -0,0 +1,242 @@
+#include "AdaptiveTouchModel.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtMath>
+
+#include <cmath>
+
+namespace radialkb {
+
+namespace {
+
+constexpr quint32 kModelMagic = 0x4d544b52; // "RKTM"
+constexpr quint16 kModelVersion = 1;
+
+// Signed difference a - b wrapped into (-pi, pi].
+double signedAngle(double a, double b) {
+    double diff = std::fmod(a - b, 2.0 * M_PI);
+    if (diff > M_PI) {
+        diff -= 2.0 * M_PI;
+    } else if (diff <= -M_PI) {
+        diff += 2.0 * M_PI;
+    }
+    return diff;
+}
+
+} // namespace
+
+AdaptiveTouchModel::AdaptiveTouchModel(const RadialHitTester &layout, AdaptiveTouchConfig config)
+    : m_layout(layout),
+      m_config(config),
+      m_sectors(layout.sectors()) {
+    double narrowest = 2.0 * M_PI;
+    for (int sector = 0; sector < m_sectors; ++sector) {
+        m_firstKey.push_back(m_center.size());
+        for (int key = 0; key < layout.keyCount(sector); ++key) {
+            const LayoutPoint anchor = layout.keyAnchor(sector, key);
+            m_center.push_back(layout.angleForPoint(anchor.x, anchor.y));
+        }
+        if (layout.keyCount(sector) > 0) {
+            narrowest = qMin(narrowest, (2.0 * M_PI / m_sectors) / layout.keyCount(sector));
+        }
+    }
+    m_stats.resize(m_center.size());
+    m_effective.fill(0.0, m_center.size());
+    m_maxShift = narrowest * m_config.maxShiftFraction;
+}
+
+int AdaptiveTouchModel::ringIndex(int sector, int key) const {
+    if (sector < 0 || sector >= m_sectors || key < 0 || key >= m_layout.keyCount(sector)) {
+        return -1;
+    }
+    return m_firstKey.at(sector) + key;
+}
+
+double AdaptiveTouchModel::correctedAngle(double rawAngle) const {
+    const int ring = m_center.size();
+    if (ring < 2) {
+        return rawAngle;
+    }
+    const int sector = m_layout.angleToSectorWithHysteresis(rawAngle, -1, 0.0);
+    const int index = ringIndex(sector, m_layout.angleToKeyIndexWithHysteresis(rawAngle, sector, -1, 0.0));
+    if (index < 0) {
+        return rawAngle;
+    }
+    // Interpolate between this key's offset and the neighbor's on the side of the sample.
+    const double fromCenter = signedAngle(rawAngle, m_center.at(index));
+    const int neighbor = fromCenter >= 0.0 ? (index + 1) % ring : (index + ring - 1) % ring;
+    const double span = std::abs(signedAngle(m_center.at(neighbor), m_center.at(index)));
+    const double t = span > 0.0 ? qMin(1.0, std::abs(fromCenter) / span) : 0.0;
+    const double offset = (1.0 - t) * m_effective.at(index) + t * m_effective.at(neighbor);
+    if (offset == 0.0) {
+        return rawAngle;
+    }
+    double corrected = rawAngle - offset;
+    if (corrected < 0.0) {
+        corrected += 2.0 * M_PI;
+    } else if (corrected >= 2.0 * M_PI) {
+        corrected -= 2.0 * M_PI;
+    }
+    return corrected;
+}
+
+bool AdaptiveTouchModel::areNeighbors(int sectorA, int keyA, int sectorB, int keyB) const {
+    if (sectorA == sectorB) {
+        return std::abs(keyA - keyB) == 1;
+    }
+    const int distance = std::abs(sectorA - sectorB);
+    return distance == 1 || distance == m_sectors - 1;
+}
+
+void AdaptiveTouchModel::observeTap(int sector, int key, double rawAngle, std::int64_t nowMs) {
+    if (m_erased.valid && nowMs - m_erased.ms <= m_config.correctionWindowMs &&
+        areNeighbors(m_erased.sector, m_erased.key, sector, key)) {
+        // The erased tap was aimed at the key typed in its place.
+        learn(sector, key, m_erased.rawAngle);
+    }
+    m_erased.valid = false;
+    confirmPending();
+    m_pending = Tap{true, sector, key, rawAngle, nowMs};
+}
+
+void AdaptiveTouchModel::observeBackspace(std::int64_t nowMs) {
+    if (m_pending.valid && nowMs - m_pending.ms <= m_config.correctionWindowMs) {
+        m_erased = m_pending;
+        m_erased.ms = nowMs;
+    } else {
+        m_erased.valid = false;
+    }
+    // A late backspace is ambiguous (could be a word-level edit); learn nothing from it.
+    m_pending.valid = false;
+}
+
+void AdaptiveTouchModel::observeOtherCommit(std::int64_t nowMs) {
+    Q_UNUSED(nowMs);
+    m_erased.valid = false;
+    confirmPending();
+}
+
+void AdaptiveTouchModel::confirmPending() {
+    if (m_pending.valid) {
+        learn(m_pending.sector, m_pending.key, m_pending.rawAngle);
+        m_pending.valid = false;
+    }
+}
+
+void AdaptiveTouchModel::learn(int sector, int key, double rawAngle) {
+    const int index = ringIndex(sector, key);
+    if (index < 0) {
+        return;
+    }
+    const double offset = signedAngle(rawAngle, m_center.at(index));
+    // Taps more than a sector away are not aim errors; ignore them.
+    if (std::abs(offset) > 2.0 * M_PI / m_sectors) {
+        return;
+    }
+    KeyStats &stats = m_stats[index];
+    const double alpha = stats.count == 0 ? 1.0 : m_config.learningRate;
+    const double delta = offset - stats.mean;
+    stats.mean = static_cast<float>(stats.mean + alpha * delta);
+    stats.variance = static_cast<float>((1.0 - alpha) * (stats.variance + alpha * delta * delta));
+    if (stats.count < UINT16_MAX) {
+        ++stats.count;
+    }
+    refreshEffective(index);
+    ++m_unsaved;
+}
+
+void AdaptiveTouchModel::refreshEffective(int index) {
+    const KeyStats &stats = m_stats.at(index);
+    if (stats.count < m_config.minSamples) {
+        m_effective[index] = 0.0;
+        return;
+    }
+    // Offsets indistinguishable from the spread of the taps are noise, not drift.
+    const double n = stats.count;
+    const double standardError = std::sqrt(qMax(0.0, static_cast<double>(stats.variance)) / n);
+    if (std::abs(stats.mean) <= standardError) {
+        m_effective[index] = 0.0;
+        return;
+    }
+    const double shrunk = stats.mean * n / (n + m_config.priorSamples);
+    m_effective[index] = qBound(-m_maxShift, shrunk, m_maxShift);
+}
+
+int AdaptiveTouchModel::samples(int sector, int key) const {
+    const int index = ringIndex(sector, key);
+    return index < 0 ? 0 : m_stats.at(index).count;
+}
+
+double AdaptiveTouchModel::meanOffset(int sector, int key) const {
+    const int index = ringIndex(sector, key);
+    return index < 0 ? 0.0 : m_stats.at(index).mean;
+}
+
+double AdaptiveTouchModel::effectiveOffset(int sector, int key) const {
+    const int index = ringIndex(sector, key);
+    return index < 0 ? 0.0 : m_effective.at(index);
+}
+
+// Layout: magic, version, key count, then (mean, variance, count) per key in ring order.
+bool AdaptiveTouchModel::load(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setByteOrder(QDataStream::LittleEndian);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint16 keys = 0;
+    in >> magic >> version >> keys;
+    if (magic != kModelMagic || version != kModelVersion || keys != m_stats.size()) {
+        return false;
+    }
+    QVector<KeyStats> loaded(keys);
+    for (KeyStats &stats : loaded) {
+        quint16 count = 0;
+        in >> stats.mean >> stats.variance >> count;
+        stats.count = count;
+    }
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+    m_stats = loaded;
+    for (int i = 0; i < m_stats.size(); ++i) {
+        refreshEffective(i);
+    }
+    m_unsaved = 0;
+    return true;
+}
+
+bool AdaptiveTouchModel::save(const QString &path) {
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    out << kModelMagic << kModelVersion << static_cast<quint16>(m_stats.size());
+    for (const KeyStats &stats : m_stats) {
+        out << stats.mean << stats.variance << static_cast<quint16>(stats.count);
+    }
+    if (!file.commit()) {
+        return false;
+    }
+    m_unsaved = 0;
+    return true;
+}
+
+QString AdaptiveTouchModel::defaultPath() {
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/radialkb/touch_model.bin";
+}
+
+} // namespace radialkb
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+#include <cstdint>
+
+#include "RadialHitTester.h"
+
+namespace radialkb {
+
+struct AdaptiveTouchConfig {
+    // EMA weight of one new observation.
+    double learningRate = 0.08;
+    // Observations needed before a key's offset is applied at all.
+    int minSamples = 5;
+    // Shrinks young estimates toward zero: effective = mean * n / (n + priorSamples).
+    double priorSamples = 10.0;
+    // Shift limit as a fraction of the narrowest key; keeps shifted boundaries monotonic.
+    double maxShiftFraction = 0.4;
+    // A commit followed by a backspace within this window counts as a mis-hit.
+    std::int64_t correctionWindowMs = 1500;
+};
+
+// INTENT: Per-user model of where the thumb actually lands for each key. Every key keeps an
+// INTENT: EMA mean/variance of the signed angular offset between committed taps and the key's
+// INTENT: center; hit testing subtracts the interpolated offset, which moves the effective
+// INTENT: sector/key boundaries. Updates and lookups are O(1).
+class AdaptiveTouchModel {
+public:
+    explicit AdaptiveTouchModel(const RadialHitTester &layout, AdaptiveTouchConfig config = {});
+
+    // Raw layout angle (see RadialHitTester::angleForPoint) to the angle to hit test with.
+    double correctedAngle(double rawAngle) const;
+
+    // Commit feedback. A tap is only learned once the next commit shows it was not undone; a
+    // tap undone by a backspace and retyped on a neighboring key is learned for that key.
+    void observeTap(int sector, int key, double rawAngle, std::int64_t nowMs);
+    void observeBackspace(std::int64_t nowMs);
+    void observeOtherCommit(std::int64_t nowMs);
+
+    int samples(int sector, int key) const;
+    double meanOffset(int sector, int key) const;
+    double effectiveOffset(int sector, int key) const;
+    // Learned observations since the last load/save.
+    int unsavedUpdates() const { return m_unsaved; }
+
+    bool load(const QString &path);
+    bool save(const QString &path);
+    // Per-user location under the XDG data directory.
+    static QString defaultPath();
+
+private:
+    struct KeyStats {
+        float mean = 0.0f;
+        float variance = 0.0f;
+        std::uint16_t count = 0;
+    };
+    struct Tap {
+        bool valid = false;
+        int sector = -1;
+        int key = -1;
+        double rawAngle = 0.0;
+        std::int64_t ms = 0;
+    };
+
+    int ringIndex(int sector, int key) const;
+    bool areNeighbors(int sectorA, int keyA, int sectorB, int keyB) const;
+    void learn(int sector, int key, double rawAngle);
+    void confirmPending();
+    void refreshEffective(int index);
+
+    const RadialHitTester &m_layout;
+    AdaptiveTouchConfig m_config;
+    int m_sectors{0};
+    QVector<int> m_firstKey;      // ring index of key 0 per sector
+    QVector<double> m_center;     // key center angle per ring index
+    QVector<KeyStats> m_stats;
+    QVector<double> m_effective;  // cached clamped/shrunk offset per ring index
+    double m_maxShift{0.0};
+    Tap m_pending;
+    Tap m_erased;
+    int m_unsaved{0};
+};
+
+// Hit tester that applies an AdaptiveTouchModel on top of another layout. Only angleForPoint
+// changes, so every sector/key decision downstream sees the shifted boundaries consistently.
+class AdaptiveHitTester final : public RadialHitTester {
+public:
+    AdaptiveHitTester(const RadialHitTester &base, const AdaptiveTouchModel &model)
+        : m_base(base), m_model(model) {}
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool enabled() const { return m_enabled; }
+
+    int sectors() const override { return m_base.sectors(); }
+    int keyCount(int sectorIndex) const override { return m_base.keyCount(sectorIndex); }
+    double angleForPoint(double xNorm, double yNorm) const override {
+        const double raw = m_base.angleForPoint(xNorm, yNorm);
+        return m_enabled ? m_model.correctedAngle(raw) : raw;
+    }
+    double radiusForPoint(double xNorm, double yNorm) const override { return m_base.radiusForPoint(xNorm, yNorm); }
+    int angleToSectorWithHysteresis(double angleRad, int previousSector, double hysteresisRad) const override {
+        return m_base.angleToSectorWithHysteresis(angleRad, previousSector, hysteresisRad);
+    }
+    int angleToKeyIndexWithHysteresis(double angleRad, int sectorIndex, int previousIndex,
+                                      double hysteresisRad) const override {
+        return m_base.angleToKeyIndexWithHysteresis(angleRad, sectorIndex, previousIndex, hysteresisRad);
+    }
+    KeyAction keyAction(int sectorIndex, int keyIndex) const override { return m_base.keyAction(sectorIndex, keyIndex); }
+    LayoutPoint keyAnchor(int sectorIndex, int keyIndex) const override { return m_base.keyAnchor(sectorIndex, keyIndex); }
+
+private:
+    const RadialHitTester &m_base;
+    const AdaptiveTouchModel &m_model;
+    bool m_enabled{true};
+};
+
+} // namespace radialkb
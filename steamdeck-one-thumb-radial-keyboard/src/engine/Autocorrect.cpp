@@ -0,0 +1,170 @@
+#include "Autocorrect.h"
+
+#include <QtMath>
+
+#include <cmath>
+#include <limits>
+
+#include "UserLexicon.h"
+
+namespace radialkb {
+
+namespace {
+
+// Cost of a letter the tap cannot have meant.
+constexpr float kImpossible = 1.0e9f;
+
+// Signed difference a - b wrapped into (-pi, pi].
+double signedAngle(double a, double b) {
+    double diff = std::fmod(a - b, 2.0 * M_PI);
+    if (diff > M_PI) {
+        diff -= 2.0 * M_PI;
+    } else if (diff <= -M_PI) {
+        diff += 2.0 * M_PI;
+    }
+    return diff;
+}
+
+} // namespace
+
+Autocorrector::Autocorrector(const RadialHitTester &layout, AutocorrectConfig config)
+    : m_layout(&layout),
+      m_config(config) {
+    setLayout(layout);
+}
+
+void Autocorrector::setLayout(const RadialHitTester &layout) {
+    m_layout = &layout;
+    m_sigma.fill(0.0);
+    const int sectors = layout.sectors();
+    for (int sector = 0; sector < sectors; ++sector) {
+        const int keys = layout.keyCount(sector);
+        for (int key = 0; key < keys; ++key) {
+            const KeyAction action = layout.keyAction(sector, key);
+            if (action.type != KeyAction::Char || action.ch < 'a' || action.ch > 'z') {
+                continue;
+            }
+            const LayoutPoint anchor = layout.keyAnchor(sector, key);
+            m_center[action.ch - 'a'] = layout.angleForPoint(anchor.x, anchor.y);
+            m_sigma[action.ch - 'a'] = m_config.sigmaKeyWidths * (2.0 * M_PI / sectors) / keys;
+        }
+    }
+    m_taps.clear();
+    m_overflow = false;
+}
+
+void Autocorrector::noteLetter(char ch, double angle, bool aimed) {
+    if (m_taps.size() >= Dictionary::kMaxWordLength) {
+        m_overflow = true;
+        return;
+    }
+    m_taps.append(Tap{ch, angle, aimed});
+}
+
+void Autocorrector::noteBackspace() {
+    if (m_overflow) {
+        // The start of an overlong word is lost; it is not worth correcting anyway.
+        return;
+    }
+    if (!m_taps.isEmpty()) {
+        m_taps.removeLast();
+    }
+}
+
+void Autocorrector::noteBoundary() {
+    m_taps.clear();
+    m_overflow = false;
+}
+
+AutocorrectResult Autocorrector::finishWord() {
+    AutocorrectResult result = suggest();
+    noteBoundary();
+    return result;
+}
+
+AutocorrectResult Autocorrector::suggest() const {
+    AutocorrectResult result;
+    const int length = m_taps.size();
+    for (const Tap &tap : m_taps) {
+        result.typed.append(tap.ch);
+    }
+    if (!m_enabled || m_overflow || length < 2) {
+        return result;
+    }
+    if (m_lexicon && m_lexicon->wordCount(result.typed) >= m_config.learnedWordMinCount) {
+        return result;
+    }
+    const Dictionary::Bucket &bucket = m_dictionary.wordsOfLength(length);
+    if (bucket.size() == 0) {
+        return result;
+    }
+
+    // cost[i * 26 + c]: negative log-likelihood that tap i was aimed at letter c.
+    QVarLengthArray<float, Dictionary::kMaxWordLength * kLetters> cost(length * kLetters);
+    float typedCost = 0.0f;
+    for (int i = 0; i < length; ++i) {
+        const Tap &tap = m_taps.at(i);
+        if (tap.ch < 'a' || tap.ch > 'z') {
+            return result;
+        }
+        for (int c = 0; c < kLetters; ++c) {
+            float value = kImpossible;
+            if (c == tap.ch - 'a') {
+                value = 0.0f;
+            }
+            if (tap.aimed && m_sigma[c] > 0.0) {
+                const double z = signedAngle(tap.angle, m_center[c]) / m_sigma[c];
+                value = static_cast<float>(0.5 * z * z);
+            }
+            cost[i * kLetters + c] = value;
+        }
+        typedCost += cost[i * kLetters + (tap.ch - 'a')];
+    }
+
+    const double typedScore =
+        -typedCost + m_config.priorWeight * (m_dictionary.minLogPrior() - m_config.unknownWordPenalty);
+    double best = -std::numeric_limits<double>::infinity();
+    double second = best;
+    int bestIndex = -1;
+    for (int index = 0; index < bucket.size(); ++index) {
+        const double prior = m_config.priorWeight * bucket.logPrior.at(index);
+        // Words that cannot beat the typed word do not matter for the decision.
+        const float budget = static_cast<float>(prior - typedScore);
+        const char *word = bucket.word(index);
+        float total = 0.0f;
+        int edits = 0;
+        int i = 0;
+        for (; i < length; ++i) {
+            const int c = word[i] - 'a';
+            if (c != result.typed.at(i) - 'a' && ++edits > m_config.maxEdits) {
+                break;
+            }
+            total += cost[i * kLetters + c];
+            if (total >= budget) {
+                break;
+            }
+        }
+        if (i < length) {
+            continue;
+        }
+        if (edits == 0) {
+            // Never second-guess a dictionary word.
+            return result;
+        }
+        const double score = prior - total;
+        if (score > best) {
+            second = best;
+            best = score;
+            bestIndex = index;
+        } else if (score > second) {
+            second = score;
+        }
+    }
+
+    if (bestIndex >= 0 && best - qMax(second, typedScore) >= m_config.minMargin) {
+        result.corrected = QByteArray(bucket.word(bestIndex), length);
+    }
+    return result;
+}
+
+} // namespace radialkb
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVarLengthArray>
+
+#include <array>
+#include <cstdint>
+
+#include "Dictionary.h"
+#include "RadialHitTester.h"
+
+namespace radialkb {
+
+class UserLexicon;
+
+struct AutocorrectConfig {
+    // Spread of aimed taps around a key center, in key widths.
+    double sigmaKeyWidths = 0.5;
+    // Weight of the word log prior against the spatial log-likelihood.
+    double priorWeight = 1.0;
+    // Extra log penalty for the typed word when it is not in the dictionary.
+    double unknownWordPenalty = 3.0;
+    // Log-likelihood lead the best word needs over the typed word and the runner-up.
+    double minMargin = 2.0;
+    // Letters a correction may change; slips are substitutions of a neighboring key.
+    int maxEdits = 2;
+    // A word the user has committed this often is never corrected, known to the dictionary or not.
+    std::uint32_t learnedWordMinCount = 2;
+};
+
+struct AutocorrectResult {
+    QByteArray typed;
+    // Empty when the typed word stands.
+    QByteArray corrected;
+};
+
+// INTENT: Letter-mode typing slips onto the neighboring key of the same sector or the next
+// INTENT: sector. The autocorrector remembers the layout angle of every tap in the current word
+// INTENT: and, at the word boundary, rescores same-length dictionary words with a Gaussian
+// INTENT: angular likelihood per letter plus the word prior. Only dictionary-unknown words are
+// INTENT: corrected, and only when one candidate clearly wins. Scoring is a table lookup per
+// INTENT: letter with early exit, cheap enough for the space commit path.
+class Autocorrector {
+public:
+    explicit Autocorrector(const RadialHitTester &layout, AutocorrectConfig config = {});
+
+    // Key geometry to score against; call again when the layout changes.
+    void setLayout(const RadialHitTester &layout);
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool enabled() const { return m_enabled; }
+    Dictionary &dictionary() { return m_dictionary; }
+    const Dictionary &dictionary() const { return m_dictionary; }
+    // Words learned from the user's own commits; nullptr disables the check. Not owned.
+    void setUserLexicon(const UserLexicon *lexicon) { m_lexicon = lexicon; }
+
+    // angle is the hit-test angle (RadialHitTester::angleForPoint) of an aimed letter-ring
+    // tap. Letters typed without one (group mode, UI commits) are kept as typed.
+    void noteLetter(char ch, double angle, bool aimed);
+    void noteBackspace();
+    // Any other commit ends the word without correcting it.
+    void noteBoundary();
+
+    // Ends the current word and returns it with its correction, if any.
+    AutocorrectResult finishWord();
+    // Scores the current word without ending it.
+    AutocorrectResult suggest() const;
+
+    int wordLength() const { return m_taps.size(); }
+
+private:
+    struct Tap {
+        char ch;
+        double angle;
+        bool aimed;
+    };
+
+    static constexpr int kLetters = 26;
+
+    const RadialHitTester *m_layout;
+    AutocorrectConfig m_config;
+    Dictionary m_dictionary;
+    const UserLexicon *m_lexicon{nullptr};
+    std::array<double, kLetters> m_center{};
+    std::array<double, kLetters> m_sigma{};  // 0 when the letter is not on the layout
+    QVarLengthArray<Tap, Dictionary::kMaxWordLength> m_taps;
+    bool m_overflow{false};
+    bool m_enabled{true};
+};
+
+} // namespace radialkb
@@ -0,0 +1,36 @@
+#include "ClientSession.h"
+
+#include "HapticsSink.h"
+#include "InputRouter.h"
+#include "Logging.h"
+#include "Metrics.h"
+
+namespace radialkb {
+
+ClientSession::ClientSession(InputRouter &router)
+    : m_router(router) {
+}
+
+ClientSession::~ClientSession() {
+    // Saving and thread shutdown of the probe router are not engine activity either.
+    MetricsMute mute;
+    m_probe.reset();
+}
+
+QByteArray ClientSession::handleLine(const QByteArray &line) {
+    if (m_probe) {
+        Metrics::increment(Counter::MessageProbe);
+        MetricsMute mute;
+        return m_probe->handleMessageUtf8(line);
+    }
+    QByteArray reply = m_router.handleMessageUtf8(line);
+    if (m_router.takeProbeSessionRequest()) {
+        // Measuring never types into the focused app or disturbs the UI's selection.
+        MetricsMute mute;
+        m_probe = std::make_unique<InputRouter>([](const KeyAction &) {}, std::make_unique<NullHapticsSink>());
+        Logging::log(LogLevel::Info, "ENGINE", "probe session started; commits are discarded");
+    }
+    return reply;
+}
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QByteArray>
+
+#include <memory>
+
+// INTENT: One engine socket connection. Lines go to the shared router until the client asks for
+// INTENT: a probe session; from then on they go to a private router whose commits and haptics are
+// INTENT: discarded and whose work is left out of the process-wide metrics.
+
+namespace radialkb {
+
+class InputRouter;
+
+class ClientSession {
+public:
+    explicit ClientSession(InputRouter &router);
+    ~ClientSession();
+
+    ClientSession(const ClientSession &) = delete;
+    ClientSession &operator=(const ClientSession &) = delete;
+
+    // Handles one message line and returns its reply, without the trailing newline.
+    QByteArray handleLine(const QByteArray &line);
+    bool probing() const { return m_probe != nullptr; }
+
+private:
+    InputRouter &m_router;
+    std::unique_ptr<InputRouter> m_probe;
+};
+
+}
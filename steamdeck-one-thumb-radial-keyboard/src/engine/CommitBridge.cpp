@@ -1,44 +1,100 @@
 #include "CommitBridge.h"
 
 #include "Logging.h"
+#include "Metrics.h"
+#include "Trace.h"
 #include "UInputKeyboard.h"
 
+#include <QVarLengthArray>
+
 #include <linux/input.h>
+#include <pthread.h>
 
 namespace radialkb {
 
 namespace {
 
-UInputKeyboard &keyboard() {
-    static UInputKeyboard instance;
-    return instance;
+void emitToKeyboard(UInputKeyboard &keyboard, const KeyAction &action) {
+    switch (action.type) {
+    case KeyAction::Char:
+        keyboard.sendChar(QChar::fromLatin1(action.ch));
+        return;
+    case KeyAction::Space:
+        keyboard.sendKey(KEY_SPACE);
+        return;
+    case KeyAction::Backspace:
+        keyboard.sendKey(KEY_BACKSPACE);
+        return;
+    case KeyAction::Enter:
+        keyboard.sendKey(KEY_ENTER);
+        return;
+    case KeyAction::Tab:
+        keyboard.sendKey(KEY_TAB);
+        return;
+    case KeyAction::Escape:
+        keyboard.sendKey(KEY_ESC);
+        return;
+    case KeyAction::CapsLock:
+        keyboard.sendKey(KEY_CAPSLOCK);
+        return;
+    case KeyAction::DeleteWord:
+        keyboard.sendChord(KEY_LEFTCTRL, KEY_BACKSPACE);
+        return;
+    case KeyAction::None:
+        return;
+    }
 }
 
 } // namespace
 
+CommitBridge::CommitBridge(Sink sink)
+    : m_sink(std::move(sink)) {
+    // A bridge created with metrics muted (a probe session's) keeps its commit thread muted too.
+    m_thread = std::thread([this, muted = Metrics::muted()]() {
+        Metrics::setMuted(muted);
+        run();
+    });
+}
+
+CommitBridge::~CommitBridge() {
+    m_stop.store(true);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_wake.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
 void CommitBridge::commitChar(QChar ch) {
-    keyboard().sendText(QString(ch));
+    const char latin = ch.toLatin1();
+    if (latin == '\0') {
+        Logging::log(LogLevel::Warn, "COMMIT", QString("Unsupported character for commit: '%1'").arg(ch));
+        return;
+    }
+    enqueue(KeyAction::makeChar(latin));
 }
 
 void CommitBridge::commitAction(const QString &action) {
     if (action == "space") {
-        keyboard().sendKey(KEY_SPACE);
+        enqueue(KeyAction::make(KeyAction::Space));
         return;
     }
     if (action == "backspace") {
-        keyboard().sendKey(KEY_BACKSPACE);
+        enqueue(KeyAction::make(KeyAction::Backspace));
         return;
     }
     if (action == "enter") {
-        keyboard().sendKey(KEY_ENTER);
+        enqueue(KeyAction::make(KeyAction::Enter));
         return;
     }
     if (action == "tab") {
-        keyboard().sendKey(KEY_TAB);
+        enqueue(KeyAction::make(KeyAction::Tab));
         return;
     }
     if (action == "escape") {
-        keyboard().sendKey(KEY_ESC);
+        enqueue(KeyAction::make(KeyAction::Escape));
         return;
     }
 
@@ -49,21 +105,157 @@ void CommitBridge::commitAction(const KeyAction &action) {
     if (action.type == KeyAction::None) {
         return;
     }
-    if (action.type == KeyAction::Char) {
-        commitChar(QChar(action.ch));
-        return;
+    enqueue(action);
+}
+
+bool CommitBridge::replace(const QString &oldSuffix, const QString &newText) {
+    if (!m_journal.endsWith(oldSuffix)) {
+        return false;
     }
-    if (action.type == KeyAction::Space) {
-        keyboard().sendKey(KEY_SPACE);
-        return;
+    int common = 0;
+    while (common < oldSuffix.size() && common < newText.size() && oldSuffix.at(common) == newText.at(common)) {
+        ++common;
     }
-    if (action.type == KeyAction::Backspace) {
-        keyboard().sendKey(KEY_BACKSPACE);
-        return;
+    const int backspaces = oldSuffix.size() - common;
+    QVarLengthArray<KeyAction, 32> burst;
+    for (int i = 0; i < backspaces; ++i) {
+        burst.append(KeyAction::make(KeyAction::Backspace));
     }
-    if (action.type == KeyAction::Enter) {
-        keyboard().sendKey(KEY_ENTER);
-        return;
+    for (int i = common; i < newText.size(); ++i) {
+        const char latin = newText.at(i).toLatin1();
+        if (latin == '\0') {
+            Logging::log(LogLevel::Warn, "COMMIT", QString("Unsupported character for replace: '%1'").arg(newText.at(i)));
+            return false;
+        }
+        burst.append(KeyAction::makeChar(latin));
+    }
+    for (int i = 0; i < burst.size(); ++i) {
+        enqueue(burst.at(i), i + 1 < burst.size());
+    }
+    return true;
+}
+
+void CommitBridge::clearJournal() {
+    m_journal.clear();
+}
+
+void CommitBridge::journalAction(const KeyAction &action) {
+    switch (action.type) {
+    case KeyAction::Char:
+        m_journal.append(QChar::fromLatin1(action.ch));
+        break;
+    case KeyAction::Space:
+        m_journal.append(QChar(' '));
+        break;
+    case KeyAction::Enter:
+        m_journal.append(QChar('\n'));
+        break;
+    case KeyAction::Tab:
+        m_journal.append(QChar('\t'));
+        break;
+    case KeyAction::Backspace:
+        m_journal.chop(1);
+        break;
+    case KeyAction::Escape:
+    case KeyAction::CapsLock:
+        break;
+    case KeyAction::DeleteWord: {
+        // Same span as ctrl+backspace in most editors: trailing spaces, then the word.
+        int end = m_journal.size();
+        while (end > 0 && m_journal.at(end - 1).isSpace()) {
+            --end;
+        }
+        while (end > 0 && !m_journal.at(end - 1).isSpace()) {
+            --end;
+        }
+        m_journal.truncate(end);
+        break;
+    }
+    case KeyAction::None:
+        break;
+    }
+    if (m_journal.size() > kJournalCapacity * 2) {
+        // Trim in chunks so appends stay amortized O(1).
+        m_journal.remove(0, m_journal.size() - kJournalCapacity);
+    }
+}
+
+void CommitBridge::flush() {
+    const std::uint64_t target = m_enqueued;
+    m_flushPending.store(true);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_drained.wait(lock, [this, target]() { return m_emitted.load() >= target; });
+    m_flushPending.store(false);
+}
+
+void CommitBridge::enqueue(const KeyAction &action, bool burstContinues) {
+    journalAction(action);
+    // Never drop a keystroke: if the commit thread is this far behind, wait for room.
+    while (!m_queue.push(QueuedAction{action, burstContinues})) {
+        if (!m_overflowLogged) {
+            Logging::log(LogLevel::Warn, "COMMIT", "commit queue full; waiting for commit thread");
+            m_overflowLogged = true;
+        }
+        std::this_thread::yield();
+    }
+    ++m_enqueued;
+    const auto depth = static_cast<std::int64_t>(m_queue.size());
+    Metrics::setGauge(Gauge::CommitQueueDepth, depth);
+    Metrics::raiseGauge(Gauge::CommitQueueDepthMax, depth);
+
+    // Pairs with the fence in run(): either the consumer sees the new item before
+    // sleeping, or we see it sleeping and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed)) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+        }
+        m_wake.notify_one();
+    }
+}
+
+void CommitBridge::run() {
+    // Shows up in traces and top -H.
+    pthread_setname_np(pthread_self(), "radialkb-commit");
+    UInputKeyboard keyboard;
+    QueuedAction item;
+    bool inBurst = false;
+    for (;;) {
+        while (m_queue.pop(item)) {
+            TraceSpan span("uinputEmit");
+            if (m_sink) {
+                m_sink(item.action);
+            } else {
+                // A burst may span a sleep if the producer is still pushing it; the keyboard
+                // keeps buffering until its last action arrives.
+                if (item.burstContinues && !inBurst) {
+                    keyboard.beginBatch();
+                    inBurst = true;
+                }
+                emitToKeyboard(keyboard, item.action);
+                if (!item.burstContinues && inBurst) {
+                    keyboard.endBatch();
+                    inBurst = false;
+                }
+            }
+            m_emitted.fetch_add(1);
+            Metrics::setGauge(Gauge::CommitQueueDepth, static_cast<std::int64_t>(m_queue.size()));
+        }
+        if (m_flushPending.load()) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+            }
+            m_drained.notify_all();
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_wake.wait(lock, [this]() { return m_stop.load() || !m_queue.empty(); });
+        m_sleeping.store(false, std::memory_order_relaxed);
+        if (m_stop.load() && m_queue.empty()) {
+            break;
+        }
     }
 }
 
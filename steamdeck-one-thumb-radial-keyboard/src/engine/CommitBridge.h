@@ -3,32 +3,78 @@
 #include <QChar>
 #include <QString>
 
-namespace radialkb {
-
-struct KeyAction {
-    enum Type { None, Char, Space, Backspace, Enter };
-    Type type{None};
-    char ch{'\0'};
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
 
-    static KeyAction makeChar(char value) {
-        KeyAction action;
-        action.type = Char;
-        action.ch = value;
-        return action;
-    }
+#include "KeyAction.h"
+#include "SpscQueue.h"
 
-    static KeyAction make(Type value) {
-        KeyAction action;
-        action.type = value;
-        return action;
-    }
-};
+namespace radialkb {
 
+// INTENT: Keystroke emission runs on a dedicated commit thread so a slow or failing
+// INTENT: uinput write never delays touch processing on the Qt event loop.
+// INTENT: Actions are emitted strictly in the order they were committed. A bounded journal of
+// INTENT: the text typed so far lets callers rewrite their own recent output with minimal edits.
 class CommitBridge {
 public:
+    // Receives every action on the commit thread. When empty, actions go to uinput.
+    using Sink = std::function<void(const KeyAction &)>;
+
+    explicit CommitBridge(Sink sink = {});
+    ~CommitBridge();
+
+    CommitBridge(const CommitBridge &) = delete;
+    CommitBridge &operator=(const CommitBridge &) = delete;
+
     void commitChar(QChar ch);
     void commitAction(const QString &action);
     void commitAction(const KeyAction &action);
+
+    // Replaces oldSuffix at the end of the typed text with newText: backspaces back to the
+    // common prefix, then types the rest, all as one uinput write. Returns false and emits
+    // nothing when the journal does not end with oldSuffix.
+    bool replace(const QString &oldSuffix, const QString &newText);
+
+    // Most recent typed text (at most kJournalCapacity characters), as far as this bridge knows.
+    const QString &journal() const { return m_journal; }
+    // Forget the journal, e.g. when focus may have moved to another text field.
+    void clearJournal();
+
+    // Blocks until every action committed so far has reached the sink.
+    void flush();
+
+    static constexpr int kJournalCapacity = 256;
+
+private:
+    static constexpr std::size_t kQueueCapacity = 256;
+
+    struct QueuedAction {
+        KeyAction action;
+        // Set on every action of a burst but the last; the commit thread writes a burst at once.
+        bool burstContinues = false;
+    };
+
+    void enqueue(const KeyAction &action, bool burstContinues = false);
+    void journalAction(const KeyAction &action);
+    void run();
+
+    Sink m_sink;
+    SpscQueue<QueuedAction, kQueueCapacity> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_drained;
+    std::atomic<bool> m_sleeping{false};
+    std::atomic<bool> m_flushPending{false};
+    std::atomic<bool> m_stop{false};
+    std::atomic<std::uint64_t> m_emitted{0};
+    std::uint64_t m_enqueued{0};
+    bool m_overflowLogged{false};
+    QString m_journal;
+    std::thread m_thread;
 };
 
 }
@@ -0,0 +1,167 @@
+#include "Dictionary.h"
+
+#include <QFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QtGlobal>
+
+#include <cmath>
+#include <cstring>
+
+#include "Logging.h"
+
+namespace radialkb {
+
+namespace {
+
+// Most frequent English words, in rank order. Enough to be useful without a word list file.
+const char *const kBuiltinWords[] = {
+    "the", "of", "and", "to", "a", "in", "is", "it", "you", "that", "he", "was", "for", "on",
+    "are", "with", "as", "i", "his", "they", "be", "at", "one", "have", "this", "from", "or",
+    "had", "by", "not", "word", "but", "what", "some", "we", "can", "out", "other", "were",
+    "all", "there", "when", "up", "use", "your", "how", "said", "an", "each", "she", "which",
+    "do", "their", "time", "if", "will", "way", "about", "many", "then", "them", "write",
+    "would", "like", "so", "these", "her", "long", "make", "thing", "see", "him", "two",
+    "has", "look", "more", "day", "could", "go", "come", "did", "number", "sound", "no",
+    "most", "people", "my", "over", "know", "water", "than", "call", "first", "who", "may",
+    "down", "side", "been", "now", "find", "any", "new", "work", "part", "take", "get",
+    "place", "made", "live", "where", "after", "back", "little", "only", "round", "man",
+    "year", "came", "show", "every", "good", "me", "give", "our", "under", "name", "very",
+    "through", "just", "form", "sentence", "great", "think", "say", "help", "low", "line",
+    "differ", "turn", "cause", "much", "mean", "before", "move", "right", "boy", "old",
+    "too", "same", "tell", "does", "set", "three", "want", "air", "well", "also", "play",
+    "small", "end", "put", "home", "read", "hand", "port", "large", "spell", "add", "even",
+    "land", "here", "must", "big", "high", "such", "follow", "act", "why", "ask", "men",
+    "change", "went", "light", "kind", "off", "need", "house", "picture", "try", "us",
+    "again", "animal", "point", "mother", "world", "near", "build", "self", "earth",
+    "father", "head", "stand", "own", "page", "should", "country", "found", "answer",
+    "school", "grow", "study", "still", "learn", "plant", "cover", "food", "sun", "four",
+    "between", "state", "keep", "eye", "never", "last", "let", "thought", "city", "tree",
+    "cross", "farm", "hard", "start", "might", "story", "saw", "far", "sea", "draw", "left",
+    "late", "run", "while", "press", "close", "night", "real", "life", "few", "north",
+    "open", "seem", "together", "next", "white", "children", "begin", "got", "walk",
+    "example", "ease", "paper", "group", "always", "music", "those", "both", "mark",
+    "often", "letter", "until", "mile", "river", "car", "feet", "care", "second", "book",
+    "carry", "took", "science", "eat", "room", "friend", "began", "idea", "fish",
+    "mountain", "stop", "once", "base", "hear", "horse", "cut", "sure", "watch", "color",
+    "face", "wood", "main", "enough", "plain", "girl", "usual", "young", "ready", "above",
+    "ever", "red", "list", "though", "feel", "talk", "bird", "soon", "body", "dog",
+    "family", "direct", "pose", "leave", "song", "measure", "door", "product", "black",
+    "short", "numeral", "class", "wind", "question", "happen", "complete", "ship", "area",
+    "half", "rock", "order", "fire", "south", "problem", "piece", "told", "knew", "pass",
+    "since", "top", "whole", "king", "space", "heard", "best", "hour", "better", "true",
+    "during", "hundred", "five", "remember", "step", "early", "hold", "west", "ground",
+    "interest", "reach", "fast", "verb", "sing", "listen", "six", "table", "travel", "less",
+    "morning", "ten", "simple", "several", "vowel", "toward", "war", "lay", "against",
+    "pattern", "slow", "center", "love", "person", "money", "serve", "appear", "road",
+    "map", "rain", "rule", "govern", "pull", "cold", "notice", "voice", "unit", "power",
+    "town", "fine", "certain", "fly", "fall", "lead", "cry", "dark", "machine", "note",
+    "wait", "plan", "figure", "star", "box", "noun", "field", "rest", "correct", "able",
+    "pound", "done", "beauty", "drive", "stood", "contain", "front", "teach", "week",
+    "final", "gave", "green", "oh", "quick", "develop", "ocean", "warm", "free", "minute",
+    "strong", "special", "mind", "behind", "clear", "tail", "produce", "fact", "street",
+    "inch", "multiply", "nothing", "course", "stay", "wheel", "full", "force", "blue",
+    "object", "decide", "surface", "deep", "moon", "island", "foot", "system", "busy",
+    "test", "record", "boat", "common", "gold", "possible", "plane", "stead", "dry",
+    "wonder", "laugh", "thousand", "ago", "ran", "check", "game", "shape", "equate", "hot",
+    "miss", "brought", "heat", "snow", "tire", "bring", "yes", "distant", "fill", "east",
+    "paint", "language", "among", "ok", "thanks", "hello", "please", "sorry", "today",
+    "tomorrow", "yesterday", "type", "keyboard", "deck", "steam",
+};
+
+} // namespace
+
+Dictionary::Dictionary() {
+    loadBuiltin();
+}
+
+void Dictionary::loadBuiltin() {
+    QVector<Entry> entries;
+    const int count = static_cast<int>(sizeof(kBuiltinWords) / sizeof(kBuiltinWords[0]));
+    entries.reserve(count);
+    for (int rank = 0; rank < count; ++rank) {
+        // Zipf: frequency ~ 1 / rank.
+        entries.push_back(Entry{QByteArray(kBuiltinWords[rank]), 1.0 / (rank + 1)});
+    }
+    rebuild(entries);
+}
+
+bool Dictionary::load(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    QVector<Entry> entries;
+    QSet<QByteArray> seen;
+    int rank = 0;
+    while (!file.atEnd()) {
+        const QList<QByteArray> fields = file.readLine().simplified().split(' ');
+        const QByteArray word = fields.value(0).toLower();
+        if (word.isEmpty() || word.startsWith('#') || word.size() > kMaxWordLength) {
+            continue;
+        }
+        bool letters = true;
+        for (char ch : word) {
+            letters = letters && ch >= 'a' && ch <= 'z';
+        }
+        if (!letters || seen.contains(word)) {
+            continue;
+        }
+        seen.insert(word);
+        ++rank;
+        bool hasCount = false;
+        const double count = fields.size() > 1 ? fields.at(1).toDouble(&hasCount) : 0.0;
+        entries.push_back(Entry{word, hasCount && count > 0.0 ? count : 1.0 / rank});
+    }
+    if (entries.isEmpty()) {
+        Logging::log(LogLevel::Warn, "DICT", QString("no usable words in %1").arg(path));
+        return false;
+    }
+    rebuild(entries);
+    return true;
+}
+
+void Dictionary::rebuild(const QVector<Entry> &entries) {
+    double maxWeight = 0.0;
+    for (const Entry &entry : entries) {
+        maxWeight = qMax(maxWeight, entry.weight);
+    }
+    m_byLength.clear();
+    m_byLength.resize(kMaxWordLength + 1);
+    for (int length = 0; length <= kMaxWordLength; ++length) {
+        m_byLength[length].length = length;
+    }
+    m_minLogPrior = 0.0;
+    for (const Entry &entry : entries) {
+        Bucket &bucket = m_byLength[entry.word.size()];
+        const float logPrior = static_cast<float>(std::log(entry.weight / maxWeight));
+        bucket.letters.append(entry.word);
+        bucket.logPrior.push_back(logPrior);
+        m_minLogPrior = qMin(m_minLogPrior, static_cast<double>(logPrior));
+    }
+    m_size = entries.size();
+}
+
+const Dictionary::Bucket &Dictionary::wordsOfLength(int length) const {
+    static const Bucket kEmpty;
+    if (length <= 0 || length >= m_byLength.size()) {
+        return kEmpty;
+    }
+    return m_byLength.at(length);
+}
+
+bool Dictionary::contains(const QByteArray &word) const {
+    const Bucket &bucket = wordsOfLength(word.size());
+    for (int i = 0; i < bucket.size(); ++i) {
+        if (std::memcmp(bucket.word(i), word.constData(), word.size()) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QString Dictionary::defaultPath() {
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/radialkb/words.txt";
+}
+
+} // namespace radialkb
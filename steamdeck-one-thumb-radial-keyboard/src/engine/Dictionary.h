@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// INTENT: Read-only word list with unigram log priors, bucketed by word length so decoders
+// INTENT: only scan candidates that can match. Words are lowercase a-z and stored back to back
+// INTENT: per bucket to keep scans cache friendly.
+
+namespace radialkb {
+
+class Dictionary {
+public:
+    static constexpr int kMaxWordLength = 24;
+
+    struct Bucket {
+        int length = 0;
+        QByteArray letters;       // size() * length bytes, no separators
+        QVector<float> logPrior;  // <= 0; the most frequent word is ~0
+
+        int size() const { return logPrior.size(); }
+        const char *word(int index) const { return letters.constData() + index * length; }
+    };
+
+    // Starts with the small built-in English list.
+    Dictionary();
+
+    // One word per line, optionally followed by whitespace and a count. Without counts the
+    // line order is taken as frequency rank. Replaces the current contents on success.
+    bool load(const QString &path);
+    void loadBuiltin();
+
+    int size() const { return m_size; }
+    const Bucket &wordsOfLength(int length) const;
+    bool contains(const QByteArray &word) const;
+    // Log prior of the least frequent word; a floor for unknown words.
+    double minLogPrior() const { return m_minLogPrior; }
+
+    // User word list under the XDG data directory; may not exist.
+    static QString defaultPath();
+
+private:
+    struct Entry {
+        QByteArray word;
+        double weight;
+    };
+
+    void rebuild(const QVector<Entry> &entries);
+
+    QVector<Bucket> m_byLength;
+    int m_size{0};
+    double m_minLogPrior{0.0};
+};
+
+} // namespace radialkb
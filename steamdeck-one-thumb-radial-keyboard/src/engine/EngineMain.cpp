@@ -2,10 +2,17 @@
 #include <QFile>
 #include <QLocalServer>
 #include <QLocalSocket>
+#include <QSocketNotifier>
 #include <QStandardPaths>
+#include <csignal>
+#include <sys/socket.h>
 #include <unistd.h>
+#include <memory>
+#include "ClientSession.h"
 #include "InputRouter.h"
 #include "Logging.h"
+#include "Metrics.h"
+#include "Trace.h"
 
 using namespace radialkb;
 
@@ -17,6 +24,33 @@ QString socketPath() {
     }
     return QString("/tmp/radialkb-%1.sock").arg(getuid());
 }
+
+int g_signalFds[2] = {-1, -1};
+
+void onTerminateSignal(int) {
+    const char byte = 1;
+    [[maybe_unused]] const ssize_t written = write(g_signalFds[0], &byte, 1);
+}
+
+// SIGTERM (systemd stop) and SIGINT leave the event loop normally, so destructors and
+// aboutToQuit handlers (touch model save, trace dump) still run.
+void quitOnTerminateSignals(QCoreApplication &app) {
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, g_signalFds) != 0) {
+        return;
+    }
+    auto *notifier = new QSocketNotifier(g_signalFds[1], QSocketNotifier::Read, &app);
+    QObject::connect(notifier, &QSocketNotifier::activated, &app, [&app]() {
+        char byte = 0;
+        [[maybe_unused]] const ssize_t bytes = read(g_signalFds[1], &byte, 1);
+        app.quit();
+    });
+    struct sigaction action {};
+    action.sa_handler = onTerminateSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
+}
 }
 
 int main(int argc, char *argv[]) {
@@ -26,6 +60,24 @@ int main(int argc, char *argv[]) {
     QCoreApplication::setOrganizationDomain("radialkb.local");
     QCoreApplication::setApplicationName("radialkb-engine");
     Logging::init("ENGINE");
+    // Per-sample debug logging allocates on every touch_move; opt in with RADIALKB_LOG_LEVEL=debug.
+    Logging::setMinLevel(qgetenv("RADIALKB_LOG_LEVEL") == "debug" ? LogLevel::Debug : LogLevel::Info);
+    quitOnTerminateSignals(app);
+
+    // RADIALKB_TRACE=1 (or =<file>) records pipeline spans from startup and dumps them on exit.
+    const QString traceSetting = qEnvironmentVariable("RADIALKB_TRACE");
+    if (!traceSetting.isEmpty() && traceSetting != "0") {
+        const QString tracePath = traceSetting == "1" ? Trace::defaultPath() : traceSetting;
+        Trace::setEnabled(true);
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, [tracePath]() {
+            int events = 0;
+            if (Trace::dumpToFile(tracePath, &events)) {
+                Logging::log(LogLevel::Info, "ENGINE", QString("wrote %1 trace events to %2").arg(events).arg(tracePath));
+            } else {
+                Logging::log(LogLevel::Warn, "ENGINE", QString("failed to write trace to %1").arg(tracePath));
+            }
+        });
+    }
 
     const QString path = socketPath();
     if (QFile::exists(path) && !QLocalServer::removeServer(path)) {
@@ -38,22 +90,81 @@ int main(int argc, char *argv[]) {
     }
 
     InputRouter router;
+    // Learned per-user key offsets; RADIALKB_ADAPTIVE=0 hit-tests against the plain layout.
+    if (qgetenv("RADIALKB_ADAPTIVE") == "0") {
+        router.setAdaptiveTouchEnabled(false);
+    } else {
+        router.setTouchModelPath(AdaptiveTouchModel::defaultPath());
+    }
+    // Swipe gates fitted to this user's taps and swipes; RADIALKB_GESTURE_TUNING=0 keeps the defaults.
+    if (qgetenv("RADIALKB_GESTURE_TUNING") == "0") {
+        router.setGestureTuningEnabled(false);
+    } else {
+        router.setGestureTuningPath(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation)
+                                    + "/radialkb/gesture_tuning.bin");
+    }
+    if (qgetenv("RADIALKB_AUTOCORRECT") == "0") {
+        router.setAutocorrectEnabled(false);
+    } else {
+        const QString dictionary = qEnvironmentVariable("RADIALKB_DICTIONARY", Dictionary::defaultPath());
+        if (QFile::exists(dictionary) && !router.setDictionaryPath(dictionary)) {
+            Logging::log(LogLevel::Warn, "ENGINE", QString("could not load dictionary %1; using built-in words").arg(dictionary));
+        }
+    }
+
+    // Learned words persist under the data directory; RADIALKB_LEARNING=0 keeps them in memory.
+    if (qgetenv("RADIALKB_LEARNING") != "0") {
+        const QString learning = UserLexicon::defaultDirectory();
+        if (!router.setLearningDirectory(learning)) {
+            Logging::log(LogLevel::Warn, "ENGINE", QString("could not open learning store %1").arg(learning));
+        }
+    }
+
+    // Swipe word templates are mapped from XDG_CACHE_HOME, or built there in the background on
+    // first start; RADIALKB_SWIPE_DECODER=0 turns swipe_decode off.
+    if (qgetenv("RADIALKB_SWIPE_DECODER") != "0") {
+        router.enableSwipeDecoding(SwipeTemplateStore::defaultCacheDirectory());
+    }
+
+    // Built-in shape gestures plus any user templates; RADIALKB_SHAPES=0 turns them off.
+    if (qgetenv("RADIALKB_SHAPES") == "0") {
+        router.setShapeGesturesEnabled(false);
+    } else {
+        const QString gestures = qEnvironmentVariable("RADIALKB_GESTURES", PointCloudRecognizer::defaultPath());
+        if (QFile::exists(gestures) && !router.loadShapeTemplates(gestures)) {
+            Logging::log(LogLevel::Warn, "ENGINE", QString("could not load gesture templates %1; using built-in shapes").arg(gestures));
+        }
+    }
+
+    // Left pad picks the sector, right pad picks the key; the UI can also switch with pad_mode.
+    if (qgetenv("RADIALKB_DUAL_PAD") == "1") {
+        router.setDualPadEnabled(true);
+    }
+
+    StallMonitor stallMonitor;
+    // While the overlay is hidden the engine has no timers: it sleeps in poll() until the next
+    // message, and the commit and haptics threads block on their condition variables.
+    QObject::connect(&router, &InputRouter::parkedChanged, &stallMonitor,
+                     [&stallMonitor](bool parked) { stallMonitor.setActive(!parked); });
 
     QObject::connect(&server, &QLocalServer::newConnection, [&]() {
         auto *socket = server.nextPendingConnection();
+        Metrics::addGauge(Gauge::ConnectedClients, 1);
         Logging::log(LogLevel::Info, "ENGINE", "ui connected");
-        QObject::connect(socket, &QLocalSocket::readyRead, [socket, &router]() {
+        // A probe session (radialkbctl probe) switches the connection to a router of its own.
+        auto session = std::make_shared<ClientSession>(router);
+        QObject::connect(socket, &QLocalSocket::readyRead, [socket, session]() {
             while (socket->canReadLine()) {
                 const QByteArray line = socket->readLine().trimmed();
                 if (line.isEmpty()) {
                     continue;
                 }
-                const QString response = router.handleMessage(QString::fromUtf8(line));
-                socket->write(response.toUtf8());
-                socket->write("\n");
+                socket->write(session->handleLine(line));
+                socket->write("\n", 1);
             }
         });
         QObject::connect(socket, &QLocalSocket::disconnected, [socket]() {
+            Metrics::addGauge(Gauge::ConnectedClients, -1);
             socket->deleteLater();
         });
     });
@@ -2,18 +2,138 @@
 
 #include "Logging.h"
 
+#include <chrono>
+
 namespace radialkb {
 
+namespace {
+
+std::int64_t steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+HapticsScheduler::HapticsScheduler(HapticsTiming timing)
+    : m_timing(timing) {
+}
+
+bool HapticsScheduler::submit(HapticPulse pulse) {
+    if (pulse == HapticPulse::None) {
+        return false;
+    }
+    const std::int64_t previousDue = nextDueMs();
+    if (pulse == HapticPulse::Tick) {
+        if (m_tickPending || m_queued > 0) {
+            ++m_coalesced;
+            return false;
+        }
+        m_tickPending = true;
+    } else {
+        if (m_tickPending) {
+            m_tickPending = false;
+            ++m_coalesced;
+        }
+        if (m_queued == kMaxQueued) {
+            ++m_coalesced;
+            return false;
+        }
+        m_queue[(m_head + m_queued) % kMaxQueued] = pulse;
+        ++m_queued;
+    }
+    const std::int64_t due = nextDueMs();
+    return previousDue < 0 || due < previousDue;
+}
+
+HapticPulse HapticsScheduler::takeDue(std::int64_t nowMs) {
+    const std::int64_t due = nextDueMs();
+    if (due < 0 || nowMs < due) {
+        return HapticPulse::None;
+    }
+    HapticPulse pulse = HapticPulse::Tick;
+    if (m_queued > 0) {
+        pulse = m_queue[m_head];
+        m_head = (m_head + 1) % kMaxQueued;
+        --m_queued;
+    } else {
+        m_tickPending = false;
+    }
+    m_lastFireMs = nowMs;
+    ++m_fired;
+    return pulse;
+}
+
+std::int64_t HapticsScheduler::nextDueMs() const {
+    if (m_queued == 0 && !m_tickPending) {
+        return -1;
+    }
+    if (m_lastFireMs < 0) {
+        return 0;
+    }
+    return m_lastFireMs + m_timing.minIntervalMs;
+}
+
+Haptics::Haptics(std::unique_ptr<HapticsSink> sink, HapticsTiming timing)
+    : m_sink(sink ? std::move(sink) : createDefaultHapticsSink()),
+      m_scheduler(timing) {
+    m_thread = std::thread([this]() { run(); });
+}
+
+Haptics::~Haptics() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
 void Haptics::onSelectionChange() {
-    Logging::log(LogLevel::Debug, "ENGINE", "haptics selection (stub)");
+    submit(HapticPulse::Tick);
 }
 
 void Haptics::onCommit() {
-    Logging::log(LogLevel::Debug, "ENGINE", "haptics commit (stub)");
+    submit(HapticPulse::Commit);
 }
 
 void Haptics::onCancel() {
-    Logging::log(LogLevel::Debug, "ENGINE", "haptics cancel (stub)");
+    submit(HapticPulse::Cancel);
+}
+
+void Haptics::submit(HapticPulse pulse) {
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        wake = m_scheduler.submit(pulse);
+    }
+    // Coalesced pulses leave the timer thread asleep; only a new earliest deadline wakes it.
+    if (wake) {
+        m_wake.notify_one();
+    }
+}
+
+void Haptics::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+        const std::int64_t due = m_scheduler.nextDueMs();
+        if (due < 0) {
+            m_wake.wait(lock);
+            continue;
+        }
+        const std::int64_t now = steadyNowMs();
+        if (now < due) {
+            m_wake.wait_for(lock, std::chrono::milliseconds(due - now));
+            continue;
+        }
+        const HapticPulse pulse = m_scheduler.takeDue(now);
+        lock.unlock();
+        m_sink->play(pulse);
+        lock.lock();
+    }
 }
 
 }
@@ -1,12 +1,79 @@
 #pragma once
 
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "HapticsSink.h"
+
 namespace radialkb {
 
+struct HapticsTiming {
+    // Minimum gap between any two pulses; bursts inside it coalesce into one.
+    int minIntervalMs = 35;
+};
+
+// Pure scheduling policy, driven by explicit timestamps so it can be tested without threads.
+// - Ticks arriving while a pulse is pending or inside the interval coalesce into one tick.
+// - Commit/Cancel pulses replace a pending tick; a pending tick never replaces them.
+// - Commit/Cancel pulses are never coalesced with each other: each one is deferred behind the
+//   previous one by the interval. Only a burst beyond kMaxQueued of them drops the excess.
+class HapticsScheduler {
+public:
+    static constexpr int kMaxQueued = 4;
+
+    explicit HapticsScheduler(HapticsTiming timing = {});
+
+    // Returns true when the earliest due time moved earlier (the timer needs a wakeup).
+    bool submit(HapticPulse pulse);
+    // Pops the pending pulse if it is due at nowMs.
+    HapticPulse takeDue(std::int64_t nowMs);
+    // Earliest time the pending pulse may fire, or -1 when idle.
+    std::int64_t nextDueMs() const;
+
+    std::uint64_t fired() const { return m_fired; }
+    std::uint64_t coalesced() const { return m_coalesced; }
+
+private:
+    HapticsTiming m_timing;
+    // Commit/Cancel pulses in submission order, as a ring of m_queued entries from m_head.
+    std::array<HapticPulse, kMaxQueued> m_queue{};
+    int m_head{0};
+    int m_queued{0};
+    bool m_tickPending{false};
+    std::int64_t m_lastFireMs{-1};
+    std::uint64_t m_fired{0};
+    std::uint64_t m_coalesced{0};
+};
+
+// INTENT: Haptics fire only on meaningful transitions and never buzz.
+// INTENT: Selection-path calls only update the scheduler; the sink runs on the haptics thread.
 class Haptics {
 public:
+    // A null sink selects the device from the environment (see createDefaultHapticsSink()).
+    explicit Haptics(std::unique_ptr<HapticsSink> sink = nullptr, HapticsTiming timing = {});
+    ~Haptics();
+
+    Haptics(const Haptics &) = delete;
+    Haptics &operator=(const Haptics &) = delete;
+
     void onSelectionChange();
     void onCommit();
     void onCancel();
+
+private:
+    void submit(HapticPulse pulse);
+    void run();
+
+    std::unique_ptr<HapticsSink> m_sink;
+    HapticsScheduler m_scheduler;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stop{false};
+    std::thread m_thread;
 };
 
 }
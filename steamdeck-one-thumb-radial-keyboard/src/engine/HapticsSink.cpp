@@ -0,0 +1,193 @@
+#include "HapticsSink.h"
+
+#include "Logging.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/hidraw.h>
+#include <linux/input.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <QtGlobal>
+
+#include <cstdint>
+
+namespace radialkb {
+
+namespace {
+
+QString errnoString() {
+    return QString::fromLocal8Bit(strerror(errno));
+}
+
+// Matches ID_TRIGGER_HAPTIC_PULSE in the kernel hid-steam driver.
+constexpr std::uint8_t kSteamHapticPulseReport = 0x8f;
+// Left pad in the report's (historically swapped) pad numbering.
+constexpr std::uint8_t kSteamLeftPad = 1;
+constexpr int kSteamFeatureReportSize = 64;
+
+struct PulseShape {
+    std::uint16_t onUs;
+    std::uint16_t offUs;
+    std::uint16_t repeat;
+};
+
+PulseShape steamPulseShape(HapticPulse pulse) {
+    switch (pulse) {
+    case HapticPulse::Tick:
+        return {1200, 0, 1};
+    case HapticPulse::Commit:
+        return {2500, 4000, 2};
+    case HapticPulse::Cancel:
+        return {6000, 0, 1};
+    case HapticPulse::None:
+        break;
+    }
+    return {0, 0, 0};
+}
+
+} // namespace
+
+const char *hapticPulseToString(HapticPulse pulse) {
+    switch (pulse) {
+    case HapticPulse::None:
+        return "None";
+    case HapticPulse::Tick:
+        return "Tick";
+    case HapticPulse::Commit:
+        return "Commit";
+    case HapticPulse::Cancel:
+        return "Cancel";
+    }
+    return "None";
+}
+
+EvdevFfHapticsSink::EvdevFfHapticsSink(const QString &devicePath) {
+    m_fd = open(devicePath.toLocal8Bit().constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0) {
+        Logging::log(LogLevel::Warn, "HAPTICS",
+                     QString("Unable to open %1 (%2).").arg(devicePath, errnoString()));
+        return;
+    }
+    m_tickId = uploadRumble(8, 0x3000);
+    m_commitId = uploadRumble(20, 0x7000);
+    m_cancelId = uploadRumble(45, 0x5000);
+    if (m_tickId < 0 || m_commitId < 0 || m_cancelId < 0) {
+        Logging::log(LogLevel::Warn, "HAPTICS",
+                     QString("%1 does not accept FF_RUMBLE effects (%2).").arg(devicePath, errnoString()));
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    Logging::log(LogLevel::Info, "HAPTICS", QString("force-feedback haptics on %1").arg(devicePath));
+}
+
+EvdevFfHapticsSink::~EvdevFfHapticsSink() {
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+int EvdevFfHapticsSink::uploadRumble(int durationMs, int magnitude) {
+    ff_effect effect{};
+    effect.type = FF_RUMBLE;
+    effect.id = -1;
+    effect.replay.length = static_cast<std::uint16_t>(durationMs);
+    effect.u.rumble.strong_magnitude = static_cast<std::uint16_t>(magnitude);
+    effect.u.rumble.weak_magnitude = static_cast<std::uint16_t>(magnitude);
+    if (ioctl(m_fd, EVIOCSFF, &effect) < 0) {
+        return -1;
+    }
+    return effect.id;
+}
+
+void EvdevFfHapticsSink::play(HapticPulse pulse) {
+    if (m_fd < 0) {
+        return;
+    }
+    int effectId = -1;
+    switch (pulse) {
+    case HapticPulse::Tick:
+        effectId = m_tickId;
+        break;
+    case HapticPulse::Commit:
+        effectId = m_commitId;
+        break;
+    case HapticPulse::Cancel:
+        effectId = m_cancelId;
+        break;
+    case HapticPulse::None:
+        return;
+    }
+    input_event event{};
+    event.type = EV_FF;
+    event.code = static_cast<std::uint16_t>(effectId);
+    event.value = 1;
+    if (write(m_fd, &event, sizeof(event)) != static_cast<ssize_t>(sizeof(event)) && !m_errorLogged) {
+        Logging::log(LogLevel::Error, "HAPTICS", QString("force-feedback write failed (%1).").arg(errnoString()));
+        m_errorLogged = true;
+    }
+}
+
+HidrawHapticsSink::HidrawHapticsSink(const QString &devicePath) {
+    m_fd = open(devicePath.toLocal8Bit().constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0) {
+        Logging::log(LogLevel::Warn, "HAPTICS",
+                     QString("Unable to open %1 (%2).").arg(devicePath, errnoString()));
+        return;
+    }
+    Logging::log(LogLevel::Info, "HAPTICS", QString("hidraw haptics on %1").arg(devicePath));
+}
+
+HidrawHapticsSink::~HidrawHapticsSink() {
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+void HidrawHapticsSink::play(HapticPulse pulse) {
+    if (m_fd < 0 || pulse == HapticPulse::None) {
+        return;
+    }
+    const PulseShape shape = steamPulseShape(pulse);
+    // Byte 0 is the HID report number (unnumbered), followed by the Steam command.
+    std::uint8_t report[kSteamFeatureReportSize + 1] = {};
+    report[1] = kSteamHapticPulseReport;
+    report[2] = 8;
+    report[3] = kSteamLeftPad;
+    report[4] = shape.onUs & 0xff;
+    report[5] = shape.onUs >> 8;
+    report[6] = shape.offUs & 0xff;
+    report[7] = shape.offUs >> 8;
+    report[8] = shape.repeat & 0xff;
+    report[9] = shape.repeat >> 8;
+    report[10] = 0;
+    if (ioctl(m_fd, HIDIOCSFEATURE(sizeof(report)), report) < 0 && !m_errorLogged) {
+        Logging::log(LogLevel::Error, "HAPTICS", QString("hidraw feature report failed (%1).").arg(errnoString()));
+        m_errorLogged = true;
+    }
+}
+
+std::unique_ptr<HapticsSink> createDefaultHapticsSink() {
+    const QString device = QString::fromLocal8Bit(qgetenv("RADIALKB_HAPTICS_DEVICE"));
+    if (device.isEmpty()) {
+        Logging::log(LogLevel::Info, "HAPTICS", "no RADIALKB_HAPTICS_DEVICE set; haptics disabled");
+        return std::make_unique<NullHapticsSink>();
+    }
+    if (device.contains(QStringLiteral("hidraw"))) {
+        auto sink = std::make_unique<HidrawHapticsSink>(device);
+        if (sink->available()) {
+            return sink;
+        }
+    } else {
+        auto sink = std::make_unique<EvdevFfHapticsSink>(device);
+        if (sink->available()) {
+            return sink;
+        }
+    }
+    return std::make_unique<NullHapticsSink>();
+}
+
+} // namespace radialkb
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QString>
+
+#include <memory>
+
+namespace radialkb {
+
+enum class HapticPulse { None, Tick, Commit, Cancel };
+
+const char *hapticPulseToString(HapticPulse pulse);
+
+// Output device for haptic pulses. play() runs on the haptics timer thread and must not block.
+class HapticsSink {
+public:
+    virtual ~HapticsSink() = default;
+    virtual void play(HapticPulse pulse) = 0;
+};
+
+class NullHapticsSink : public HapticsSink {
+public:
+    void play(HapticPulse) override {}
+};
+
+// Linux force-feedback device (/dev/input/eventN) with FF_RUMBLE support.
+class EvdevFfHapticsSink : public HapticsSink {
+public:
+    explicit EvdevFfHapticsSink(const QString &devicePath);
+    ~EvdevFfHapticsSink() override;
+
+    bool available() const { return m_fd >= 0; }
+    void play(HapticPulse pulse) override;
+
+private:
+    int uploadRumble(int durationMs, int magnitude);
+
+    int m_fd{-1};
+    int m_tickId{-1};
+    int m_commitId{-1};
+    int m_cancelId{-1};
+    bool m_errorLogged{false};
+};
+
+// Steam Deck trackpad actuator through its hidraw node (haptic pulse feature report).
+class HidrawHapticsSink : public HapticsSink {
+public:
+    explicit HidrawHapticsSink(const QString &devicePath);
+    ~HidrawHapticsSink() override;
+
+    bool available() const { return m_fd >= 0; }
+    void play(HapticPulse pulse) override;
+
+private:
+    int m_fd{-1};
+    bool m_errorLogged{false};
+};
+
+// Picks a sink from RADIALKB_HAPTICS_DEVICE (/dev/hidrawN or /dev/input/eventN).
+// Falls back to NullHapticsSink when unset or the device cannot be opened.
+std::unique_ptr<HapticsSink> createDefaultHapticsSink();
+
+} // namespace radialkb
@@ -1,13 +1,23 @@
 #include "InputRouter.h"
 
 #include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QChar>
 #include <QJsonObject>
+#include <QVarLengthArray>
 #include <QtMath>
 #include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
 
 #include "Logging.h"
+#include "Metrics.h"
+#include "Trace.h"
 
 // INTENT: Event ordering here is critical. Prevent commit+swipe races by consuming touch-up
 // INTENT: associated with pending commits before gesture classification. Prefer minimal diffs.
@@ -16,25 +26,6 @@ namespace radialkb {
 
 namespace {
 
-KeyAction keyOptionToAction(const KeyOption &option) {
-    if (option.isAction()) {
-        if (option.action == "space") {
-            return KeyAction::make(KeyAction::Space);
-        }
-        if (option.action == "backspace") {
-            return KeyAction::make(KeyAction::Backspace);
-        }
-        if (option.action == "enter") {
-            return KeyAction::make(KeyAction::Enter);
-        }
-        return KeyAction::make(KeyAction::None);
-    }
-    if (!option.ch.isNull()) {
-        return KeyAction::makeChar(option.ch.toLatin1());
-    }
-    return KeyAction::make(KeyAction::None);
-}
-
 QString keycodeLabel(const KeyAction &action) {
     switch (action.type) {
     case KeyAction::Char:
@@ -48,6 +39,14 @@ QString keycodeLabel(const KeyAction &action) {
         return QStringLiteral("KEY_BACKSPACE");
     case KeyAction::Enter:
         return QStringLiteral("KEY_ENTER");
+    case KeyAction::Tab:
+        return QStringLiteral("KEY_TAB");
+    case KeyAction::Escape:
+        return QStringLiteral("KEY_ESC");
+    case KeyAction::CapsLock:
+        return QStringLiteral("KEY_CAPSLOCK");
+    case KeyAction::DeleteWord:
+        return QStringLiteral("KEY_LEFTCTRL+KEY_BACKSPACE");
     case KeyAction::None:
         return QStringLiteral("KEY_NONE");
     }
@@ -64,21 +63,558 @@ QString actionLabel(const KeyAction &action) {
         return QStringLiteral("Backspace");
     case KeyAction::Enter:
         return QStringLiteral("Enter");
+    case KeyAction::Tab:
+        return QStringLiteral("Tab");
+    case KeyAction::Escape:
+        return QStringLiteral("Escape");
+    case KeyAction::CapsLock:
+        return QStringLiteral("CapsLock");
+    case KeyAction::DeleteWord:
+        return QStringLiteral("DeleteWord");
     case KeyAction::None:
         return QStringLiteral("None");
     }
     return QStringLiteral("None");
 }
 
+using TouchPhase = InputRouter::TouchPhase;
+using Pad = InputRouter::Pad;
+
+Pad padFromName(const char *name, qsizetype length) {
+    return length == 4 && std::memcmp(name, "left", 4) == 0 ? Pad::Left : Pad::Right;
+}
+
+TouchPhase touchPhaseFromName(const char *name, qsizetype length) {
+    if (length == 10 && std::memcmp(name, "touch_down", 10) == 0) {
+        return TouchPhase::Down;
+    }
+    if (length == 10 && std::memcmp(name, "touch_move", 10) == 0) {
+        return TouchPhase::Move;
+    }
+    if (length == 8 && std::memcmp(name, "touch_up", 8) == 0) {
+        return TouchPhase::Up;
+    }
+    return TouchPhase::None;
+}
+
+const char *touchPhaseName(TouchPhase phase) {
+    switch (phase) {
+    case TouchPhase::Down:
+        return "touch_down";
+    case TouchPhase::Move:
+        return "touch_move";
+    case TouchPhase::Up:
+        return "touch_up";
+    case TouchPhase::None:
+        break;
+    }
+    return "none";
+}
+
+Counter messageCounter(TouchPhase phase) {
+    switch (phase) {
+    case TouchPhase::Down:
+        return Counter::MessageTouchDown;
+    case TouchPhase::Move:
+        return Counter::MessageTouchMove;
+    case TouchPhase::Up:
+        return Counter::MessageTouchUp;
+    case TouchPhase::None:
+        break;
+    }
+    return Counter::MessageOther;
+}
+
+bool isJsonSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Scans a JSON string starting after its opening quote. Escapes are not supported;
+// the caller falls back to QJsonDocument for those.
+bool scanJsonString(const char *&p, const char *end, const char *&begin, qsizetype &length) {
+    begin = p;
+    while (p < end && *p != '"' && *p != '\\') {
+        ++p;
+    }
+    if (p == end || *p != '"') {
+        return false;
+    }
+    length = p - begin;
+    ++p;
+    return true;
+}
+
+// Larger batches than the UI sends (RadialInputItem::kMaxBatchPoints) take the general parser.
+constexpr int kMaxBatchPoints = 64;
+
+struct TouchMessage {
+    TouchPhase phase = TouchPhase::None;
+    Pad pad = Pad::Right;
+    double x = 0.0;
+    double y = 0.0;
+    // touch_batch: phase comes from the "phase" field and the samples from "points".
+    bool batch = false;
+    int pointCount = 0;
+    double points[kMaxBatchPoints * 3];
+};
+
+TouchPhase batchPhaseFromName(const char *name, qsizetype length) {
+    if (length == 4 && std::memcmp(name, "down", 4) == 0) {
+        return TouchPhase::Down;
+    }
+    if (length == 2 && std::memcmp(name, "up", 2) == 0) {
+        return TouchPhase::Up;
+    }
+    return TouchPhase::Move;
+}
+
+// from_chars also accepts nan and inf, which are not JSON and must never reach hit testing.
+bool parseJsonNumber(const char *&p, const char *end, double &value) {
+    const std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc() || !std::isfinite(value)) {
+        return false;
+    }
+    p = result.ptr;
+    return true;
+}
+
+// Recognises the flat messages the UI sends for every pointer sample and every frame without
+// building a QJsonDocument:
+//   {"type":"touch_*","x":<number>,"y":<number>[,"pad":"left"|"right"]}
+//   {"type":"touch_batch","phase":"down"|"move"|"up","points":[<number>,...][,"pad":...]}
+// Keys may come in any order. Returns false for anything else so the caller can use the
+// general parser.
+bool parseTouchMessage(const char *p, const char *end, TouchMessage &message) {
+    bool haveX = false;
+    bool haveY = false;
+    bool havePoints = false;
+    int values = 0;
+    TouchPhase batchPhase = TouchPhase::Move;
+    auto skipSpace = [&p, end]() {
+        while (p < end && isJsonSpace(*p)) {
+            ++p;
+        }
+    };
+    // Parses a string value; the opening quote must be next.
+    auto stringValue = [&p, end](const char *&value, qsizetype &valueLength) {
+        if (p == end || *p != '"') {
+            return false;
+        }
+        ++p;
+        return scanJsonString(p, end, value, valueLength);
+    };
+
+    skipSpace();
+    if (p == end || *p != '{') {
+        return false;
+    }
+    ++p;
+    for (;;) {
+        skipSpace();
+        if (p == end || *p != '"') {
+            return false;
+        }
+        ++p;
+        const char *key = nullptr;
+        qsizetype keyLength = 0;
+        if (!scanJsonString(p, end, key, keyLength)) {
+            return false;
+        }
+        skipSpace();
+        if (p == end || *p != ':') {
+            return false;
+        }
+        ++p;
+        skipSpace();
+        const char *value = nullptr;
+        qsizetype valueLength = 0;
+        if (keyLength == 4 && std::memcmp(key, "type", 4) == 0) {
+            if (!stringValue(value, valueLength)) {
+                return false;
+            }
+            message.batch = valueLength == 11 && std::memcmp(value, "touch_batch", 11) == 0;
+            message.phase = message.batch ? TouchPhase::Move : touchPhaseFromName(value, valueLength);
+            if (message.phase == TouchPhase::None) {
+                return false;
+            }
+        } else if (keyLength == 3 && std::memcmp(key, "pad", 3) == 0) {
+            if (!stringValue(value, valueLength)) {
+                return false;
+            }
+            message.pad = padFromName(value, valueLength);
+        } else if (keyLength == 5 && std::memcmp(key, "phase", 5) == 0) {
+            if (!stringValue(value, valueLength)) {
+                return false;
+            }
+            batchPhase = batchPhaseFromName(value, valueLength);
+        } else if (keyLength == 6 && std::memcmp(key, "points", 6) == 0) {
+            if (p == end || *p != '[') {
+                return false;
+            }
+            ++p;
+            skipSpace();
+            if (p < end && *p == ']') {
+                ++p;
+            } else {
+                for (;;) {
+                    skipSpace();
+                    if (values == kMaxBatchPoints * 3 || !parseJsonNumber(p, end, message.points[values])) {
+                        return false;
+                    }
+                    ++values;
+                    skipSpace();
+                    if (p < end && *p == ',') {
+                        ++p;
+                        continue;
+                    }
+                    if (p < end && *p == ']') {
+                        ++p;
+                        break;
+                    }
+                    return false;
+                }
+            }
+            havePoints = true;
+        } else if (keyLength == 1 && (*key == 'x' || *key == 'y')) {
+            double number = 0.0;
+            if (!parseJsonNumber(p, end, number)) {
+                return false;
+            }
+            if (*key == 'x') {
+                message.x = number;
+                haveX = true;
+            } else {
+                message.y = number;
+                haveY = true;
+            }
+        } else {
+            return false;
+        }
+        skipSpace();
+        if (p < end && *p == ',') {
+            ++p;
+            continue;
+        }
+        if (p < end && *p == '}') {
+            ++p;
+            break;
+        }
+        return false;
+    }
+    skipSpace();
+    if (p != end || message.phase == TouchPhase::None) {
+        return false;
+    }
+    if (message.batch) {
+        // Like the general parser, a trailing partial sample is ignored.
+        message.phase = batchPhase;
+        message.pointCount = values / 3;
+        return havePoints;
+    }
+    return haveX && haveY;
+}
+
 } // namespace
 
 InputRouter::InputRouter(QObject *parent)
+    : InputRouter(CommitBridge::Sink{}, nullptr, parent) {
+}
+
+InputRouter::InputRouter(CommitBridge::Sink commitSink, std::unique_ptr<HapticsSink> hapticsSink,
+                         QObject *parent)
     : QObject(parent),
-      m_layout(RadialLayoutConfig{8, 0.5, 0.5, M_PI / 2.0}) {
+      m_defaultLayout(kDefaultRadialTables),
+      m_touchModel(m_defaultLayout),
+      m_adaptiveLayout(m_defaultLayout, m_touchModel),
+      m_layout(&m_adaptiveLayout),
+      m_autocorrect(m_defaultLayout),
+      m_sessionListener(*this),
+      m_session(*m_layout, m_sessionListener),
+      m_swipeDecoder(m_swipeTemplates),
+      m_commit(std::move(commitSink)),
+      m_haptics(std::move(hapticsSink)) {
+    m_autocorrect.setUserLexicon(&m_lexicon);
+    m_shapes.addBuiltInTemplates();
+    buildReplyTemplates();
+}
+
+InputRouter::~InputRouter() {
+    saveTouchModel();
+    saveGestureTuner();
+}
+
+void InputRouter::setTouchModelPath(const QString &path) {
+    m_touchModelPath = path;
+    if (!path.isEmpty() && m_touchModel.load(path)) {
+        Logging::log(LogLevel::Info, "ENGINE", QString("touch model loaded from %1").arg(path));
+    }
+}
+
+void InputRouter::setAdaptiveTouchEnabled(bool enabled) {
+    m_adaptiveLayout.setEnabled(enabled);
+}
+
+void InputRouter::setGestureTuningPath(const QString &path) {
+    m_gestureTunerPath = path;
+    if (path.isEmpty() || !m_gestureTuner.load(QFile::encodeName(path).toStdString())) {
+        return;
+    }
+    const GestureThresholds &tuned = m_gestureTuner.thresholds();
+    Logging::log(LogLevel::Info, "ENGINE", QString("gesture tuning loaded from %1: distance=%2 duration=%3 velocity=%4")
+                                               .arg(path)
+                                               .arg(tuned.minDistanceNorm, 0, 'f', 3)
+                                               .arg(tuned.maxDurationMs)
+                                               .arg(tuned.minVelocityNormPerMs, 0, 'f', 5));
+    if (m_gestureTuning) {
+        setGestureThresholds(tuned);
+    }
+}
+
+void InputRouter::setGestureTuningEnabled(bool enabled) {
+    m_gestureTuning = enabled;
+    setGestureThresholds(enabled ? m_gestureTuner.thresholds() : m_gestureTuner.defaults());
+}
+
+void InputRouter::setGestureThresholds(const GestureThresholds &thresholds) {
+    m_session.setGestureThresholds(thresholds);
+    m_gestures.setThresholds(thresholds);
+}
+
+void InputRouter::setAutocorrectEnabled(bool enabled) {
+    m_autocorrect.setEnabled(enabled);
+}
+
+void InputRouter::setShapeGesturesEnabled(bool enabled) {
+    m_shapesEnabled = enabled;
+}
+
+bool InputRouter::loadShapeTemplates(const QString &path) {
+    if (!m_shapes.load(path)) {
+        return false;
+    }
+    Logging::log(LogLevel::Info, "ENGINE", QString("gesture templates loaded from %1 (%2 total)")
+                                               .arg(path)
+                                               .arg(m_shapes.size()));
+    return true;
+}
+
+bool InputRouter::setLearningDirectory(const QString &path) {
+    return m_lexicon.open(path);
+}
+
+bool InputRouter::setDictionaryPath(const QString &path) {
+    if (!m_autocorrect.dictionary().load(path)) {
+        return false;
+    }
+    Logging::log(LogLevel::Info, "ENGINE", QString("dictionary loaded from %1 (%2 words)")
+                                               .arg(path)
+                                               .arg(m_autocorrect.dictionary().size()));
+    if (m_swipeDecoding) {
+        m_swipeTemplates.prepare(*m_layout, m_autocorrect.dictionary());
+    }
+    return true;
+}
+
+void InputRouter::enableSwipeDecoding(const QString &cacheDirectory) {
+    m_swipeDecoding = true;
+    m_swipeTemplates.setCacheDirectory(cacheDirectory);
+    m_swipeTemplates.prepare(*m_layout, m_autocorrect.dictionary());
+}
+
+QVector<SwipeCandidate> InputRouter::decodeSwipe(const double *points, int pointCount, int maxCandidates) const {
+    SwipePath path;
+    for (int i = 0; i < pointCount; ++i) {
+        path.addPoint(QPointF(points[2 * i], points[2 * i + 1]));
+    }
+    return m_swipeDecoder.decode(path, maxCandidates);
+}
+
+void InputRouter::saveTouchModel() {
+    if (m_touchModelPath.isEmpty() || m_touchModel.unsavedUpdates() == 0) {
+        return;
+    }
+    if (!m_touchModel.save(m_touchModelPath)) {
+        Logging::log(LogLevel::Warn, "ENGINE", QString("failed to save touch model to %1").arg(m_touchModelPath));
+    }
+}
+
+void InputRouter::saveGestureTuner() {
+    if (m_gestureTunerPath.isEmpty() || m_gestureTuner.unsavedUpdates() == 0) {
+        return;
+    }
+    QDir().mkpath(QFileInfo(m_gestureTunerPath).absolutePath());
+    if (!m_gestureTuner.save(QFile::encodeName(m_gestureTunerPath).toStdString())) {
+        Logging::log(LogLevel::Warn, "ENGINE", QString("failed to save gesture tuning to %1").arg(m_gestureTunerPath));
+    }
+}
+
+void InputRouter::noteLift(const GestureFeatures &features, SwipeDir swipe, const KeyAction &action) {
+    if (!m_gestureTuning) {
+        return;
+    }
+    const GestureThresholds before = m_gestureTuner.thresholds();
+    m_gestureTuner.observeLift(features, swipe, action, std::llround(nextSampleTimeMs()));
+    const GestureThresholds &tuned = m_gestureTuner.thresholds();
+    if (tuned.minDistanceNorm != before.minDistanceNorm || tuned.maxDurationMs != before.maxDurationMs
+        || tuned.minVelocityNormPerMs != before.minVelocityNormPerMs) {
+        setGestureThresholds(tuned);
+        Logging::log(LogLevel::Debug, "GESTURE", QString("tuned gates distance=%1 duration=%2 velocity=%3")
+                                                     .arg(tuned.minDistanceNorm, 0, 'f', 3)
+                                                     .arg(tuned.maxDurationMs)
+                                                     .arg(tuned.minVelocityNormPerMs, 0, 'f', 5));
+    }
+    if (m_gestureTuner.unsavedUpdates() >= kTouchModelSaveInterval) {
+        saveGestureTuner();
+    }
+}
+
+bool InputRouter::takeProbeSessionRequest() {
+    const bool requested = m_probeSessionRequested;
+    m_probeSessionRequested = false;
+    return requested;
+}
+
+void InputRouter::setParked(bool parked, const char *reason) {
+    if (parked == m_parked) {
+        return;
+    }
+    m_parked = parked;
+    if (parked) {
+        // Write now rather than on the next commit, which may be long after the device slept.
+        saveTouchModel();
+        saveGestureTuner();
+        m_lexicon.sync();
+    }
+    Metrics::setGauge(Gauge::Parked, parked ? 1 : 0);
+    Logging::log(LogLevel::Info, "ENGINE", QString("%1 (%2)").arg(parked ? "parked" : "ready").arg(QLatin1String(reason)));
+    emit parkedChanged(parked);
+}
+
+void InputRouter::noteCommit(const KeyAction &action, bool aimed, double xNorm, double yNorm) {
+    countCommit(action);
+    const std::int64_t nowMs = std::llround(nextSampleTimeMs());
+    // The touch model is trained on the default layout only.
+    const bool adaptive = m_layout == &m_adaptiveLayout;
+    if (action.type == KeyAction::Backspace) {
+        if (adaptive) {
+            m_touchModel.observeBackspace(nowMs);
+        }
+        m_autocorrect.noteBackspace();
+    } else if (action.type == KeyAction::Char) {
+        if (adaptive && aimed) {
+            m_touchModel.observeTap(m_selectedSector, m_selectedKey, m_defaultLayout.angleForPoint(xNorm, yNorm), nowMs);
+        } else if (adaptive) {
+            m_touchModel.observeOtherCommit(nowMs);
+        }
+        m_autocorrect.noteLetter(action.ch, aimed ? m_layout->angleForPoint(xNorm, yNorm) : 0.0, aimed);
+    } else {
+        if (adaptive) {
+            m_touchModel.observeOtherCommit(nowMs);
+        }
+        m_autocorrect.noteBoundary();
+        // A space was already handled by applyAutocorrect(); anything else ends the phrase.
+        if (action.type != KeyAction::Space) {
+            m_lexicon.breakContext();
+        }
+    }
+    // The file is tiny; flushing every few dozen observations bounds what a crash can lose.
+    if (m_touchModel.unsavedUpdates() >= kTouchModelSaveInterval) {
+        saveTouchModel();
+    }
+}
+
+void InputRouter::applyAutocorrect() {
+    TraceSpan span("decode", "autocorrect");
+    const AutocorrectResult result = m_autocorrect.finishWord();
+    // Skipped when the journal no longer ends with the word, e.g. after a focus change.
+    const bool corrected = !result.corrected.isEmpty()
+        && m_commit.replace(QString::fromLatin1(result.typed), QString::fromLatin1(result.corrected));
+    learnWord(corrected ? result.corrected : result.typed);
+    if (!corrected) {
+        return;
+    }
+    Metrics::increment(Counter::Autocorrections);
+    if (Logging::enabled(LogLevel::Debug)) {
+        Logging::log(LogLevel::Debug, "COMMIT", QString("autocorrect %1 -> %2")
+                                                    .arg(QString::fromLatin1(result.typed),
+                                                         QString::fromLatin1(result.corrected)));
+    }
+}
+
+void InputRouter::learnWord(const QByteArray &word) {
+    int end = word.size();
+    while (end > 0 && (word.at(end - 1) == '.' || word.at(end - 1) == ',' || word.at(end - 1) == '?')) {
+        --end;
+    }
+    m_lexicon.learnWord(word.left(end));
+    if (end < word.size()) {
+        m_lexicon.breakContext();
+    }
+}
+
+void InputRouter::noteDualPadLetter(const KeyAction &action, double aimAngle) {
+    countCommit(action);
+    if (m_layout == &m_adaptiveLayout) {
+        m_touchModel.observeOtherCommit(std::llround(nextSampleTimeMs()));
+    }
+    m_autocorrect.noteLetter(action.ch, aimAngle, true);
+}
+
+bool InputRouter::selectionIsChar(QChar ch) const {
+    if (!m_trackingLetter || m_selectedSector < 0 || m_selectedKey < 0) {
+        return false;
+    }
+    const KeyAction selected = m_layout->keyAction(m_selectedSector, m_selectedKey);
+    return selected.type == KeyAction::Char && QChar::fromLatin1(selected.ch) == ch;
+}
+
+void InputRouter::countSwipe(SwipeDir swipe) {
+    switch (swipe) {
+    case SwipeDir::Left:
+        Metrics::increment(Counter::SwipeLeft);
+        break;
+    case SwipeDir::Right:
+        Metrics::increment(Counter::SwipeRight);
+        break;
+    case SwipeDir::Up:
+        Metrics::increment(Counter::SwipeUp);
+        break;
+    case SwipeDir::Down:
+        Metrics::increment(Counter::SwipeDown);
+        break;
+    case SwipeDir::None:
+        break;
+    }
+}
+
+void InputRouter::countCommit(const KeyAction &action) {
+    switch (action.type) {
+    case KeyAction::Char:
+        Metrics::increment(Counter::CommitChar);
+        break;
+    case KeyAction::Space:
+        Metrics::increment(Counter::CommitSpace);
+        break;
+    case KeyAction::Backspace:
+        Metrics::increment(Counter::CommitBackspace);
+        break;
+    case KeyAction::Enter:
+        Metrics::increment(Counter::CommitEnter);
+        break;
+    case KeyAction::Tab:
+    case KeyAction::Escape:
+    case KeyAction::CapsLock:
+    case KeyAction::DeleteWord:
+        Metrics::increment(Counter::CommitOther);
+        break;
+    case KeyAction::None:
+        break;
+    }
 }
 
 double InputRouter::clamp01(double value) {
-    if (value < 0.0) {
+    // Written so that NaN also maps to 0.
+    if (!(value >= 0.0)) {
         return 0.0;
     }
     if (value > 1.0) {
@@ -88,159 +624,697 @@ double InputRouter::clamp01(double value) {
 }
 
 QString InputRouter::handleMessage(const QString &line) {
+    return QString::fromUtf8(handleMessageUtf8(line.toUtf8()));
+}
+
+QByteArray InputRouter::handleMessageUtf8(const QByteArray &line) {
+    TouchMessage message;
+    TraceSpan messageSpan("handleMessage");
+    bool touchMessage = false;
+    {
+        TraceSpan parseSpan("parse", "touch");
+        touchMessage = parseTouchMessage(line.constData(), line.constData() + line.size(), message);
+    }
+    if (touchMessage) {
+        Metrics::increment(message.batch ? Counter::MessageTouchBatch : messageCounter(message.phase));
+        if (m_parked) {
+            setParked(false, "touch");
+        }
+        if (message.batch) {
+            handleTouchBatch(message.phase, message.points, message.pointCount, message.pad);
+        } else {
+            handleTouch(message.pad, message.phase, clamp01(message.x), clamp01(message.y));
+        }
+        return message.phase == TouchPhase::Up ? m_ackReply : selectionReply();
+    }
+    return handleJsonMessage(line);
+}
+
+QByteArray InputRouter::handleJsonMessage(const QByteArray &line) {
     QJsonParseError error{};
-    const QJsonDocument doc = QJsonDocument::fromJson(line.toUtf8(), &error);
+    QJsonDocument doc;
+    {
+        TraceSpan parseSpan("parse", "json");
+        doc = QJsonDocument::fromJson(line, &error);
+    }
     if (error.error != QJsonParseError::NoError) {
+        Metrics::increment(Counter::JsonParseErrors);
         Logging::log(LogLevel::Warn, "ENGINE", QString("invalid json: %1").arg(error.errorString()));
-        return "{\"error\":\"invalid_json\"}";
+        return QByteArrayLiteral("{\"error\":\"invalid_json\"}");
     }
 
     const QJsonObject obj = doc.object();
     const QString type = obj.value("type").toString();
-    if (type == "touch_down" || type == "touch_move" || type == "touch_up") {
-        const double x = clamp01(obj.value("x").toDouble());
-        const double y = clamp01(obj.value("y").toDouble());
-        Q_ASSERT(x >= 0.0 && x <= 1.0);
-        Q_ASSERT(y >= 0.0 && y <= 1.0);
-        Logging::log(LogLevel::Debug, "ENGINE",
-                     QString("input %1 x=%2 y=%3").arg(type).arg(x, 0, 'f', 3).arg(y, 0, 'f', 3));
-        if (type == "touch_down") {
-            handleTouchDown(x, y);
-        } else if (type == "touch_move") {
-            handleTouchMove(x, y);
-        } else {
-            handleTouchUp(x, y);
+    const TouchPhase phase = touchPhaseFromName(type.toLatin1().constData(), type.size());
+    const Pad pad = obj.value("pad").toString() == QLatin1String("left") ? Pad::Left : Pad::Right;
+    if (phase != TouchPhase::None || type == "touch_batch") {
+        if (m_parked) {
+            setParked(false, "touch");
+        }
+    }
+    if (phase != TouchPhase::None) {
+        Metrics::increment(messageCounter(phase));
+        handleTouch(pad, phase, clamp01(obj.value("x").toDouble()), clamp01(obj.value("y").toDouble()));
+        return phase == TouchPhase::Up ? m_ackReply : selectionReply();
+    } else if (type == "touch_batch") {
+        Metrics::increment(Counter::MessageTouchBatch);
+        const QString phaseName = obj.value("phase").toString();
+        const TouchPhase batchPhase = phaseName == "down" ? TouchPhase::Down
+            : phaseName == "up"                          ? TouchPhase::Up
+                                                         : TouchPhase::Move;
+        const QJsonArray values = obj.value("points").toArray();
+        const int pointCount = values.size() / 3;
+        QVarLengthArray<double, 96> points(pointCount * 3);
+        for (int i = 0; i < pointCount * 3; ++i) {
+            points[i] = values.at(i).toDouble();
         }
+        handleTouchBatch(batchPhase, points.constData(), pointCount, pad);
+        return batchPhase == TouchPhase::Up ? m_ackReply : selectionReply();
     } else if (type == "commit_char") {
+        Metrics::increment(Counter::MessageCommitChar);
         const QString ch = obj.value("char").toString();
-        if (!ch.isEmpty()) {
+        // The overlay commits its selection just before the touch_up of the lift. When the touch
+        // drew a shape, the shape takes the lift and the key is not typed.
+        if (!ch.isEmpty() && m_touchActive && !m_dualPad
+            && matchShapeAtLift({m_selectedSector, m_selectedKey, m_trackingLetter})) {
+            m_uiCommitted = KeyAction::make(KeyAction::None);
+            m_skipCommitOnTouchUp = true;
+        } else if (!ch.isEmpty()) {
             const QChar value = ch.at(0);
+            const KeyAction action = value == QChar('\n') ? KeyAction::make(KeyAction::Enter)
+                : value == QChar('\b')                     ? KeyAction::make(KeyAction::Backspace)
+                : value == QChar(' ')                      ? KeyAction::make(KeyAction::Space)
+                                                           : KeyAction::makeChar(value.toLatin1());
             transitionTo(RouterState::CommitChar, "commit_char");
-            if (value == QChar('\n')) {
+            if (action.type == KeyAction::Enter) {
                 m_commit.commitAction("enter");
-            } else if (value == QChar('\b')) {
+                noteCommit(action);
+            } else if (action.type == KeyAction::Backspace) {
                 m_commit.commitAction("backspace");
-            } else if (value == QChar(' ')) {
+                noteCommit(action);
+            } else if (action.type == KeyAction::Space) {
+                applyAutocorrect();
                 m_commit.commitAction("space");
+                noteCommit(action);
             } else {
                 m_commit.commitChar(value);
+                // The UI commits the engine's current selection; the last sample is where it was aimed.
+                noteCommit(action, !m_dualPad && selectionIsChar(value), m_lastX, m_lastY);
             }
+            // Reported to the gesture tuner as the tap of the touch_up that follows.
+            m_uiCommitted = action;
             m_haptics.onCommit();
             transitionTo(RouterState::Idle, "commit_done");
             m_skipCommitOnTouchUp = true;
         }
     } else if (type == "action") {
+        Metrics::increment(Counter::MessageAction);
         handleAction(obj.value("action").toString());
     } else if (type == "ui_show") {
+        Metrics::increment(Counter::MessageUiShow);
+        // Focus may have moved while hidden; earlier text can no longer be rewritten safely.
+        m_commit.clearJournal();
+        m_autocorrect.noteBoundary();
+        m_lexicon.breakContext();
+        setParked(false, "ui_show");
         transitionTo(RouterState::Idle, "ui_show");
     } else if (type == "ui_hide") {
+        Metrics::increment(Counter::MessageUiHide);
+        m_pads.fill(PadCtx());
+        m_touchActive = false;
         clearSelection("ui_hide");
+        setParked(true, "ui_hide");
+    } else if (type == "pad_mode") {
+        setDualPadEnabled(obj.value("mode").toString() == QLatin1String("dual"));
+        QJsonObject reply;
+        reply.insert("type", "pad_mode");
+        reply.insert("mode", m_dualPad ? "dual" : "single");
+        return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+    } else if (type == "trace") {
+        Trace::setEnabled(obj.value("enabled").toBool());
+        Logging::log(LogLevel::Info, "ENGINE", QString("tracing %1").arg(Trace::enabled() ? "on" : "off"));
+        QJsonObject reply;
+        reply.insert("type", "trace");
+        reply.insert("enabled", Trace::enabled());
+        return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+    } else if (type == "trace_dump") {
+        // Clients only name the file; it is always written inside Trace::directory().
+        const QString name = obj.value("name").toString();
+        const QString path = name.isEmpty() ? Trace::defaultPath() : Trace::pathForName(name);
+        int events = 0;
+        QJsonObject reply;
+        reply.insert("type", "trace_dump");
+        if (path.isEmpty()) {
+            reply.insert("error", QString("invalid trace file name %1").arg(name));
+        } else if (Trace::dumpToFile(path, &events)) {
+            reply.insert("path", path);
+            reply.insert("events", events);
+        } else {
+            reply.insert("error", QString("cannot write %1").arg(path));
+        }
+        return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+    } else if (type == "swipe_decode") {
+        const QJsonArray values = obj.value("points").toArray();
+        const int pointCount = values.size() / 2;
+        QVarLengthArray<double, 256> points(pointCount * 2);
+        for (int i = 0; i < pointCount * 2; ++i) {
+            points[i] = values.at(i).toDouble();
+        }
+        QJsonArray candidates;
+        for (const SwipeCandidate &candidate : decodeSwipe(points.constData(), pointCount, obj.value("count").toInt(3))) {
+            candidates.append(QJsonObject{{"word", QString::fromLatin1(candidate.word)}, {"score", candidate.score}});
+        }
+        QJsonObject reply;
+        reply.insert("type", "swipe_decode");
+        reply.insert("ready", m_swipeTemplates.current() != nullptr);
+        reply.insert("candidates", candidates);
+        return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+    } else if (type == "probe_session") {
+        Metrics::increment(Counter::MessageProbe);
+        m_probeSessionRequested = true;
+        return QByteArrayLiteral("{\"type\":\"probe_session\",\"ok\":true}");
+    } else if (type == "stats") {
+        Metrics::increment(Counter::MessageStats);
+        QJsonObject reply = Metrics::snapshot();
+        reply.insert("type", "stats");
+        return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+    } else {
+        Metrics::increment(Counter::MessageOther);
     }
 
-    QJsonObject reply;
-    reply.insert("ack", true);
-    if (type == "touch_move" || type == "touch_down") {
-        const bool clearSelection = (m_selectedSector < 0);
-        reply.insert("type", "selection");
-        reply.insert("sector", m_selectedSector);
-        reply.insert("letter", m_selectedKey);
-        reply.insert("stage", m_trackingLetter ? "letter" : "group");
-        reply.insert("clearSelection", clearSelection);
-        if (clearSelection) {
-            Logging::log(LogLevel::Debug, "ENGINE", "selection cleared (reply)");
+    return m_ackReply;
+}
+
+void InputRouter::handleTouch(Pad pad, TouchPhase phase, double xNorm, double yNorm) {
+    Q_ASSERT(xNorm >= 0.0 && xNorm <= 1.0);
+    Q_ASSERT(yNorm >= 0.0 && yNorm <= 1.0);
+    if (Logging::enabled(LogLevel::Debug)) {
+        Logging::log(LogLevel::Debug, "ENGINE",
+                     QString("input %1 pad=%2 x=%3 y=%4")
+                         .arg(QLatin1String(touchPhaseName(phase)))
+                         .arg(QLatin1String(pad == Pad::Left ? "left" : "right"))
+                         .arg(xNorm, 0, 'f', 3)
+                         .arg(yNorm, 0, 'f', 3));
+    }
+    handleTouchAt(pad, phase, xNorm, yNorm, nextSampleTimeMs());
+}
+
+void InputRouter::handleTouchAt(Pad pad, TouchPhase phase, double xNorm, double yNorm, double timeMs) {
+    if (m_dualPad) {
+        handleDualPadTouchAt(pad, phase, xNorm, yNorm, timeMs);
+        return;
+    }
+    switch (phase) {
+    case TouchPhase::Down:
+        handleTouchDownAt(xNorm, yNorm, timeMs);
+        break;
+    case TouchPhase::Move:
+        handleTouchMoveAt(xNorm, yNorm, timeMs);
+        break;
+    case TouchPhase::Up:
+        handleTouchUpAt(xNorm, yNorm, timeMs);
+        break;
+    case TouchPhase::None:
+        break;
+    }
+}
+
+void InputRouter::setLayout(const RadialHitTester *layout) {
+    // The touch model is trained on the default layout, so custom layouts are used as-is.
+    m_layout = layout ? layout : &m_adaptiveLayout;
+    m_autocorrect.setLayout(layout ? *layout : m_defaultLayout);
+    if (m_swipeDecoding) {
+        // The previous templates keep answering until the new layout's are ready.
+        m_swipeTemplates.prepare(*m_layout, m_autocorrect.dictionary());
+    }
+    m_session.setLayout(*m_layout);
+    m_selectedSector = -1;
+    m_selectedKey = -1;
+    buildReplyTemplates();
+}
+
+void InputRouter::buildReplyTemplates() {
+    m_ackReply = QJsonDocument(QJsonObject{{"ack", true}, {"type", "ack"}}).toJson(QJsonDocument::Compact);
+
+    int maxKeys = 0;
+    for (int sector = 0; sector < m_layout->sectors(); ++sector) {
+        maxKeys = qMax(maxKeys, m_layout->keyCount(sector));
+    }
+    m_replyKeySlots = maxKeys + 1;
+    const int sectorSlots = m_layout->sectors() + 1;
+    m_selectionReplies.clear();
+    m_selectionReplies.reserve(sectorSlots * m_replyKeySlots * 2);
+    for (int sector = -1; sector < m_layout->sectors(); ++sector) {
+        for (int key = -1; key < maxKeys; ++key) {
+            for (bool letterStage : {false, true}) {
+                m_selectionReplies.push_back(formatSelectionReply(sector, key, letterStage));
+            }
         }
-    } else {
-        reply.insert("type", "ack");
     }
+}
 
+QByteArray InputRouter::formatSelectionReply(int sector, int key, bool letterStage) {
+    QJsonObject reply;
+    reply.insert("ack", true);
+    reply.insert("type", "selection");
+    reply.insert("sector", sector);
+    reply.insert("letter", key);
+    reply.insert("stage", letterStage ? "letter" : "group");
+    reply.insert("clearSelection", sector < 0);
     return QJsonDocument(reply).toJson(QJsonDocument::Compact);
 }
 
+QByteArray InputRouter::selectionReply() const {
+    if (m_selectedSector < 0 && Logging::enabled(LogLevel::Debug)) {
+        Logging::log(LogLevel::Debug, "ENGINE", "selection cleared (reply)");
+    }
+    const int sectorSlot = m_selectedSector + 1;
+    const int keySlot = m_selectedKey + 1;
+    if (sectorSlot < 0 || sectorSlot > m_layout->sectors() || keySlot < 0 || keySlot >= m_replyKeySlots) {
+        return formatSelectionReply(m_selectedSector, m_selectedKey, m_trackingLetter);
+    }
+    // Implicitly shared: returning a template only bumps its reference count.
+    return m_selectionReplies.at((sectorSlot * m_replyKeySlots + keySlot) * 2 + (m_trackingLetter ? 1 : 0));
+}
+
+double InputRouter::nextSampleTimeMs() const {
+    // Batched samples may be stamped slightly ahead of the wall clock; never go backwards.
+    return qMax(static_cast<double>(QDateTime::currentMSecsSinceEpoch()), m_lastSampleMs);
+}
+
 void InputRouter::handleTouchDown(double xNorm, double yNorm) {
+    handleTouchAt(Pad::Right, TouchPhase::Down, xNorm, yNorm, nextSampleTimeMs());
+}
+
+void InputRouter::handleTouchMove(double xNorm, double yNorm) {
+    handleTouchAt(Pad::Right, TouchPhase::Move, xNorm, yNorm, nextSampleTimeMs());
+}
+
+void InputRouter::handleTouchUp(double xNorm, double yNorm) {
+    handleTouchAt(Pad::Right, TouchPhase::Up, xNorm, yNorm, nextSampleTimeMs());
+}
+
+void InputRouter::handlePadTouch(Pad pad, TouchPhase phase, double xNorm, double yNorm) {
+    handleTouchAt(pad, phase, clamp01(xNorm), clamp01(yNorm), nextSampleTimeMs());
+}
+
+void InputRouter::handleTouchBatch(TouchPhase phase, const double *points, int pointCount, Pad pad) {
+    if (pointCount <= 0) {
+        return;
+    }
+    // Points are (x, y, dtMs) with dt relative to the previous sample; the first point of a
+    // down batch starts the clock.
+    double timeMs = nextSampleTimeMs();
+    for (int i = 0; i < pointCount; ++i) {
+        const double x = clamp01(points[i * 3]);
+        const double y = clamp01(points[i * 3 + 1]);
+        const double dtMs = qMax(0.0, points[i * 3 + 2]);
+        if (i == 0 && phase == TouchPhase::Down) {
+            handleTouchAt(pad, TouchPhase::Down, x, y, timeMs);
+            continue;
+        }
+        timeMs += dtMs;
+        const bool last = i == pointCount - 1 && phase == TouchPhase::Up;
+        handleTouchAt(pad, last ? TouchPhase::Up : TouchPhase::Move, x, y, timeMs);
+    }
+}
+
+void InputRouter::handleTouchDownAt(double xNorm, double yNorm, double timeMs) {
+    Metrics::increment(Counter::TouchSamples);
     m_lastX = xNorm;
     m_lastY = yNorm;
+    m_lastSampleMs = timeMs;
     m_skipCommitOnTouchUp = false;
-    TouchSample sample{xNorm, yNorm, QDateTime::currentMSecsSinceEpoch()};
-    m_gestures.onTouchDown(sample);
+    m_touchActive = true;
+    const TouchSample sample{xNorm, yNorm, std::llround(timeMs)};
+    m_stroke.begin(xNorm, yNorm, sample.timestampMs);
     transitionTo(RouterState::Hovering, "touch_down");
-    updateSelection(xNorm, yNorm);
+    {
+        TraceSpan span("updateSelection");
+        m_session.touchDown(sample);
+    }
+    syncSessionSelection();
 }
 
-void InputRouter::handleTouchMove(double xNorm, double yNorm) {
+void InputRouter::handleTouchMoveAt(double xNorm, double yNorm, double timeMs) {
+    Metrics::increment(Counter::TouchSamples);
     m_lastX = xNorm;
     m_lastY = yNorm;
-    TouchSample sample{xNorm, yNorm, QDateTime::currentMSecsSinceEpoch()};
-    m_gestures.onTouchMove(sample);
+    m_lastSampleMs = timeMs;
+    const TouchSample sample{xNorm, yNorm, std::llround(timeMs)};
+    m_stroke.add(xNorm, yNorm, sample.timestampMs);
     if (m_state == RouterState::Idle) {
         transitionTo(RouterState::Hovering, "touch_move");
     }
-    updateSelection(xNorm, yNorm);
+    {
+        TraceSpan span("updateSelection");
+        m_session.touchMove(sample);
+    }
+    syncSessionSelection();
 }
 
-void InputRouter::handleTouchUp(double xNorm, double yNorm) {
-    TouchSample sample{xNorm, yNorm, QDateTime::currentMSecsSinceEpoch()};
-    const SwipeDir swipe = m_gestures.onTouchUp(sample);
+void InputRouter::handleTouchUpAt(double xNorm, double yNorm, double timeMs) {
+    Metrics::increment(Counter::TouchSamples);
+    m_lastX = xNorm;
+    m_lastY = yNorm;
+    m_lastSampleMs = timeMs;
+    m_touchActive = false;
+    const TouchSample sample{xNorm, yNorm, std::llround(timeMs)};
+    m_stroke.add(xNorm, yNorm, sample.timestampMs);
+    m_liftTraceStartNs = Trace::enabled() ? Trace::nowNs() : 0;
+    // Commits, cancels and the tuner are reported through m_sessionListener.
+    m_session.touchUp(sample);
+    syncSessionSelection();
     if (m_skipCommitOnTouchUp) {
+        // The UI already committed this touch's key with commit_char: the lift acted as a tap.
         m_skipCommitOnTouchUp = false;
+        if (m_uiCommitted.type != KeyAction::None) {
+            noteLift(m_session.lastGesture(), SwipeDir::None, m_uiCommitted);
+        }
         clearSelection("commit_char");
+    }
+}
+
+void InputRouter::SessionListener::selectionChanged(const SelectionState &selection) {
+    InputRouter &router = m_router;
+    if (selection.sector < 0) {
+        // Deadzone: the ring is left first, then the selection is cleared.
+        if (router.m_trackingLetter) {
+            router.enterTrackGroup("exit_inner");
+        }
+        router.reportSelectionCleared("pad_exit");
         return;
     }
-    if (swipe == SwipeDir::Left) {
-        transitionTo(RouterState::CommitChar, "swipe_left");
-        m_commit.commitAction("backspace");
-        m_haptics.onCommit();
-        transitionTo(RouterState::Idle, "commit_done");
+    if (selection.trackingLetter != router.m_trackingLetter) {
+        if (selection.trackingLetter) {
+            router.enterTrackLetter("enter_inner");
+        } else {
+            router.enterTrackGroup("exit_inner");
+        }
+    }
+    Metrics::increment(Counter::SelectionChanges);
+    const bool sectorChanged = selection.sector != router.m_selectedSector;
+    router.m_selectedSector = selection.sector;
+    router.m_selectedKey = selection.key;
+    if (sectorChanged) {
+        router.m_haptics.onSelectionChange();
+    }
+    emit router.selectionChanged(selection.sector, selection.key, stageName(selection.trackingLetter));
+    if (sectorChanged) {
+        Logging::log(LogLevel::Info, "ENGINE", QString("selection sector %1").arg(selection.sector));
+    } else {
+        Logging::log(LogLevel::Info, "ENGINE", QString("selection key %1:%2").arg(selection.sector).arg(selection.key));
+    }
+}
+
+bool InputRouter::SessionListener::interceptLift(SwipeDir swipe, const SelectionState &lift) {
+    InputRouter &router = m_router;
+    if (router.m_liftTraceStartNs != 0) {
+        Trace::record("classifyGesture", nullptr, router.m_liftTraceStartNs, Trace::nowNs());
+    }
+    countSwipe(swipe);
+    // A lift the UI already committed (or that drew a shape) is done. Shapes go before swipes:
+    // a quick check mark also clears the swipe thresholds, but a swipe never passes the
+    // straightness gate of a shape.
+    return router.m_skipCommitOnTouchUp || router.matchShapeAtLift(lift);
+}
+
+bool InputRouter::matchShapeAtLift(const SelectionState &lift) {
+    // A lift on a letter-ring key types that key: radial-out-then-arc aiming strokes can look
+    // like a check mark or a scratch-out, so shapes are only drawn inside the ring.
+    const bool liftTypesLetter = lift.trackingLetter && lift.key >= 0;
+    return !liftTypesLetter && handleShapeGesture();
+}
+
+void InputRouter::SessionListener::committed(const TouchCommit &commit) {
+    InputRouter &router = m_router;
+    router.syncSessionSelection();
+    if (commit.swipe == SwipeDir::Left) {
+        router.commitTouchAction(commit.action, "swipe_left");
         return;
     }
-    else if (swipe == SwipeDir::Right) {
-        transitionTo(RouterState::CommitChar, "swipe_right");
-        m_commit.commitAction("space");
-        m_haptics.onCommit();
-        transitionTo(RouterState::Idle, "commit_done");
+    if (commit.swipe == SwipeDir::Right) {
+        router.commitTouchAction(commit.action, "swipe_right");
         return;
     }
+    Logging::log(LogLevel::Info, "COMMIT",
+                 QString("sel=%1:%2 label=%3 action=%4 keycode=%5")
+                     .arg(commit.sector)
+                     .arg(commit.key)
+                     .arg(QString::fromUtf8(keyLabel(commit.action)))
+                     .arg(actionLabel(commit.action))
+                     .arg(keycodeLabel(commit.action)));
+    // Only letter-ring taps carry aim information.
+    router.commitTouchAction(commit.action, "touch_up_commit", commit.aimed, router.m_lastX, router.m_lastY);
+}
+
+void InputRouter::SessionListener::cancelled() {
+    Metrics::increment(Counter::Cancels);
+    m_router.m_haptics.onCancel();
+    // The session clears its selection next; it is reported here with the reason.
+    m_router.reportSelectionCleared("swipe_down");
+}
+
+void InputRouter::SessionListener::lifted(const GestureFeatures &features, SwipeDir swipe,
+                                          const KeyAction &committed) {
+    m_router.noteLift(features, swipe, committed);
+    m_router.transitionTo(RouterState::Idle, committed.type == KeyAction::None ? "touch_up_no_commit" : "commit_done");
+}
+
+void InputRouter::commitTouchAction(const KeyAction &action, const char *reason, bool aimed, double xNorm,
+                                    double yNorm) {
+    transitionTo(RouterState::CommitChar, reason);
+    if (action.type == KeyAction::Space) {
+        applyAutocorrect();
+    }
+    m_commit.commitAction(action);
+    noteCommit(action, aimed, xNorm, yNorm);
+    m_haptics.onCommit();
+    transitionTo(RouterState::Idle, "commit_done");
+}
+
+bool InputRouter::handleShapeGesture() {
+    // Cheap gates first: shapes are quick, long and far from straight, which rules out taps,
+    // most ring aiming and all swipes before any matching is done.
+    if (!m_shapesEnabled || m_stroke.durationMs() > kShapeMaxDurationMs
+        || m_stroke.pathLength() < kShapeMinPathLength || m_stroke.straightness() > kShapeMaxStraightness) {
+        return false;
+    }
+    ShapeMatch match;
+    {
+        TraceSpan span("matchShape");
+        match = m_shapes.recognize(m_stroke.points(), m_stroke.size(), kShapeMaxDistance);
+    }
+    if (match.templateIndex < 0) {
+        return false;
+    }
+    const KeyAction action = m_shapes.action(match.templateIndex);
+    Logging::log(LogLevel::Info, "GESTURE", QString("shape=%1 distance=%2 action=%3")
+                                                .arg(m_shapes.name(match.templateIndex))
+                                                .arg(match.distance, 0, 'f', 2)
+                                                .arg(actionLabel(action)));
+    Metrics::increment(Counter::ShapeGestures);
+    commitTouchAction(action, "shape_gesture");
+    if (m_gestureTuning) {
+        m_gestureTuner.observeShapeLift();
+    }
+    return true;
+}
+
+bool InputRouter::handleSwipe(SwipeDir swipe) {
+    if (swipe == SwipeDir::Left) {
+        noteLift(m_gestures.lastGesture(), swipe, KeyAction::make(KeyAction::Backspace));
+        commitTouchAction(KeyAction::make(KeyAction::Backspace), "swipe_left");
+        return true;
+    }
+    else if (swipe == SwipeDir::Right) {
+        noteLift(m_gestures.lastGesture(), swipe, KeyAction::make(KeyAction::Space));
+        commitTouchAction(KeyAction::make(KeyAction::Space), "swipe_right");
+        return true;
+    }
     else if (swipe == SwipeDir::Down) {
+        Metrics::increment(Counter::Cancels);
+        noteLift(m_gestures.lastGesture(), swipe, KeyAction::make(KeyAction::None));
         m_haptics.onCancel();
         clearSelection("swipe_down");
+        return true;
+    }
+    return false;
+}
+
+void InputRouter::setDualPadEnabled(bool enabled) {
+    if (enabled == m_dualPad) {
         return;
     }
+    m_dualPad = enabled;
+    m_pads.fill(PadCtx());
+    m_touchActive = false;
+    m_gestures = GestureRecognizer(m_gestures.thresholds());
+    m_skipCommitOnTouchUp = false;
+    clearSelection("pad_mode");
+    Logging::log(LogLevel::Info, "ENGINE", QString("pad mode %1").arg(enabled ? "dual" : "single"));
+}
 
-    updateSelection(xNorm, yNorm);
-    if (m_selectedSector < 0) {
-        transitionTo(RouterState::Idle, "touch_up_no_selection");
+void InputRouter::handleDualPadTouchAt(Pad pad, TouchPhase phase, double xNorm, double yNorm, double timeMs) {
+    Metrics::increment(Counter::TouchSamples);
+    m_lastSampleMs = timeMs;
+    PadCtx &ctx = m_pads[static_cast<int>(pad)];
+    const TouchSample sample{xNorm, yNorm, std::llround(timeMs)};
+    switch (phase) {
+    case TouchPhase::Down:
+        ctx.down = true;
+        ctx.x = xNorm;
+        ctx.y = yNorm;
+        if (pad == Pad::Right) {
+            m_gestures.onTouchDown(sample);
+            m_skipCommitOnTouchUp = false;
+        }
+        transitionTo(RouterState::Hovering, "touch_down");
+        updateDualPadSelection();
+        break;
+    case TouchPhase::Move:
+        ctx.x = xNorm;
+        ctx.y = yNorm;
+        if (pad == Pad::Right) {
+            m_gestures.onTouchMove(sample);
+        }
+        if (m_state == RouterState::Idle) {
+            transitionTo(RouterState::Hovering, "touch_move");
+        }
+        updateDualPadSelection();
+        break;
+    case TouchPhase::Up:
+        handleDualPadUp(pad, sample);
+        break;
+    case TouchPhase::None:
+        break;
+    }
+}
+
+void InputRouter::handleDualPadUp(Pad pad, const TouchSample &sample) {
+    PadCtx &ctx = m_pads[static_cast<int>(pad)];
+    // A pad commits at most once per touch: only the up that ends a tracked touch may commit.
+    const bool wasDown = ctx.down;
+    ctx.down = false;
+    const bool otherPadDown = m_pads[pad == Pad::Left ? 1 : 0].down;
+    if (pad == Pad::Left) {
+        // The sector stays latched for the right pad; lift-off drift is ignored.
+        if (!otherPadDown) {
+            transitionTo(RouterState::Idle, "touch_up_sector_pad");
+        }
+        return;
+    }
+    if (!wasDown) {
         return;
     }
 
-    const int keyIndex = (m_trackingLetter && m_selectedKey >= 0)
-        ? m_selectedKey
-        : 0;
-    const int keyCount = m_layout.keyCount(m_selectedSector);
-    int clampedKeyIndex = 0;
-    if (keyCount > 0 && keyIndex >= 0 && keyIndex < keyCount) {
-        clampedKeyIndex = keyIndex;
+    SwipeDir swipe = SwipeDir::None;
+    {
+        TraceSpan span("classifyGesture");
+        swipe = m_gestures.onTouchUp(sample);
+    }
+    countSwipe(swipe);
+    if (m_skipCommitOnTouchUp) {
+        m_skipCommitOnTouchUp = false;
+        updateDualPadSelection();
+        transitionTo(RouterState::Idle, "commit_char");
+        return;
     }
-    KeyAction action = KeyAction::make(KeyAction::None);
-    QString keyLabel = QStringLiteral("None");
-    if (keyCount > 0) {
-        const KeyOption &option = m_layout.keyAt(m_selectedSector, clampedKeyIndex);
-        action = keyOptionToAction(option);
-        keyLabel = option.label;
+    if (swipe != SwipeDir::None) {
+        handleSwipe(swipe);
+        return;
     }
+
+    ctx.x = sample.x;
+    ctx.y = sample.y;
+    double aimAngle = 0.0;
+    const int key = dualPadKey(m_selectedSector, m_selectedKey, &aimAngle);
+    if (key < 0) {
+        noteLift(m_gestures.lastGesture(), SwipeDir::None, KeyAction::make(KeyAction::None));
+        updateDualPadSelection();
+        transitionTo(otherPadDown ? RouterState::Hovering : RouterState::Idle, "touch_up_no_selection");
+        return;
+    }
+    const KeyAction action = m_layout->keyAction(m_selectedSector, key);
     Logging::log(LogLevel::Info, "COMMIT",
-                 QString("sel=%1:%2 label=%3 action=%4 keycode=%5")
+                 QString("pads sel=%1:%2 label=%3 action=%4 keycode=%5")
                      .arg(m_selectedSector)
-                     .arg(clampedKeyIndex)
-                     .arg(keyLabel)
+                     .arg(key)
+                     .arg(QString::fromUtf8(keyLabel(action)))
                      .arg(actionLabel(action))
                      .arg(keycodeLabel(action)));
-    if (action.type == KeyAction::None) {
-        transitionTo(RouterState::Idle, "commit_none");
-        return;
+    noteLift(m_gestures.lastGesture(), SwipeDir::None, action);
+    if (action.type != KeyAction::None) {
+        transitionTo(RouterState::CommitChar, "touch_up_commit");
+        if (action.type == KeyAction::Space) {
+            applyAutocorrect();
+        }
+        m_commit.commitAction(action);
+        if (action.type == KeyAction::Char) {
+            noteDualPadLetter(action, aimAngle);
+        } else {
+            noteCommit(action);
+        }
+        m_haptics.onCommit();
     }
-    transitionTo(RouterState::CommitChar, "touch_up_commit");
-    m_commit.commitAction(action);
-    m_haptics.onCommit();
+    // The sector stays selected so the next letter of the group needs only the right thumb,
+    // unless the left thumb moved on while this one was down.
+    updateDualPadSelection();
     transitionTo(RouterState::Idle, "commit_done");
+    if (otherPadDown) {
+        transitionTo(RouterState::Hovering, "sector_pad_held");
+    }
+}
+
+void InputRouter::updateDualPadSelection() {
+    TraceSpan span("updateSelection", "dual_pad");
+    const SelectionThresholds thresholds;
+    const PadCtx &sectorPad = m_pads[static_cast<int>(Pad::Left)];
+    const bool keyPadDown = m_pads[static_cast<int>(Pad::Right)].down;
+    int sector = m_selectedSector;
+    // Resting the thumb in the deadzone keeps the chosen sector. The sector is latched while the
+    // right thumb is down, so its lift commits in the sector it was aimed at; left-pad changes
+    // made meanwhile apply from that lift on.
+    if (!keyPadDown && sectorPad.down
+        && m_layout->radiusForPoint(sectorPad.x, sectorPad.y) >= thresholds.deadzoneRadius) {
+        sector = m_layout->angleToSectorWithHysteresis(m_layout->angleForPoint(sectorPad.x, sectorPad.y),
+                                                       m_selectedSector, thresholds.angleHysteresisRad);
+    }
+    const int previousKey = sector == m_selectedSector ? m_selectedKey : -1;
+    applyDualPadSelection(sector, keyPadDown ? dualPadKey(sector, previousKey) : -1);
+}
+
+int InputRouter::dualPadKey(int sector, int previousKey, double *aimAngle) const {
+    const PadCtx &keyPad = m_pads[static_cast<int>(Pad::Right)];
+    const SelectionThresholds thresholds;
+    if (sector < 0 || sector >= m_layout->sectors()
+        || m_layout->radiusForPoint(keyPad.x, keyPad.y) < thresholds.deadzoneRadius) {
+        return -1;
+    }
+    // Scale the full turn of the right pad into the sector's span of the letter ring, so the
+    // layout's own key boundaries (and their hysteresis, scaled alike) apply unchanged.
+    const double sectorSpan = 2.0 * M_PI / m_layout->sectors();
+    const double angle = sectorSpan * (sector + m_layout->angleForPoint(keyPad.x, keyPad.y) / (2.0 * M_PI));
+    if (aimAngle) {
+        *aimAngle = angle;
+    }
+    return m_layout->angleToKeyIndexWithHysteresis(angle, sector, previousKey,
+                                                   thresholds.angleHysteresisRad / m_layout->sectors());
+}
+
+void InputRouter::applyDualPadSelection(int sector, int key) {
+    if (sector == m_selectedSector && key == m_selectedKey) {
+        return;
+    }
+    Metrics::increment(Counter::SelectionChanges);
+    if (sector != m_selectedSector) {
+        m_haptics.onSelectionChange();
+    }
+    m_selectedSector = sector;
+    m_selectedKey = key;
+    m_trackingLetter = key >= 0;
+    emit selectionChanged(m_selectedSector, m_selectedKey, stageName(m_trackingLetter));
+    Logging::log(LogLevel::Info, "ENGINE", QString("selection %1:%2 (dual pad)").arg(sector).arg(key));
 }
 
 void InputRouter::handleAction(const QString &actionType) {
@@ -252,83 +1326,69 @@ void InputRouter::handleAction(const QString &actionType) {
         } else {
             transitionTo(RouterState::CommitChar, "action_backspace");
         }
+        if (actionType == "space") {
+            applyAutocorrect();
+        }
         m_commit.commitAction(actionType);
+        noteCommit(KeyAction::make(actionType == "enter" ? KeyAction::Enter
+                                   : actionType == "space" ? KeyAction::Space
+                                                           : KeyAction::Backspace));
+        if (actionType == "backspace" && m_gestureTuning) {
+            m_gestureTuner.observeBackspace(std::llround(nextSampleTimeMs()));
+        }
         transitionTo(RouterState::Idle, "commit_done");
     }
     if (actionType == "cancel") {
+        Metrics::increment(Counter::Cancels);
         m_haptics.onCancel();
         clearSelection("cancel_action");
     }
 }
 
-void InputRouter::updateSelection(double xNorm, double yNorm) {
-    constexpr double kDeadzoneRadius = 0.12;
-    constexpr double kInnerRadius = 0.28;
-    constexpr double kInnerHysteresis = 0.03;
-    constexpr double kAngleHysteresis = (3.0 * M_PI / 180.0);
-
-    const double angle = m_layout.angleForPoint(xNorm, yNorm);
-    const double radius = m_layout.radiusForPoint(xNorm, yNorm);
-
-    if (!m_trackingLetter && radius >= kInnerRadius) {
-        enterTrackLetter("enter_inner");
-    } else if (m_trackingLetter && radius < (kInnerRadius - kInnerHysteresis)) {
-        enterTrackGroup("exit_inner");
-    }
-
-    if (radius < kDeadzoneRadius) {
-        clearSelection("pad_exit");
-        return;
-    }
-
-    const int nextSector = m_layout.angleToSectorWithHysteresis(angle, m_selectedSector, kAngleHysteresis);
-    if (nextSector != m_selectedSector) {
-        m_selectedSector = nextSector;
-        m_selectedKey = -1;
-        m_haptics.onSelectionChange();
-        emit selectionChanged(m_selectedSector, m_selectedKey, m_trackingLetter ? "letter" : "group");
-        Logging::log(LogLevel::Info, "ENGINE", QString("selection sector %1").arg(m_selectedSector));
-    }
-
-    if (m_trackingLetter && m_selectedSector >= 0) {
-        const int nextKey = m_layout.angleToKeyIndexWithHysteresis(
-            angle, m_selectedSector, m_selectedKey, kAngleHysteresis);
-        if (nextKey != m_selectedKey) {
-            m_selectedKey = nextKey;
-            emit selectionChanged(m_selectedSector, m_selectedKey, "letter");
-            Logging::log(LogLevel::Info, "ENGINE",
-                         QString("selection key %1:%2").arg(m_selectedSector).arg(m_selectedKey));
+void InputRouter::syncSessionSelection() {
+    const SelectionState &selection = m_session.selection();
+    if (selection.trackingLetter != m_trackingLetter) {
+        if (selection.trackingLetter) {
+            enterTrackLetter("enter_inner");
+        } else {
+            enterTrackGroup("exit_inner");
         }
-    } else if (!m_trackingLetter) {
-        m_selectedKey = -1;
     }
+    m_selectedSector = selection.sector;
+    m_selectedKey = selection.key;
 }
 
-void InputRouter::enterTrackGroup(const QString &reason) {
+void InputRouter::enterTrackGroup(const char *reason) {
     m_trackingLetter = false;
 #ifdef RADIALKB_LEGACY_ROUTER_SM
-    m_stateMachine.transitionTo(State::TrackGroup, reason);
+    m_stateMachine.transitionTo(State::TrackGroup, QString::fromLatin1(reason));
 #else
     Q_UNUSED(reason);
 #endif
 }
 
-void InputRouter::enterTrackLetter(const QString &reason) {
+void InputRouter::enterTrackLetter(const char *reason) {
     m_trackingLetter = true;
 #ifdef RADIALKB_LEGACY_ROUTER_SM
-    m_stateMachine.transitionTo(State::TrackLetter, reason);
+    m_stateMachine.transitionTo(State::TrackLetter, QString::fromLatin1(reason));
 #else
     Q_UNUSED(reason);
 #endif
 }
 
 void InputRouter::clearSelection(const char* reason) {
+    m_session.resetSelection();
+    reportSelectionCleared(reason);
+}
+
+void InputRouter::reportSelectionCleared(const char *reason) {
     if (m_selectedSector != -1 || m_selectedKey != -1 || m_trackingLetter) {
+        Metrics::increment(Counter::SelectionChanges);
         m_selectedSector = -1;
         m_selectedKey = -1;
         m_trackingLetter = false;
-        emit selectionChanged(m_selectedSector, m_selectedKey, "group");
-        Logging::log(LogLevel::Info, "ENGINE", QString("selection cleared (%1)").arg(reason));
+        emit selectionChanged(m_selectedSector, m_selectedKey, stageName(false));
+        Logging::log(LogLevel::Info, "ENGINE", QString("selection cleared (%1)").arg(QLatin1String(reason)));
     }
     transitionTo(RouterState::Idle, reason);
 }
@@ -337,6 +1397,11 @@ void InputRouter::clearSelection(const char* reason) {
 // Phase 1.5: InputRouter explicit FSM helpers
 // Keep behavior stable; transitions are for clarity + debugging.
 // ─────────────────────────────────────────────────────────────
+QString InputRouter::stageName(bool trackingLetter) {
+    // QStringLiteral data is static, so emitting these never allocates.
+    return trackingLetter ? QStringLiteral("letter") : QStringLiteral("group");
+}
+
 const char* InputRouter::stateName(RouterState s) {
     switch (s) {
     case RouterState::Idle: return "Idle";
@@ -347,22 +1412,17 @@ const char* InputRouter::stateName(RouterState s) {
     return "Unknown";
 }
 
-void InputRouter::resetCtx() {
-    m_ctx = GestureCtx{};
-}
-
 void InputRouter::transitionTo(RouterState next, const char* reason) {
     if (next == m_state) return;
+    TraceSpan span("transitionTo", reason);
     const auto prev = m_state;
     m_state = next;
-    const QString reasonStr = reason ? QString::fromLatin1(reason) : QStringLiteral("");
-    Logging::log(LogLevel::Info, "FSM",
-                 QString("RouterFSM: %1 -> %2 reason=%3")
-                     .arg(stateName(prev))
-                     .arg(stateName(next))
-                     .arg(reasonStr));
-    if (next == RouterState::Idle) {
-        resetCtx();
+    if (Logging::enabled(LogLevel::Info)) {
+        Logging::log(LogLevel::Info, "FSM",
+                     QString("RouterFSM: %1 -> %2 reason=%3")
+                         .arg(QLatin1String(stateName(prev)),
+                              QLatin1String(stateName(next)),
+                              QLatin1String(reason ? reason : "")));
     }
 }
 
@@ -1,14 +1,27 @@
 #pragma once
 
+#include <QByteArray>
 #include <QObject>
 #include <QString>
-#include <QPointF>
+#include <QVector>
 #include <QtGlobal>
 
+#include <array>
+#include <memory>
+
+#include "AdaptiveTouchModel.h"
+#include "Autocorrect.h"
 #include "CommitBridge.h"
 #include "GestureRecognizer.h"
+#include "GestureTuner.h"
 #include "Haptics.h"
+#include "PointCloudRecognizer.h"
 #include "RadialLayout.h"
+#include "SelectionRules.h"
+#include "StaticRadialLayout.h"
+#include "TouchSession.h"
+#include "UserLexicon.h"
+#include "swipe/SwipeDecoder.h"
 #ifdef RADIALKB_LEGACY_ROUTER_SM
 #include "StateMachine.h"
 #endif
@@ -30,55 +43,251 @@ public:
         SwipeCapture,
     };
     static const char* stateName(RouterState s);
+
+    enum class TouchPhase { None, Down, Move, Up };
     RouterState state() const { return m_state; }
 
+    // Source pad of a touch message ("pad":"left"|"right"; absent means right). Only
+    // meaningful in dual-pad mode: the left pad picks the sector, the right pad picks a key
+    // of that sector and commits it.
+    enum class Pad { Left, Right };
+
     explicit InputRouter(QObject *parent = nullptr);
+    // Routes commits and haptics to the given sinks instead of uinput/the haptics device.
+    InputRouter(CommitBridge::Sink commitSink, std::unique_ptr<HapticsSink> hapticsSink,
+                QObject *parent = nullptr);
+    ~InputRouter() override;
 
     QString handleMessage(const QString &line);
+    // Hot path used by the engine socket. Touch samples and touch_batch frames are parsed in place
+    // and answered with preformatted, implicitly shared replies, so a move or batch that does not
+    // change the selection performs no heap allocation.
+    QByteArray handleMessageUtf8(const QByteArray &line);
+
+    // Pre-parsed entry points; same behavior as the corresponding touch_* messages.
+    void handleTouchDown(double xNorm, double yNorm);
+    void handleTouchMove(double xNorm, double yNorm);
+    void handleTouchUp(double xNorm, double yNorm);
+    // points holds pointCount (x, y, dtMs) triples, dt relative to the previous sample. A Down
+    // batch starts the gesture at its first point, an Up batch ends it at its last point.
+    void handleTouchBatch(TouchPhase phase, const double *points, int pointCount, Pad pad = Pad::Right);
+    void handlePadTouch(Pad pad, TouchPhase phase, double xNorm, double yNorm);
+
+    // Dual-pad mode: both thumbs work at once, so the next letter's sector can be chosen on the
+    // left pad while the right pad is still committing the previous letter. Switching modes
+    // clears the selection. Off by default; the pad field is ignored in single-pad mode.
+    void setDualPadEnabled(bool enabled);
+    bool dualPadEnabled() const { return m_dualPad; }
+
+    // True once after a probe_session message; the connection then hands its later messages to a
+    // router of its own (see ClientSession). The message does nothing else here.
+    bool takeProbeSessionRequest();
+
+    // Low-power state between ui_hide and ui_show (or the next touch): selection and pads are
+    // reset and pending touch-model updates are saved, so nothing is left to do until woken.
+    bool parked() const { return m_parked; }
+
+    // Hit tests against the given layout instead of the built-in DefaultRadialLayout; nullptr
+    // restores the default. The layout must outlive the router.
+    void setLayout(const RadialHitTester *layout);
+    const RadialHitTester &layout() const { return *m_layout; }
+
+    // Loads the per-user touch model from path and saves it back there periodically and on
+    // destruction. Without a path the model still adapts, but only for this session.
+    void setTouchModelPath(const QString &path);
+    void setAdaptiveTouchEnabled(bool enabled);
+    const AdaptiveTouchModel &touchModel() const { return m_touchModel; }
+
+    // Corrects neighbor-key slips in letter-mode words when a space is committed. The built-in
+    // word list is used unless setDictionaryPath() loads a readable one.
+    void setAutocorrectEnabled(bool enabled);
+    bool setDictionaryPath(const QString &path);
+
+    // Words finished with a space (and the bigrams they form) are counted in the user lexicon;
+    // words committed at least twice are exempt from autocorrection. Without a directory the
+    // counts last for this session only.
+    bool setLearningDirectory(const QString &path);
+    const UserLexicon &userLexicon() const { return m_lexicon; }
+
+    // Fits the swipe gates to this user from lifts that get undone and redone the other way
+    // (see GestureTuner), loading the statistics from path and saving them back periodically
+    // and on destruction. Without a path the gates still adapt, but only for this session.
+    // Disabling returns to the default gates. On by default.
+    void setGestureTuningPath(const QString &path);
+    void setGestureTuningEnabled(bool enabled);
+    const GestureTuner &gestureTuner() const { return m_gestureTuner; }
+
+    // Shape gestures (circle: caps lock, scratch-out: delete word, check mark: enter) are
+    // matched at touch up in single-pad mode, or at the overlay's commit_char just before it,
+    // unless the touch lifts on a letter-ring key. On by default with the built-in templates;
+    // loadShapeTemplates() adds user-defined ones (see PointCloudRecognizer::load()).
+    void setShapeGesturesEnabled(bool enabled);
+    bool loadShapeTemplates(const QString &path);
+    const PointCloudRecognizer &shapeTemplates() const { return m_shapes; }
+
+    // Answers swipe_decode messages with the best dictionary words for a swipe path. The word
+    // templates are mapped from cacheDirectory or built there in the background, and rebuilt
+    // when the layout or dictionary changes; an empty directory builds without caching. Until
+    // enabled, swipe_decode replies are empty.
+    void enableSwipeDecoding(const QString &cacheDirectory);
+    const SwipeTemplateStore &swipeTemplates() const { return m_swipeTemplates; }
+    // Blocks until a running template build has been installed.
+    void waitForSwipeTemplates() { m_swipeTemplates.waitForBuild(); }
+    // points holds pointCount (x, y) pad positions in swipe order.
+    QVector<SwipeCandidate> decodeSwipe(const double *points, int pointCount, int maxCandidates = 3) const;
 
 signals:
     void selectionChanged(int sectorIndex, int keyIndex, const QString &stage);
+    // The owner stops its periodic work while parked.
+    void parkedChanged(bool parked);
 
 private:
-    // FSM per-gesture context. Keep it small; do not change thresholds/semantics here.
-    struct GestureCtx {
-        bool active = false;
-        QPointF startPos;
-        QPointF lastPos;
-        qint64 startMs = 0;
-        double accumDist = 0.0;
-        int currentSector = -1;
+    // Reports the single-pad TouchSession's events as the router's: selection signals, metrics
+    // and haptics, commits with autocorrect and learning, shape gestures and the gesture tuner.
+    class SessionListener final : public TouchListener {
+    public:
+        explicit SessionListener(InputRouter &router)
+            : m_router(router) {}
+
+        void selectionChanged(const SelectionState &selection) override;
+        void committed(const TouchCommit &commit) override;
+        void cancelled() override;
+        bool interceptLift(SwipeDir swipe, const SelectionState &lift) override;
+        void lifted(const GestureFeatures &features, SwipeDir swipe, const KeyAction &committed) override;
+
+    private:
+        InputRouter &m_router;
+    };
+
+    // Per-pad state for dual-pad mode. Only the right pad commits, so m_gestures follows it;
+    // the left pad's sector drags are never swipes.
+    struct PadCtx {
+        bool down = false;
+        double x = 0.5;
+        double y = 0.5;
     };
 
-    void resetCtx();
     void transitionTo(RouterState next, const char* reason);
     void clearSelection(const char* reason);
+    // Reports a selection that is already cleared in the session (or was never set there).
+    void reportSelectionCleared(const char *reason);
     static double clamp01(double value);
+    static QString stageName(bool trackingLetter);
 
     RouterState m_state = RouterState::Idle;
-    GestureCtx m_ctx;
 
-    void handleTouchDown(double xNorm, double yNorm);
-    void handleTouchMove(double xNorm, double yNorm);
-    void handleTouchUp(double xNorm, double yNorm);
+    QByteArray handleJsonMessage(const QByteArray &line);
+    void handleTouch(Pad pad, TouchPhase phase, double xNorm, double yNorm);
+    void handleTouchAt(Pad pad, TouchPhase phase, double xNorm, double yNorm, double timeMs);
+    double nextSampleTimeMs() const;
+    void handleTouchDownAt(double xNorm, double yNorm, double timeMs);
+    void handleTouchMoveAt(double xNorm, double yNorm, double timeMs);
+    void handleTouchUpAt(double xNorm, double yNorm, double timeMs);
+    void handleDualPadTouchAt(Pad pad, TouchPhase phase, double xNorm, double yNorm, double timeMs);
+    void handleDualPadUp(Pad pad, const TouchSample &sample);
+    // Recomputes the dual-pad selection from the latest pad positions.
+    void updateDualPadSelection();
+    // Key of sector under the right pad: its whole circle spans the sector's keys.
+    int dualPadKey(int sector, int previousKey, double *aimAngle = nullptr) const;
+    void applyDualPadSelection(int sector, int key);
+    // Dual pad: commits or cancels for a recognized right-pad swipe; false when there was none.
+    bool handleSwipe(SwipeDir swipe);
+    // Commits the action of a matching shape gesture; false when the stroke is no shape.
+    bool handleShapeGesture();
+    // handleShapeGesture(), unless the touch lifts on a letter-ring key (lift).
+    bool matchShapeAtLift(const SelectionState &lift);
+    // Types an action chosen by a touch: autocorrect before a space, the commit bridge, the
+    // learners and a haptic pulse. aimed and the position are as for noteCommit().
+    void commitTouchAction(const KeyAction &action, const char *reason, bool aimed = false, double xNorm = 0.0,
+                           double yNorm = 0.0);
     void handleAction(const QString &actionType);
-    void updateSelection(double xNorm, double yNorm);
-    void enterTrackGroup(const QString &reason);
-    void enterTrackLetter(const QString &reason);
+    // Copies the session's selection, including changes it does not report, into m_selected*.
+    void syncSessionSelection();
+    void enterTrackGroup(const char *reason);
+    void enterTrackLetter(const char *reason);
+    // Feeds a committed action to the touch model and the autocorrector. aimed marks a letter
+    // chosen in the letter ring at (xNorm, yNorm).
+    void noteCommit(const KeyAction &action, bool aimed = false, double xNorm = 0.0, double yNorm = 0.0);
+    // Feeds the features of the touch just lifted and what it did to the gesture tuner, then
+    // applies the tuned gates to the next touch. A lift that acted as a tap passes SwipeDir::None.
+    void noteLift(const GestureFeatures &features, SwipeDir swipe, const KeyAction &action);
+    // Both pad modes classify with the same gates.
+    void setGestureThresholds(const GestureThresholds &thresholds);
+    // Dual-pad letters: aimAngle is the right-pad position mapped into the layout's angle space.
+    // The touch model only learns single-pad ring taps, so it sees these as plain commits.
+    void noteDualPadLetter(const KeyAction &action, double aimAngle);
+    // Replaces the word being finished with its correction, if any; call before its space.
+    void applyAutocorrect();
+    // Counts a finished word; trailing sentence punctuation ends the bigram context.
+    void learnWord(const QByteArray &word);
+    bool selectionIsChar(QChar ch) const;
+    static void countSwipe(SwipeDir swipe);
+    // One keystroke the user asked for; the backspaces and retyped letters of an autocorrection
+    // are not counted.
+    static void countCommit(const KeyAction &action);
+    void saveTouchModel();
+    void saveGestureTuner();
+    void setParked(bool parked, const char *reason);
+
+    static constexpr int kTouchModelSaveInterval = 32;
+    // Shape gesture gates, in pad units. A swipe has straightness near 1; a flat scratch-out or
+    // a check mark is about 0.7, a circle near 0.
+    static constexpr std::int64_t kShapeMaxDurationMs = 1200;
+    static constexpr double kShapeMinPathLength = 0.4;
+    static constexpr double kShapeMaxStraightness = 0.85;
+    // Drawn shapes score about 0.6-1.0; taps that wander along the ring score above 2.
+    static constexpr double kShapeMaxDistance = 1.4;
+
+    // Reply templates indexed by (sector + 1, key + 1, stage); see buildReplyTemplates().
+    void buildReplyTemplates();
+    static QByteArray formatSelectionReply(int sector, int key, bool letterStage);
+    QByteArray selectionReply() const;
 
 #ifdef RADIALKB_LEGACY_ROUTER_SM
     StateMachine m_stateMachine;
 #endif
-    RadialLayout m_layout;
+    DefaultRadialLayout m_defaultLayout;
+    AdaptiveTouchModel m_touchModel;
+    AdaptiveHitTester m_adaptiveLayout;
+    const RadialHitTester *m_layout;
+    Autocorrector m_autocorrect;
+    UserLexicon m_lexicon;
+    QString m_touchModelPath;
+    // Single-pad touches run through m_session; m_gestures classifies the right pad in dual-pad mode.
+    SessionListener m_sessionListener;
+    TouchSession m_session;
     GestureRecognizer m_gestures;
+    GestureTuner m_gestureTuner;
+    QString m_gestureTunerPath;
+    bool m_gestureTuning{true};
+    StrokeRecorder m_stroke;
+    PointCloudRecognizer m_shapes;
+    bool m_shapesEnabled{true};
+    SwipeTemplateStore m_swipeTemplates;
+    SwipeDecoder m_swipeDecoder;
+    bool m_swipeDecoding{false};
     CommitBridge m_commit;
     Haptics m_haptics;
+    std::array<PadCtx, 2> m_pads;
+    bool m_dualPad{false};
+    bool m_parked{false};
+    bool m_probeSessionRequested{false};
     int m_selectedSector{-1};
     int m_selectedKey{-1};
     bool m_trackingLetter{false};
     bool m_skipCommitOnTouchUp{false};
+    // What the last commit_char typed; None when a shape took that lift instead.
+    KeyAction m_uiCommitted;
+    // A single-pad touch is down (its touch_up is still to come).
+    bool m_touchActive{false};
     double m_lastX{0.0};
     double m_lastY{0.0};
+    double m_lastSampleMs{0.0};
+    // Start of the single-pad lift while tracing, for its classifyGesture span.
+    std::int64_t m_liftTraceStartNs{0};
+    QByteArray m_ackReply;
+    QVector<QByteArray> m_selectionReplies;
+    int m_replyKeySlots{0};
 };
 
 }
@@ -0,0 +1,207 @@
+#include "Keymap.h"
+
+#include "Logging.h"
+
+#include <bitset>
+
+#ifdef RADIALKB_HAVE_XKBCOMMON
+#include <xkbcommon/xkbcommon.h>
+#endif
+
+namespace radialkb {
+
+namespace {
+
+struct UsKey {
+    char ch;
+    std::uint16_t key;
+    bool shift;
+};
+
+// Printable ASCII on US QWERTY.
+constexpr UsKey kUsKeys[] = {
+    {' ', KEY_SPACE, false},
+    {'0', KEY_0, false}, {'1', KEY_1, false}, {'2', KEY_2, false}, {'3', KEY_3, false},
+    {'4', KEY_4, false}, {'5', KEY_5, false}, {'6', KEY_6, false}, {'7', KEY_7, false},
+    {'8', KEY_8, false}, {'9', KEY_9, false},
+    {')', KEY_0, true}, {'!', KEY_1, true}, {'@', KEY_2, true}, {'#', KEY_3, true},
+    {'$', KEY_4, true}, {'%', KEY_5, true}, {'^', KEY_6, true}, {'&', KEY_7, true},
+    {'*', KEY_8, true}, {'(', KEY_9, true},
+    {'-', KEY_MINUS, false}, {'_', KEY_MINUS, true},
+    {'=', KEY_EQUAL, false}, {'+', KEY_EQUAL, true},
+    {'[', KEY_LEFTBRACE, false}, {'{', KEY_LEFTBRACE, true},
+    {']', KEY_RIGHTBRACE, false}, {'}', KEY_RIGHTBRACE, true},
+    {'\\', KEY_BACKSLASH, false}, {'|', KEY_BACKSLASH, true},
+    {';', KEY_SEMICOLON, false}, {':', KEY_SEMICOLON, true},
+    {'\'', KEY_APOSTROPHE, false}, {'"', KEY_APOSTROPHE, true},
+    {'`', KEY_GRAVE, false}, {'~', KEY_GRAVE, true},
+    {',', KEY_COMMA, false}, {'<', KEY_COMMA, true},
+    {'.', KEY_DOT, false}, {'>', KEY_DOT, true},
+    {'/', KEY_SLASH, false}, {'?', KEY_SLASH, true},
+};
+
+constexpr std::uint16_t kUsLetterKeys[26] = {
+    KEY_A, KEY_B, KEY_C, KEY_D, KEY_E, KEY_F, KEY_G, KEY_H, KEY_I, KEY_J,
+    KEY_K, KEY_L, KEY_M, KEY_N, KEY_O, KEY_P, KEY_Q, KEY_R, KEY_S, KEY_T,
+    KEY_U, KEY_V, KEY_W, KEY_X, KEY_Y, KEY_Z
+};
+
+input_event makeEvent(std::uint16_t type, std::uint16_t code, std::int32_t value) {
+    input_event event{};
+    event.type = type;
+    event.code = code;
+    event.value = value;
+    return event;
+}
+
+Keymap compileActive() {
+#ifdef RADIALKB_HAVE_XKBCOMMON
+    Keymap xkb;
+    if (Keymap::fromXkb(xkb)) {
+        Logging::log(LogLevel::Info, "COMMIT", QString("keymap compiled from XKB layout %1 (%2 characters)")
+                                                   .arg(xkb.name())
+                                                   .arg(xkb.size()));
+        return xkb;
+    }
+    Logging::log(LogLevel::Warn, "COMMIT", "could not compile the XKB keymap; typing with US QWERTY");
+#endif
+    return Keymap::usLayout();
+}
+
+} // namespace
+
+const Keymap &Keymap::active() {
+    static const Keymap keymap = compileActive();
+    return keymap;
+}
+
+Keymap Keymap::usLayout() {
+    Keymap keymap;
+    keymap.m_name = QStringLiteral("us");
+    keymap.assignControlKeys();
+    for (int i = 0; i < 26; ++i) {
+        keymap.assign(U'a' + i, kUsLetterKeys[i], false);
+        keymap.assign(U'A' + i, kUsLetterKeys[i], true);
+    }
+    for (const UsKey &entry : kUsKeys) {
+        keymap.assign(static_cast<unsigned char>(entry.ch), entry.key, entry.shift);
+    }
+    return keymap;
+}
+
+#ifdef RADIALKB_HAVE_XKBCOMMON
+bool Keymap::fromXkb(Keymap &out) {
+    xkb_context *context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+    if (!context) {
+        return false;
+    }
+    // No names: rules, model, layout, variant and options come from XKB_DEFAULT_* or the
+    // system defaults, the same way the compositor resolves them.
+    xkb_keymap *keymap = xkb_keymap_new_from_names(context, nullptr, XKB_KEYMAP_COMPILE_NO_FLAGS);
+    if (!keymap) {
+        xkb_context_unref(context);
+        return false;
+    }
+    const xkb_mod_index_t shiftIndex = xkb_keymap_mod_get_index(keymap, XKB_MOD_NAME_SHIFT);
+    const xkb_mod_mask_t shiftMask = shiftIndex == XKB_MOD_INVALID ? 0 : (xkb_mod_mask_t(1) << shiftIndex);
+
+    Keymap result;
+    const char *layoutName = xkb_keymap_layout_get_name(keymap, 0);
+    result.m_name = layoutName ? QString::fromUtf8(layoutName) : QStringLiteral("xkb");
+    result.assignControlKeys();
+    // Unshifted levels first, so a character on two keys is typed without shift if possible.
+    for (const bool shifted : {false, true}) {
+        const xkb_mod_mask_t wanted = shifted ? shiftMask : 0;
+        if (shifted && shiftMask == 0) {
+            break;
+        }
+        for (xkb_keycode_t code = xkb_keymap_min_keycode(keymap); code <= xkb_keymap_max_keycode(keymap); ++code) {
+            // XKB keycodes are evdev codes offset by 8.
+            if (code < 8 || code - 8 > KEY_MAX) {
+                continue;
+            }
+            const xkb_level_index_t levels = xkb_keymap_num_levels_for_key(keymap, code, 0);
+            for (xkb_level_index_t level = 0; level < levels; ++level) {
+                xkb_mod_mask_t masks[8];
+                const size_t maskCount = xkb_keymap_key_get_mods_for_level(keymap, code, 0, level, masks, 8);
+                bool reachable = false;
+                for (size_t i = 0; i < maskCount; ++i) {
+                    reachable = reachable || masks[i] == wanted;
+                }
+                const xkb_keysym_t *syms = nullptr;
+                if (!reachable || xkb_keymap_key_get_syms_by_level(keymap, code, 0, level, &syms) != 1) {
+                    continue;
+                }
+                // Keypad symbols depend on NumLock and are treated differently by terminals.
+                if (syms[0] >= XKB_KEY_KP_Space && syms[0] <= XKB_KEY_KP_Equal) {
+                    continue;
+                }
+                const std::uint32_t codepoint = xkb_keysym_to_utf32(syms[0]);
+                if (codepoint >= 0x20 && codepoint != 0x7f) {
+                    result.assign(codepoint, static_cast<std::uint16_t>(code - 8), shifted);
+                }
+            }
+        }
+    }
+    xkb_keymap_unref(keymap);
+    xkb_context_unref(context);
+    // A layout without a Latin alphabet is no use for the radial layout's letters.
+    if (!result.lookup(U'a') || !result.lookup(U'z')) {
+        return false;
+    }
+    out = result;
+    return true;
+}
+#endif
+
+std::vector<std::uint16_t> Keymap::keys() const {
+    std::bitset<KEY_CNT> seen;
+    std::vector<std::uint16_t> keys;
+    for (const KeymapEntry &entry : m_entries) {
+        if (entry.key != 0 && !seen.test(entry.key)) {
+            seen.set(entry.key);
+            keys.push_back(entry.key);
+        }
+    }
+    return keys;
+}
+
+int Keymap::size() const {
+    int count = 0;
+    for (const KeymapEntry &entry : m_entries) {
+        count += entry.key != 0 ? 1 : 0;
+    }
+    return count;
+}
+
+const std::array<input_event, 2> &Keymap::shiftDown() {
+    static const std::array<input_event, 2> events{
+        makeEvent(EV_KEY, KEY_LEFTSHIFT, 1), makeEvent(EV_SYN, SYN_REPORT, 0)};
+    return events;
+}
+
+const std::array<input_event, 2> &Keymap::shiftUp() {
+    static const std::array<input_event, 2> events{
+        makeEvent(EV_KEY, KEY_LEFTSHIFT, 0), makeEvent(EV_SYN, SYN_REPORT, 0)};
+    return events;
+}
+
+void Keymap::assign(char32_t codepoint, std::uint16_t key, bool shift) {
+    if (codepoint >= kCodepoints || key == 0 || m_entries[codepoint].key != 0) {
+        return;
+    }
+    KeymapEntry &entry = m_entries[codepoint];
+    entry.key = key;
+    entry.shift = shift;
+    entry.events = {makeEvent(EV_KEY, key, 1), makeEvent(EV_SYN, SYN_REPORT, 0),
+                    makeEvent(EV_KEY, key, 0), makeEvent(EV_SYN, SYN_REPORT, 0)};
+}
+
+void Keymap::assignControlKeys() {
+    assign(U'\n', KEY_ENTER, false);
+    assign(U'\r', KEY_ENTER, false);
+    assign(U'\t', KEY_TAB, false);
+    assign(U'\b', KEY_BACKSPACE, false);
+}
+
+} // namespace radialkb
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QString>
+
+#include <linux/input.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// INTENT: Character-to-keystroke table for the uinput keyboard, compiled once at startup from
+// INTENT: the active XKB layout (or a built-in US table). Every entry carries its preencoded
+// INTENT: press/release events, so typing a character is a lookup plus a copy into the batch.
+
+namespace radialkb {
+
+struct KeymapEntry {
+    // Linux key code; 0 when the codepoint cannot be typed.
+    std::uint16_t key = 0;
+    bool shift = false;
+    // Key press, SYN, key release, SYN. Shift is not included: the keyboard toggles it only
+    // where a run of characters changes between shifted and unshifted.
+    std::array<input_event, 4> events{};
+};
+
+class Keymap {
+public:
+    // Latin-1: printable ASCII plus the accented letters and symbols of European layouts.
+    static constexpr int kCodepoints = 256;
+
+    // Compiled on first use. Uses the XKB layout from XKB_DEFAULT_LAYOUT (and the other
+    // XKB_DEFAULT_* variables) or the system default when built with xkbcommon; otherwise,
+    // or if that fails, US QWERTY.
+    static const Keymap &active();
+    static Keymap usLayout();
+#ifdef RADIALKB_HAVE_XKBCOMMON
+    // Only levels reachable with no modifiers or with Shift alone are used.
+    static bool fromXkb(Keymap &out);
+#endif
+
+    // nullptr when the codepoint has no key on this layout.
+    const KeymapEntry *lookup(char32_t codepoint) const {
+        return codepoint < kCodepoints && m_entries[codepoint].key != 0 ? &m_entries[codepoint] : nullptr;
+    }
+    // Every distinct key code in the table, for UI_SET_KEYBIT.
+    std::vector<std::uint16_t> keys() const;
+    // Number of typeable codepoints.
+    int size() const;
+    const QString &name() const { return m_name; }
+
+    // Shift press/release, each followed by a SYN.
+    static const std::array<input_event, 2> &shiftDown();
+    static const std::array<input_event, 2> &shiftUp();
+
+private:
+    // The first mapping of a codepoint wins, so callers add preferred keys first.
+    void assign(char32_t codepoint, std::uint16_t key, bool shift);
+    // Enter, tab and backspace are the same on every layout.
+    void assignControlKeys();
+
+    std::array<KeymapEntry, kCodepoints> m_entries{};
+    QString m_name;
+};
+
+} // namespace radialkb
@@ -3,9 +3,12 @@
 #include <QDateTime>
 #include <QTextStream>
 
+#include <atomic>
+
 namespace radialkb {
 
 static QString g_appTag = "RADIALKB";
+static std::atomic<int> g_minLevel{static_cast<int>(LogLevel::Debug)};
 
 static const char *levelStr(LogLevel lvl) {
     switch (lvl) {
@@ -25,7 +28,18 @@ void Logging::init(const QString &appTag) {
     g_appTag = appTag;
 }
 
+void Logging::setMinLevel(LogLevel lvl) {
+    g_minLevel.store(static_cast<int>(lvl), std::memory_order_relaxed);
+}
+
+bool Logging::enabled(LogLevel lvl) {
+    return static_cast<int>(lvl) >= g_minLevel.load(std::memory_order_relaxed);
+}
+
 void Logging::log(LogLevel lvl, const QString &component, const QString &msg) {
+    if (!enabled(lvl)) {
+        return;
+    }
     const QString ts = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
     QTextStream out(stdout);
     out << levelStr(lvl) << " " << ts << " [" << g_appTag << "][" << component << "] " << msg
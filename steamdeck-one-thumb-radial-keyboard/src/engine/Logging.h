@@ -10,6 +10,9 @@ class Logging {
 public:
     static void init(const QString &appTag);
     static void log(LogLevel lvl, const QString &component, const QString &msg);
+    // Messages below the minimum level are dropped (default: Debug, i.e. everything).
+    static void setMinLevel(LogLevel lvl);
+    static bool enabled(LogLevel lvl);
 };
 
 } // namespace radialkb
@@ -0,0 +1,157 @@
+#include "Metrics.h"
+
+#include <QDir>
+#include <QFile>
+
+namespace radialkb {
+
+std::array<std::atomic<std::uint64_t>, static_cast<int>(Counter::Count)> Metrics::s_counters{};
+std::array<std::atomic<std::int64_t>, static_cast<int>(Gauge::Count)> Metrics::s_gauges{};
+
+namespace {
+
+QElapsedTimer &processClock() {
+    static QElapsedTimer clock = []() {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock;
+}
+
+} // namespace
+
+const char *Metrics::name(Counter counter) {
+    switch (counter) {
+    case Counter::MessageTouchDown: return "messages.touch_down";
+    case Counter::MessageTouchMove: return "messages.touch_move";
+    case Counter::MessageTouchUp: return "messages.touch_up";
+    case Counter::MessageTouchBatch: return "messages.touch_batch";
+    case Counter::MessageCommitChar: return "messages.commit_char";
+    case Counter::MessageAction: return "messages.action";
+    case Counter::MessageUiShow: return "messages.ui_show";
+    case Counter::MessageUiHide: return "messages.ui_hide";
+    case Counter::MessageStats: return "messages.stats";
+    case Counter::MessageProbe: return "messages.probe";
+    case Counter::MessageOther: return "messages.other";
+    case Counter::TouchSamples: return "touch.samples";
+    case Counter::SelectionChanges: return "selection.changes";
+    case Counter::CommitChar: return "commits.char";
+    case Counter::CommitSpace: return "commits.space";
+    case Counter::CommitBackspace: return "commits.backspace";
+    case Counter::CommitEnter: return "commits.enter";
+    case Counter::CommitOther: return "commits.other";
+    case Counter::SwipeLeft: return "swipes.left";
+    case Counter::SwipeRight: return "swipes.right";
+    case Counter::SwipeUp: return "swipes.up";
+    case Counter::SwipeDown: return "swipes.down";
+    case Counter::ShapeGestures: return "gestures.shape";
+    case Counter::Cancels: return "cancels";
+    case Counter::Autocorrections: return "autocorrections";
+    case Counter::JsonParseErrors: return "errors.json_parse";
+    case Counter::UInputFailures: return "errors.uinput";
+    case Counter::EventLoopStalls: return "event_loop.stalls";
+    case Counter::EventLoopStallMs: return "event_loop.stall_ms";
+    case Counter::Count: break;
+    }
+    return "unknown";
+}
+
+const char *Metrics::name(Gauge gauge) {
+    switch (gauge) {
+    case Gauge::CommitQueueDepth: return "commit_queue.depth";
+    case Gauge::CommitQueueDepthMax: return "commit_queue.depth_max";
+    case Gauge::EventLoopStallMaxMs: return "event_loop.stall_max_ms";
+    case Gauge::ConnectedClients: return "clients.connected";
+    case Gauge::Parked: return "power.parked";
+    case Gauge::Count: break;
+    }
+    return "unknown";
+}
+
+QJsonObject Metrics::snapshot() {
+    QJsonObject counters;
+    for (int i = 0; i < static_cast<int>(Counter::Count); ++i) {
+        counters.insert(QLatin1String(name(static_cast<Counter>(i))),
+                        static_cast<qint64>(s_counters[i].load(std::memory_order_relaxed)));
+    }
+    QJsonObject gauges;
+    for (int i = 0; i < static_cast<int>(Gauge::Count); ++i) {
+        gauges.insert(QLatin1String(name(static_cast<Gauge>(i))),
+                      static_cast<qint64>(s_gauges[i].load(std::memory_order_relaxed)));
+    }
+    QJsonObject process;
+    process.insert("context_switches", static_cast<qint64>(contextSwitches()));
+    process.insert("threads", static_cast<int>(QDir(QStringLiteral("/proc/self/task")).entryList(QDir::Dirs | QDir::NoDotAndDotDot).size()));
+    QJsonObject result;
+    result.insert("counters", counters);
+    result.insert("gauges", gauges);
+    result.insert("process", process);
+    result.insert("uptime_ms", processClock().elapsed());
+    return result;
+}
+
+void Metrics::reset() {
+    for (auto &value : s_counters) {
+        value.store(0, std::memory_order_relaxed);
+    }
+    for (auto &value : s_gauges) {
+        value.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::uint64_t Metrics::contextSwitches() {
+    std::uint64_t total = 0;
+    const QDir tasks(QStringLiteral("/proc/self/task"));
+    for (const QString &task : tasks.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFile status(tasks.filePath(task + QStringLiteral("/status")));
+        if (!status.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        // voluntary_ctxt_switches:	N and nonvoluntary_ctxt_switches:	N
+        for (const QByteArray &line : status.readAll().split('\n')) {
+            if (line.contains("ctxt_switches:")) {
+                total += line.mid(line.indexOf(':') + 1).trimmed().toULongLong();
+            }
+        }
+    }
+    return total;
+}
+
+StallMonitor::StallMonitor(int intervalMs, int thresholdMs, QObject *parent)
+    : QObject(parent),
+      m_intervalMs(intervalMs),
+      m_thresholdMs(thresholdMs) {
+    processClock();
+    m_clock.start();
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(intervalMs);
+    connect(&m_timer, &QTimer::timeout, this, &StallMonitor::onTick);
+    m_timer.start();
+}
+
+void StallMonitor::setActive(bool active) {
+    if (active == m_timer.isActive()) {
+        return;
+    }
+    if (active) {
+        // The time spent stopped is not a stall.
+        m_lastTickMs = m_clock.elapsed();
+        m_timer.start();
+    } else {
+        m_timer.stop();
+    }
+}
+
+void StallMonitor::onTick() {
+    const qint64 now = m_clock.elapsed();
+    const qint64 late = now - m_lastTickMs - m_intervalMs;
+    m_lastTickMs = now;
+    if (late >= m_thresholdMs) {
+        Metrics::increment(Counter::EventLoopStalls);
+        Metrics::increment(Counter::EventLoopStallMs, static_cast<std::uint64_t>(late));
+        Metrics::raiseGauge(Gauge::EventLoopStallMaxMs, late);
+    }
+}
+
+} // namespace radialkb
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QObject>
+#include <QTimer>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// INTENT: Process-wide runtime counters for the engine. Updates are a single relaxed atomic
+// INTENT: add/store on a fixed array: no locks, no allocation, safe from any thread. Names and
+// INTENT: JSON are only built when someone asks for a snapshot.
+
+namespace radialkb {
+
+enum class Counter {
+    MessageTouchDown,
+    MessageTouchMove,
+    MessageTouchUp,
+    MessageTouchBatch,
+    MessageCommitChar,
+    MessageAction,
+    MessageUiShow,
+    MessageUiHide,
+    MessageStats,
+    // Lines of probe sessions; everything they do is otherwise left out of the counters.
+    MessageProbe,
+    MessageOther,
+    TouchSamples,
+    SelectionChanges,
+    CommitChar,
+    CommitSpace,
+    CommitBackspace,
+    CommitEnter,
+    CommitOther,
+    SwipeLeft,
+    SwipeRight,
+    SwipeUp,
+    SwipeDown,
+    ShapeGestures,
+    Cancels,
+    Autocorrections,
+    JsonParseErrors,
+    UInputFailures,
+    EventLoopStalls,
+    EventLoopStallMs,
+    Count
+};
+
+enum class Gauge {
+    CommitQueueDepth,
+    CommitQueueDepthMax,
+    EventLoopStallMaxMs,
+    ConnectedClients,
+    Parked,
+    Count
+};
+
+class Metrics {
+public:
+    static void increment(Counter counter, std::uint64_t amount = 1) {
+        if (t_muted) {
+            return;
+        }
+        s_counters[static_cast<int>(counter)].fetch_add(amount, std::memory_order_relaxed);
+    }
+    static void setGauge(Gauge gauge, std::int64_t value) {
+        if (t_muted) {
+            return;
+        }
+        s_gauges[static_cast<int>(gauge)].store(value, std::memory_order_relaxed);
+    }
+    // Raises the gauge to value if it is higher; for high-water marks.
+    static void raiseGauge(Gauge gauge, std::int64_t value) {
+        if (t_muted) {
+            return;
+        }
+        std::atomic<std::int64_t> &slot = s_gauges[static_cast<int>(gauge)];
+        std::int64_t current = slot.load(std::memory_order_relaxed);
+        while (value > current && !slot.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+    static void addGauge(Gauge gauge, std::int64_t delta) {
+        if (t_muted) {
+            return;
+        }
+        s_gauges[static_cast<int>(gauge)].fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    // Updates made by the calling thread are dropped while it is muted (see MetricsMute).
+    static bool muted() { return t_muted; }
+    static void setMuted(bool muted) { t_muted = muted; }
+
+    static std::uint64_t counter(Counter counter) {
+        return s_counters[static_cast<int>(counter)].load(std::memory_order_relaxed);
+    }
+    static std::int64_t gauge(Gauge gauge) {
+        return s_gauges[static_cast<int>(gauge)].load(std::memory_order_relaxed);
+    }
+
+    static const char *name(Counter counter);
+    static const char *name(Gauge gauge);
+
+    // {"counters":{...},"gauges":{...},"process":{...},"uptime_ms":N}
+    static QJsonObject snapshot();
+    static void reset();
+
+    // Context switches of all engine threads so far (/proc/self/task/*/status). Every time a
+    // thread blocks and is woken again counts, so its rate is the engine's wakeup rate.
+    static std::uint64_t contextSwitches();
+
+private:
+    static std::array<std::atomic<std::uint64_t>, static_cast<int>(Counter::Count)> s_counters;
+    static std::array<std::atomic<std::int64_t>, static_cast<int>(Gauge::Count)> s_gauges;
+    static inline thread_local bool t_muted = false;
+};
+
+// Mutes the calling thread's metric updates for its lifetime, e.g. while a probe session's
+// router handles a message. Threads started meanwhile decide for themselves (see CommitBridge).
+class MetricsMute {
+public:
+    MetricsMute()
+        : m_previous(Metrics::muted()) {
+        Metrics::setMuted(true);
+    }
+    ~MetricsMute() { Metrics::setMuted(m_previous); }
+
+    MetricsMute(const MetricsMute &) = delete;
+    MetricsMute &operator=(const MetricsMute &) = delete;
+
+private:
+    bool m_previous;
+};
+
+// Detects event-loop stalls: a periodic timer that fires late by more than the threshold
+// means the loop was blocked for that long.
+class StallMonitor : public QObject {
+    Q_OBJECT
+public:
+    explicit StallMonitor(int intervalMs = 50, int thresholdMs = 25, QObject *parent = nullptr);
+
+    // The probe timer is the engine's only periodic wakeup; it is stopped while parked.
+    void setActive(bool active);
+    bool isActive() const { return m_timer.isActive(); }
+
+private:
+    void onTick();
+
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_lastTickMs{0};
+    int m_intervalMs;
+    int m_thresholdMs;
+};
+
+} // namespace radialkb
@@ -0,0 +1,291 @@
+#include "PointCloudRecognizer.h"
+
+#include <QFile>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QtMath>
+
+#include <cmath>
+#include <limits>
+
+#include "Logging.h"
+
+namespace radialkb {
+
+namespace {
+
+// Starting points tried per template: about sqrt(n), as in $P.
+constexpr int kStartStep = 5;
+
+double distanceBetween(const CloudPoint &a, const CloudPoint &b) {
+    return std::hypot(a.x - b.x, a.y - b.y);
+}
+
+// Unit-box polylines; y grows downwards like pad coordinates.
+const CloudPoint kScratchOut[] = {{0.0, 1.0}, {0.25, 0.0}, {0.5, 1.0}, {0.75, 0.0}, {1.0, 1.0}};
+const CloudPoint kScratchOutFlipped[] = {{0.0, 0.0}, {0.25, 1.0}, {0.5, 0.0}, {0.75, 1.0}, {1.0, 0.0}};
+const CloudPoint kCheckMark[] = {{0.0, 0.55}, {0.3, 1.0}, {1.0, 0.0}};
+const CloudPoint kCheckMarkShort[] = {{0.0, 0.7}, {0.35, 1.0}, {1.0, 0.2}};
+
+} // namespace
+
+void StrokeRecorder::begin(double x, double y, std::int64_t timeMs) {
+    m_size = 0;
+    m_stride = 1;
+    m_skipped = 0;
+    m_pathLength = 0.0;
+    m_startMs = timeMs;
+    m_lastMs = timeMs;
+    m_last = CloudPoint{x, y};
+    m_points[m_size++] = m_last;
+}
+
+void StrokeRecorder::add(double x, double y, std::int64_t timeMs) {
+    if (m_size == 0) {
+        begin(x, y, timeMs);
+        return;
+    }
+    const CloudPoint point{x, y};
+    m_pathLength += distanceBetween(m_last, point);
+    m_last = point;
+    m_lastMs = timeMs;
+    if (++m_skipped < m_stride) {
+        return;
+    }
+    m_skipped = 0;
+    if (m_size == kCapacity) {
+        for (int i = 1; i < kCapacity / 2; ++i) {
+            m_points[i] = m_points[i * 2];
+        }
+        m_size = kCapacity / 2;
+        m_stride *= 2;
+    }
+    m_points[m_size++] = point;
+}
+
+double StrokeRecorder::straightness() const {
+    if (m_size == 0 || m_pathLength <= 0.0) {
+        return 1.0;
+    }
+    return distanceBetween(m_points[0], m_last) / m_pathLength;
+}
+
+void PointCloudRecognizer::addBuiltInTemplates() {
+    // Circles are matched as clouds, so start point and direction do not matter; the ellipse
+    // covers thumbs that flatten the loop.
+    for (const double aspect : {1.0, 0.6}) {
+        std::array<CloudPoint, 33> circle;
+        for (int i = 0; i < static_cast<int>(circle.size()); ++i) {
+            const double angle = 2.0 * M_PI * i / (circle.size() - 1);
+            circle[i] = CloudPoint{std::sin(angle), -aspect * std::cos(angle)};
+        }
+        addTemplate(QStringLiteral("circle"), KeyAction::make(KeyAction::CapsLock), circle.data(), circle.size());
+    }
+    // Scratch-outs are usually drawn much wider than tall; scaling keeps the aspect, so both
+    // proportions get a template.
+    for (const CloudPoint *zigzag : {kScratchOut, kScratchOutFlipped}) {
+        for (const double aspect : {1.0, 0.4}) {
+            std::array<CloudPoint, 5> scratch;
+            for (int i = 0; i < static_cast<int>(scratch.size()); ++i) {
+                scratch[i] = CloudPoint{zigzag[i].x, aspect * zigzag[i].y};
+            }
+            addTemplate(QStringLiteral("scratch_out"), KeyAction::make(KeyAction::DeleteWord), scratch.data(), scratch.size());
+        }
+    }
+    addTemplate(QStringLiteral("check"), KeyAction::make(KeyAction::Enter), kCheckMark, 3);
+    addTemplate(QStringLiteral("check"), KeyAction::make(KeyAction::Enter), kCheckMarkShort, 3);
+}
+
+bool PointCloudRecognizer::addTemplate(const QString &name, KeyAction action, const CloudPoint *points, int count) {
+    Template entry{name, action, {}};
+    if (!normalize(points, count, entry.cloud)) {
+        return false;
+    }
+    m_templates.push_back(entry);
+    return true;
+}
+
+bool PointCloudRecognizer::load(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    int added = 0;
+    int lineNumber = 0;
+    while (!file.atEnd()) {
+        ++lineNumber;
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        const QStringList fields = line.split(' ', Qt::SkipEmptyParts);
+        const KeyAction action = actionFromName(fields.at(0));
+        QVector<CloudPoint> points;
+        bool valid = action.type != KeyAction::None;
+        for (int i = 1; valid && i < fields.size(); ++i) {
+            const QStringList xy = fields.at(i).split(',');
+            bool okX = false;
+            bool okY = false;
+            points.push_back(CloudPoint{xy.value(0).toDouble(&okX), xy.value(1).toDouble(&okY)});
+            valid = xy.size() == 2 && okX && okY;
+        }
+        if (!valid || !addTemplate(fields.at(0), action, points.constData(), points.size())) {
+            Logging::log(LogLevel::Warn, "GESTURE", QString("%1:%2: ignoring gesture template").arg(path).arg(lineNumber));
+            continue;
+        }
+        ++added;
+    }
+    return added > 0;
+}
+
+void PointCloudRecognizer::clear() {
+    m_templates.clear();
+}
+
+ShapeMatch PointCloudRecognizer::recognize(const CloudPoint *points, int count, double maxDistance) const {
+    ShapeMatch match;
+    Cloud stroke;
+    if (m_templates.isEmpty() || !normalize(points, count, stroke)) {
+        return match;
+    }
+    // Anything at or beyond the current best (initially the acceptance limit) is abandoned.
+    double best = maxDistance;
+    for (int t = 0; t < m_templates.size(); ++t) {
+        const Cloud &cloud = m_templates.at(t).cloud;
+        for (int start = 0; start < kCloudPoints; start += kStartStep) {
+            const double forward = cloudDistance(stroke, cloud, start, best);
+            const double backward = cloudDistance(cloud, stroke, start, qMin(best, forward));
+            const double distance = qMin(forward, backward);
+            if (distance < best) {
+                best = distance;
+                match.templateIndex = t;
+            }
+        }
+    }
+    match.distance = best;
+    return match;
+}
+
+bool PointCloudRecognizer::normalize(const CloudPoint *points, int count, Cloud &out) {
+    if (count < 2) {
+        return false;
+    }
+    double length = 0.0;
+    for (int i = 1; i < count; ++i) {
+        length += distanceBetween(points[i - 1], points[i]);
+    }
+    if (length <= 0.0) {
+        return false;
+    }
+
+    // Resample to equidistant points along the path.
+    const double interval = length / (kCloudPoints - 1);
+    double carried = 0.0;
+    int written = 0;
+    out[written++] = points[0];
+    CloudPoint previous = points[0];
+    for (int i = 1; i < count && written < kCloudPoints; ++i) {
+        double segment = distanceBetween(previous, points[i]);
+        while (carried + segment >= interval && segment > 0.0 && written < kCloudPoints) {
+            const double t = (interval - carried) / segment;
+            previous = CloudPoint{previous.x + t * (points[i].x - previous.x), previous.y + t * (points[i].y - previous.y)};
+            out[written++] = previous;
+            segment = distanceBetween(previous, points[i]);
+            carried = 0.0;
+        }
+        carried += segment;
+        previous = points[i];
+    }
+    // Rounding can leave the last slot empty.
+    while (written < kCloudPoints) {
+        out[written++] = points[count - 1];
+    }
+
+    double minX = out[0].x;
+    double maxX = out[0].x;
+    double minY = out[0].y;
+    double maxY = out[0].y;
+    double sumX = 0.0;
+    double sumY = 0.0;
+    for (const CloudPoint &point : out) {
+        minX = qMin(minX, point.x);
+        maxX = qMax(maxX, point.x);
+        minY = qMin(minY, point.y);
+        maxY = qMax(maxY, point.y);
+        sumX += point.x;
+        sumY += point.y;
+    }
+    const double scale = qMax(maxX - minX, maxY - minY);
+    if (scale <= 1e-9) {
+        return false;
+    }
+    const double centerX = sumX / kCloudPoints;
+    const double centerY = sumY / kCloudPoints;
+    for (CloudPoint &point : out) {
+        point = CloudPoint{(point.x - centerX) / scale, (point.y - centerY) / scale};
+    }
+    return true;
+}
+
+double PointCloudRecognizer::cloudDistance(const Cloud &points, const Cloud &tmpl, int start, double abandonAt) {
+    std::array<bool, kCloudPoints> matched{};
+    double sum = 0.0;
+    int index = start;
+    for (int step = 0; step < kCloudPoints; ++step) {
+        const CloudPoint &point = points[index];
+        double nearest = std::numeric_limits<double>::max();
+        int nearestIndex = 0;
+        for (int j = 0; j < kCloudPoints; ++j) {
+            if (matched[j]) {
+                continue;
+            }
+            const double dx = point.x - tmpl[j].x;
+            const double dy = point.y - tmpl[j].y;
+            const double squared = dx * dx + dy * dy;
+            if (squared < nearest) {
+                nearest = squared;
+                nearestIndex = j;
+            }
+        }
+        matched[nearestIndex] = true;
+        // Points matched early are trusted more; later ones only get what is left over.
+        sum += (1.0 - static_cast<double>(step) / kCloudPoints) * std::sqrt(nearest);
+        if (sum >= abandonAt) {
+            return sum;
+        }
+        index = (index + 1) % kCloudPoints;
+    }
+    return sum;
+}
+
+KeyAction PointCloudRecognizer::actionFromName(const QString &name) {
+    if (name == "enter") {
+        return KeyAction::make(KeyAction::Enter);
+    }
+    if (name == "space") {
+        return KeyAction::make(KeyAction::Space);
+    }
+    if (name == "backspace") {
+        return KeyAction::make(KeyAction::Backspace);
+    }
+    if (name == "tab") {
+        return KeyAction::make(KeyAction::Tab);
+    }
+    if (name == "escape") {
+        return KeyAction::make(KeyAction::Escape);
+    }
+    if (name == "caps_lock") {
+        return KeyAction::make(KeyAction::CapsLock);
+    }
+    if (name == "delete_word") {
+        return KeyAction::make(KeyAction::DeleteWord);
+    }
+    return KeyAction{};
+}
+
+QString PointCloudRecognizer::defaultPath() {
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation);
+    return dataDir + "/radialkb/gestures.txt";
+}
+
+} // namespace radialkb
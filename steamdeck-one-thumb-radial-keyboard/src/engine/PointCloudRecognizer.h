@@ -0,0 +1,95 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+#include <array>
+#include <cstdint>
+
+#include "KeyAction.h"
+
+// INTENT: Shape gestures (circle, scratch-out, check mark, or user-defined strokes) recognized
+// INTENT: with a $P-style point-cloud matcher. Templates are resampled and normalized once when
+// INTENT: added; a stroke is normalized once at touch up and greedily matched against every
+// INTENT: template with early abandon, well inside a 1 ms budget for 32 templates.
+
+namespace radialkb {
+
+struct CloudPoint {
+    double x = 0.0;
+    double y = 0.0;
+};
+
+// Fixed-capacity record of one touch, appended on every sample without allocating. When full,
+// every other point is dropped and later samples are kept at half the rate.
+class StrokeRecorder {
+public:
+    static constexpr int kCapacity = 128;
+
+    void begin(double x, double y, std::int64_t timeMs);
+    void add(double x, double y, std::int64_t timeMs);
+
+    const CloudPoint *points() const { return m_points.data(); }
+    int size() const { return m_size; }
+    double pathLength() const { return m_pathLength; }
+    std::int64_t durationMs() const { return m_lastMs - m_startMs; }
+    // Distance between the first and the last sample over the path length; 1 for a straight line.
+    double straightness() const;
+
+private:
+    std::array<CloudPoint, kCapacity> m_points{};
+    int m_size = 0;
+    int m_stride = 1;
+    int m_skipped = 0;
+    CloudPoint m_last;
+    double m_pathLength = 0.0;
+    std::int64_t m_startMs = 0;
+    std::int64_t m_lastMs = 0;
+};
+
+struct ShapeMatch {
+    int templateIndex = -1;
+    // Weighted point-cloud distance of the normalized stroke; lower is closer.
+    double distance = 0.0;
+};
+
+class PointCloudRecognizer {
+public:
+    static constexpr int kCloudPoints = 32;
+    using Cloud = std::array<CloudPoint, kCloudPoints>;
+
+    // Circles toggle caps lock, a scratch-out deletes the last word, a check mark is enter.
+    void addBuiltInTemplates();
+    // Returns false when the points span no area.
+    bool addTemplate(const QString &name, KeyAction action, const CloudPoint *points, int count);
+    // User templates, one per line: "<action> x,y x,y ..." with action enter, space, backspace,
+    // tab, escape, caps_lock or delete_word. Adds to the templates already loaded.
+    bool load(const QString &path);
+    void clear();
+
+    int size() const { return m_templates.size(); }
+    const QString &name(int index) const { return m_templates.at(index).name; }
+    KeyAction action(int index) const { return m_templates.at(index).action; }
+
+    // Best template within maxDistance, or templateIndex -1.
+    ShapeMatch recognize(const CloudPoint *points, int count, double maxDistance) const;
+
+    // Resample to kCloudPoints along the path, scale the larger side to 1, center on the centroid.
+    static bool normalize(const CloudPoint *points, int count, Cloud &out);
+    static KeyAction actionFromName(const QString &name);
+    // GenericDataLocation/radialkb/gestures.txt
+    static QString defaultPath();
+
+private:
+    struct Template {
+        QString name;
+        KeyAction action;
+        Cloud cloud;
+    };
+
+    static double cloudDistance(const Cloud &points, const Cloud &tmpl, int start, double abandonAt);
+
+    QVector<Template> m_templates;
+};
+
+} // namespace radialkb
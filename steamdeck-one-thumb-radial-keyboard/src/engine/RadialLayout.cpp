@@ -161,4 +161,47 @@ const KeyOption &RadialLayout::defaultKey(int sectorIndex) const {
     return m_sectors.at(sectorIndex).keys.first();
 }
 
+KeyAction RadialLayout::keyAction(int sectorIndex, int keyIndex) const {
+    if (keyIndex < 0 || keyIndex >= keyCount(sectorIndex)) {
+        return KeyAction::make(KeyAction::None);
+    }
+    const KeyOption &option = keyAt(sectorIndex, keyIndex);
+    if (option.isAction()) {
+        if (option.action == "space") {
+            return KeyAction::make(KeyAction::Space);
+        }
+        if (option.action == "backspace") {
+            return KeyAction::make(KeyAction::Backspace);
+        }
+        if (option.action == "enter") {
+            return KeyAction::make(KeyAction::Enter);
+        }
+        return KeyAction::make(KeyAction::None);
+    }
+    if (!option.ch.isNull()) {
+        return KeyAction::makeChar(option.ch.toLatin1());
+    }
+    return KeyAction::make(KeyAction::None);
+}
+
+QString RadialLayout::keyLabel(int sectorIndex, int keyIndex) const {
+    if (keyIndex < 0 || keyIndex >= keyCount(sectorIndex)) {
+        return QStringLiteral("None");
+    }
+    return keyAt(sectorIndex, keyIndex).label;
+}
+
+LayoutPoint RadialLayout::keyAnchor(int sectorIndex, int keyIndex) const {
+    constexpr double kAnchorRadius = 0.38;
+    const int count = keyCount(sectorIndex);
+    if (keyIndex < 0 || keyIndex >= count) {
+        return LayoutPoint{m_cfg.centerX, m_cfg.centerY};
+    }
+    const double sectorAngle = (2.0 * M_PI) / static_cast<double>(m_cfg.sectors);
+    const double keyAngle = sectorAngle / static_cast<double>(count);
+    const double angle = sectorAngle * sectorIndex + keyAngle * (keyIndex + 0.5) - m_cfg.angleOffsetRad;
+    return LayoutPoint{m_cfg.centerX + kAnchorRadius * std::cos(angle),
+                       m_cfg.centerY + kAnchorRadius * std::sin(angle)};
+}
+
 } // namespace radialkb
@@ -4,6 +4,8 @@
 #include <QString>
 #include <QVector>
 
+#include "RadialHitTester.h"
+
 namespace radialkb {
 
 struct RadialLayoutConfig {
@@ -26,27 +28,32 @@ struct Sector {
     QVector<KeyOption> keys;
 };
 
-class RadialLayout {
+// Runtime layout; supports any sector count and is the reference for StaticRadialLayout.
+class RadialLayout : public RadialHitTester {
 public:
     explicit RadialLayout(RadialLayoutConfig cfg = {});
 
-    int sectors() const { return m_cfg.sectors; }
+    int sectors() const override { return m_cfg.sectors; }
     const QVector<Sector> &sectorList() const { return m_sectors; }
 
-    double angleForPoint(double xNorm, double yNorm) const;
-    double radiusForPoint(double xNorm, double yNorm) const;
+    double angleForPoint(double xNorm, double yNorm) const override;
+    double radiusForPoint(double xNorm, double yNorm) const override;
 
     int angleToSector(double xNorm, double yNorm) const;
     int angleToSector(double angleRad) const;
-    int angleToSectorWithHysteresis(double angleRad, int previousSector, double hysteresisRad) const;
+    int angleToSectorWithHysteresis(double angleRad, int previousSector, double hysteresisRad) const override;
 
     int angleToKeyIndex(double angleRad, int sectorIndex) const;
-    int angleToKeyIndexWithHysteresis(double angleRad, int sectorIndex, int previousIndex, double hysteresisRad) const;
+    int angleToKeyIndexWithHysteresis(double angleRad, int sectorIndex, int previousIndex, double hysteresisRad) const override;
 
-    int keyCount(int sectorIndex) const;
+    int keyCount(int sectorIndex) const override;
     const KeyOption &keyAt(int sectorIndex, int keyIndex) const;
     const KeyOption &defaultKey(int sectorIndex) const;
 
+    KeyAction keyAction(int sectorIndex, int keyIndex) const override;
+    QString keyLabel(int sectorIndex, int keyIndex) const;
+    LayoutPoint keyAnchor(int sectorIndex, int keyIndex) const override;
+
 private:
     RadialLayoutConfig m_cfg;
     QVector<Sector> m_sectors;
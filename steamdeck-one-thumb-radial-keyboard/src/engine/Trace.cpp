@@ -0,0 +1,183 @@
+#include "Trace.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace radialkb {
+
+std::atomic<bool> Trace::s_enabled{false};
+
+namespace {
+
+struct TraceEvent {
+    const char *name;
+    const char *detail;
+    std::int64_t startNs;
+    std::int64_t durationNs;
+};
+
+// Written by its owning thread only; the mutex is uncontended except while dumping.
+struct TraceRing {
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    std::uint64_t written = 0;
+    long tid = 0;
+    QByteArray threadName;
+};
+
+std::mutex g_ringsMutex;
+std::vector<std::shared_ptr<TraceRing>> g_rings;
+thread_local std::shared_ptr<TraceRing> t_ring;
+
+TraceRing &threadRing() {
+    if (!t_ring) {
+        auto ring = std::make_shared<TraceRing>();
+        ring->events.resize(Trace::kRingCapacity);
+        ring->tid = static_cast<long>(syscall(SYS_gettid));
+        char name[32] = {};
+        if (pthread_getname_np(pthread_self(), name, sizeof(name)) == 0) {
+            ring->threadName = name;
+        }
+        std::lock_guard<std::mutex> lock(g_ringsMutex);
+        g_rings.push_back(ring);
+        t_ring = std::move(ring);
+    }
+    return *t_ring;
+}
+
+void appendJsonString(QByteArray &out, const char *text) {
+    out.append('"');
+    for (const char *p = text; *p; ++p) {
+        if (*p == '"' || *p == '\\') {
+            out.append('\\');
+        }
+        if (static_cast<unsigned char>(*p) >= 0x20) {
+            out.append(*p);
+        }
+    }
+    out.append('"');
+}
+
+} // namespace
+
+void Trace::setEnabled(bool enabled) {
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+std::int64_t Trace::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void Trace::record(const char *name, const char *detail, std::int64_t startNs, std::int64_t endNs) {
+    TraceRing &ring = threadRing();
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    ring.events[ring.written % kRingCapacity] = TraceEvent{name, detail, startNs, endNs - startNs};
+    ++ring.written;
+}
+
+QByteArray Trace::toChromeJson(int *eventCount) {
+    std::vector<std::shared_ptr<TraceRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(g_ringsMutex);
+        rings = g_rings;
+    }
+    const long pid = static_cast<long>(getpid());
+    int count = 0;
+    QByteArray out;
+    out.reserve(1 << 16);
+    out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    auto separator = [&out, &first]() {
+        if (!first) {
+            out.append(",\n");
+        }
+        first = false;
+    };
+    for (const auto &ring : rings) {
+        std::lock_guard<std::mutex> lock(ring->mutex);
+        if (!ring->threadName.isEmpty()) {
+            separator();
+            out.append("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":").append(QByteArray::number(pid));
+            out.append(",\"tid\":").append(QByteArray::number(static_cast<qlonglong>(ring->tid)));
+            out.append(",\"args\":{\"name\":");
+            appendJsonString(out, ring->threadName.constData());
+            out.append("}}");
+        }
+        const std::uint64_t begin = ring->written > std::uint64_t(kRingCapacity) ? ring->written - kRingCapacity : 0;
+        for (std::uint64_t i = begin; i < ring->written; ++i) {
+            const TraceEvent &event = ring->events[i % kRingCapacity];
+            separator();
+            out.append("{\"ph\":\"X\",\"cat\":\"radialkb\",\"name\":");
+            appendJsonString(out, event.name);
+            out.append(",\"pid\":").append(QByteArray::number(pid));
+            out.append(",\"tid\":").append(QByteArray::number(static_cast<qlonglong>(ring->tid)));
+            // Chrome expects microseconds.
+            out.append(",\"ts\":").append(QByteArray::number(event.startNs / 1000.0, 'f', 3));
+            out.append(",\"dur\":").append(QByteArray::number(event.durationNs / 1000.0, 'f', 3));
+            if (event.detail) {
+                out.append(",\"args\":{\"detail\":");
+                appendJsonString(out, event.detail);
+                out.append('}');
+            }
+            out.append('}');
+            ++count;
+        }
+    }
+    out.append("]}\n");
+    if (eventCount) {
+        *eventCount = count;
+    }
+    return out;
+}
+
+bool Trace::dumpToFile(const QString &path, int *eventCount) {
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(toChromeJson(eventCount));
+    return file.commit();
+}
+
+void Trace::clear() {
+    std::lock_guard<std::mutex> registryLock(g_ringsMutex);
+    for (const auto &ring : g_rings) {
+        std::lock_guard<std::mutex> lock(ring->mutex);
+        ring->written = 0;
+    }
+}
+
+QString Trace::defaultPath() {
+    return directory() + QString("/trace-%1.json").arg(getpid());
+}
+
+QString Trace::directory() {
+    const QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    return (runtimeDir.isEmpty() ? QStringLiteral("/tmp") : runtimeDir) + QStringLiteral("/radialkb-traces");
+}
+
+QString Trace::pathForName(const QString &name) {
+    // No separators means no way out of the directory; the suffix keeps the socket and other
+    // files that may share a name with a trace out of reach.
+    if (name.contains(QLatin1Char('/')) || name.startsWith(QLatin1Char('.'))
+        || !name.endsWith(QLatin1String(".json")) || name.size() > 255) {
+        return QString();
+    }
+    return directory() + QLatin1Char('/') + name;
+}
+
+} // namespace radialkb
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+
+// INTENT: Opt-in timeline tracing of the gesture pipeline. Spans go into a fixed-size ring per
+// INTENT: thread and are exported as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev).
+// INTENT: While tracing is off a span costs one relaxed load and a branch; nothing is recorded.
+
+namespace radialkb {
+
+class Trace {
+public:
+    // Events kept per thread; older ones are overwritten.
+    static constexpr int kRingCapacity = 1 << 16;
+
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+    static std::int64_t nowNs();
+
+    // name and detail must outlive the trace (string literals or static tables).
+    static void record(const char *name, const char *detail, std::int64_t startNs, std::int64_t endNs);
+
+    // Everything still held in the rings, oldest first per thread.
+    static QByteArray toChromeJson(int *eventCount = nullptr);
+    static bool dumpToFile(const QString &path, int *eventCount = nullptr);
+    static void clear();
+    // directory()/trace-<pid>.json
+    static QString defaultPath();
+    // The only place socket clients can have traces written: radialkb-traces in the runtime
+    // directory (or /tmp).
+    static QString directory();
+    // directory()/name for a plain file name ending in .json; empty for anything else.
+    static QString pathForName(const QString &name);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+// Records [construction, destruction) as one complete event when tracing is on.
+class TraceSpan {
+public:
+    explicit TraceSpan(const char *name, const char *detail = nullptr)
+        : m_name(Trace::enabled() ? name : nullptr),
+          m_detail(detail),
+          m_startNs(m_name ? Trace::nowNs() : 0) {}
+    ~TraceSpan() {
+        if (m_name) {
+            Trace::record(m_name, m_detail, m_startNs, Trace::nowNs());
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *m_name;
+    const char *m_detail;
+    std::int64_t m_startNs;
+};
+
+} // namespace radialkb
@@ -1,6 +1,8 @@
 #include "UInputKeyboard.h"
 
+#include "Keymap.h"
 #include "Logging.h"
+#include "Metrics.h"
 
 #include <errno.h>
 #include <fcntl.h>
@@ -14,71 +16,31 @@
 
 namespace radialkb {
 
-namespace {
-
-struct KeyStroke {
-    int key;
-    bool shift;
-};
-
-bool charToKey(QChar ch, KeyStroke &out) {
-    static const int kLetterKeycodes[26] = {
-        KEY_A, KEY_B, KEY_C, KEY_D, KEY_E, KEY_F, KEY_G, KEY_H, KEY_I, KEY_J,
-        KEY_K, KEY_L, KEY_M, KEY_N, KEY_O, KEY_P, KEY_Q, KEY_R, KEY_S, KEY_T,
-        KEY_U, KEY_V, KEY_W, KEY_X, KEY_Y, KEY_Z
-    };
-
-    if (ch.isLetter()) {
-        bool upper = ch.isUpper();
-        QChar lower = ch.toLower();
-        char latin = lower.toLatin1();
-        if (latin >= 'a' && latin <= 'z') {
-            out.key = kLetterKeycodes[latin - 'a'];
-            out.shift = upper;
-            return true;
-        }
-    }
-
-    if (ch == ' ') {
-        out.key = KEY_SPACE;
-        out.shift = false;
-        return true;
-    }
-    if (ch == '.') {
-        out.key = KEY_DOT;
-        out.shift = false;
-        return true;
-    }
-    if (ch == ',') {
-        out.key = KEY_COMMA;
-        out.shift = false;
-        return true;
-    }
-    if (ch == '?') {
-        out.key = KEY_SLASH;
-        out.shift = true;
-        return true;
-    }
-    if (ch == '\n' || ch == '\r') {
-        out.key = KEY_ENTER;
-        out.shift = false;
-        return true;
-    }
-
-    return false;
-}
-
-} // namespace
-
 UInputKeyboard::UInputKeyboard()
     : m_fd(-1)
+    , m_adopted(false)
     , m_available(false)
     , m_errorLogged(false)
-    , m_lastInitAttemptMs(0) {}
+    , m_lastInitAttemptMs(0)
+    , m_keymap(Keymap::active()) {
+    m_batch.reserve(kBatchReserve);
+}
+
+UInputKeyboard::UInputKeyboard(int adoptedFd)
+    : m_fd(adoptedFd)
+    , m_adopted(true)
+    , m_available(adoptedFd >= 0)
+    , m_errorLogged(false)
+    , m_lastInitAttemptMs(0)
+    , m_keymap(Keymap::active()) {
+    m_batch.reserve(kBatchReserve);
+}
 
 UInputKeyboard::~UInputKeyboard() {
     if (m_fd >= 0) {
-        ioctl(m_fd, UI_DEV_DESTROY);
+        if (!m_adopted) {
+            ioctl(m_fd, UI_DEV_DESTROY);
+        }
         close(m_fd);
     }
 }
@@ -92,16 +54,7 @@ void UInputKeyboard::sendKey(int linuxKeyCode, bool pressRelease) {
         return;
     }
 
-    // Guard against stuck modifiers from the host session.
-    emitEvent(EV_KEY, KEY_LEFTSHIFT, 0);
-    emitEvent(EV_KEY, KEY_RIGHTSHIFT, 0);
-    emitEvent(EV_KEY, KEY_LEFTCTRL, 0);
-    emitEvent(EV_KEY, KEY_RIGHTCTRL, 0);
-    emitEvent(EV_KEY, KEY_LEFTALT, 0);
-    emitEvent(EV_KEY, KEY_RIGHTALT, 0);
-    emitEvent(EV_KEY, KEY_LEFTMETA, 0);
-    emitEvent(EV_KEY, KEY_RIGHTMETA, 0);
-    emitSync();
+    releaseModifiers();
 
     emitEvent(EV_KEY, linuxKeyCode, 1);
     emitSync();
@@ -111,50 +64,45 @@ void UInputKeyboard::sendKey(int linuxKeyCode, bool pressRelease) {
     }
 }
 
-void UInputKeyboard::sendText(const QString &text) {
+void UInputKeyboard::sendChord(int modifierKeyCode, int linuxKeyCode) {
     if (!ensureInitialized()) {
         return;
     }
 
-    for (QChar ch : text) {
-        KeyStroke stroke{};
-        if (!charToKey(ch, stroke)) {
-            Logging::log(LogLevel::Warn, "COMMIT",
-                         QString("Unsupported character for uinput: '%1'").arg(ch));
-            continue;
-        }
-
-        Logging::log(LogLevel::Info, "COMMIT",
-                     QString("uinput char='%1' keycode=%2 shift=%3")
-                         .arg(ch)
-                         .arg(stroke.key)
-                         .arg(stroke.shift ? 1 : 0));
-
-        // Guard against stuck modifiers from the host session.
-        emitEvent(EV_KEY, KEY_LEFTSHIFT, 0);
-        emitEvent(EV_KEY, KEY_RIGHTSHIFT, 0);
-        emitEvent(EV_KEY, KEY_LEFTCTRL, 0);
-        emitEvent(EV_KEY, KEY_RIGHTCTRL, 0);
-        emitEvent(EV_KEY, KEY_LEFTALT, 0);
-        emitEvent(EV_KEY, KEY_RIGHTALT, 0);
-        emitEvent(EV_KEY, KEY_LEFTMETA, 0);
-        emitEvent(EV_KEY, KEY_RIGHTMETA, 0);
-        emitSync();
-
-        if (stroke.shift) {
-            emitEvent(EV_KEY, KEY_LEFTSHIFT, 1);
-            emitSync();
-        }
+    releaseModifiers();
+    emitEvent(EV_KEY, modifierKeyCode, 1);
+    emitSync();
+    emitEvent(EV_KEY, linuxKeyCode, 1);
+    emitSync();
+    emitEvent(EV_KEY, linuxKeyCode, 0);
+    emitSync();
+    emitEvent(EV_KEY, modifierKeyCode, 0);
+    emitSync();
+}
 
-        emitEvent(EV_KEY, stroke.key, 1);
-        emitSync();
-        emitEvent(EV_KEY, stroke.key, 0);
-        emitSync();
+void UInputKeyboard::sendChar(QChar ch) {
+    if (!ensureInitialized()) {
+        return;
+    }
+    const bool ownBatch = !m_batching;
+    m_batching = true;
+    typeChar(ch);
+    if (ownBatch) {
+        endBatch();
+    }
+}
 
-        if (stroke.shift) {
-            emitEvent(EV_KEY, KEY_LEFTSHIFT, 0);
-            emitSync();
-        }
+void UInputKeyboard::sendText(const QString &text) {
+    if (!ensureInitialized()) {
+        return;
+    }
+    const bool ownBatch = !m_batching;
+    m_batching = true;
+    for (QChar ch : text) {
+        typeChar(ch);
+    }
+    if (ownBatch) {
+        endBatch();
     }
 }
 
@@ -162,6 +110,9 @@ bool UInputKeyboard::ensureInitialized() {
     if (m_available) {
         return true;
     }
+    if (m_adopted) {
+        return false;
+    }
     const qint64 now = QDateTime::currentMSecsSinceEpoch();
     if (now - m_lastInitAttemptMs < 2000) {
         return false;
@@ -186,23 +137,14 @@ bool UInputKeyboard::ensureInitialized() {
         return false;
     }
 
-    static const int kLetterKeycodes[26] = {
-        KEY_A, KEY_B, KEY_C, KEY_D, KEY_E, KEY_F, KEY_G, KEY_H, KEY_I, KEY_J,
-        KEY_K, KEY_L, KEY_M, KEY_N, KEY_O, KEY_P, KEY_Q, KEY_R, KEY_S, KEY_T,
-        KEY_U, KEY_V, KEY_W, KEY_X, KEY_Y, KEY_Z
-    };
-    for (int code : kLetterKeycodes) {
+    for (std::uint16_t code : m_keymap.keys()) {
         ioctl(m_fd, UI_SET_KEYBIT, code);
     }
-    ioctl(m_fd, UI_SET_KEYBIT, KEY_SPACE);
-    ioctl(m_fd, UI_SET_KEYBIT, KEY_ENTER);
-    ioctl(m_fd, UI_SET_KEYBIT, KEY_BACKSPACE);
-    ioctl(m_fd, UI_SET_KEYBIT, KEY_DOT);
-    ioctl(m_fd, UI_SET_KEYBIT, KEY_COMMA);
-    ioctl(m_fd, UI_SET_KEYBIT, KEY_SLASH);
     ioctl(m_fd, UI_SET_KEYBIT, KEY_LEFTSHIFT);
     ioctl(m_fd, UI_SET_KEYBIT, KEY_TAB);
     ioctl(m_fd, UI_SET_KEYBIT, KEY_ESC);
+    ioctl(m_fd, UI_SET_KEYBIT, KEY_CAPSLOCK);
+    ioctl(m_fd, UI_SET_KEYBIT, KEY_LEFTCTRL);
 
     uinput_setup setup{};
     setup.id.bustype = BUS_USB;
@@ -227,6 +169,30 @@ bool UInputKeyboard::ensureInitialized() {
     return true;
 }
 
+void UInputKeyboard::beginBatch() {
+    m_batching = true;
+}
+
+void UInputKeyboard::endBatch() {
+    if (m_shiftHeld) {
+        appendEvents(Keymap::shiftUp().data(), Keymap::shiftUp().size());
+        m_shiftHeld = false;
+    }
+    m_batching = false;
+    m_modifiersReleased = false;
+    if (m_batch.empty()) {
+        return;
+    }
+    if (m_fd >= 0) {
+        const ssize_t size = static_cast<ssize_t>(m_batch.size() * sizeof(input_event));
+        const ssize_t written = write(m_fd, m_batch.data(), size);
+        if (written != size) {
+            logUnavailable(QString("uinput batch write failed (%1).").arg(QString::fromLocal8Bit(strerror(errno))));
+        }
+    }
+    m_batch.clear();
+}
+
 void UInputKeyboard::emitEvent(std::uint16_t type, std::uint16_t code, std::int32_t value) {
     if (m_fd < 0) {
         return;
@@ -235,17 +201,66 @@ void UInputKeyboard::emitEvent(std::uint16_t type, std::uint16_t code, std::int3
     event.type = type;
     event.code = code;
     event.value = value;
+    if (m_batching) {
+        m_batch.push_back(event);
+        return;
+    }
     const ssize_t written = write(m_fd, &event, sizeof(event));
     if (written != static_cast<ssize_t>(sizeof(event))) {
         logUnavailable(QString("uinput write failed (%1).").arg(QString::fromLocal8Bit(strerror(errno))));
     }
 }
 
+void UInputKeyboard::typeChar(QChar ch) {
+    const KeymapEntry *entry = m_keymap.lookup(ch.unicode());
+    if (!entry) {
+        Logging::log(LogLevel::Warn, "COMMIT", QString("Unsupported character for uinput: '%1'").arg(ch));
+        return;
+    }
+    if (Logging::enabled(LogLevel::Debug)) {
+        Logging::log(LogLevel::Debug, "COMMIT",
+                     QString("uinput char='%1' keycode=%2 shift=%3").arg(ch).arg(entry->key).arg(entry->shift ? 1 : 0));
+    }
+    // Once per batch; shift then only changes between runs of shifted and unshifted characters.
+    if (!m_modifiersReleased) {
+        releaseModifiers();
+    }
+    if (entry->shift != m_shiftHeld) {
+        const std::array<input_event, 2> &toggle = entry->shift ? Keymap::shiftDown() : Keymap::shiftUp();
+        appendEvents(toggle.data(), toggle.size());
+        m_shiftHeld = entry->shift;
+    }
+    appendEvents(entry->events.data(), entry->events.size());
+}
+
+void UInputKeyboard::appendEvents(const input_event *events, std::size_t count) {
+    if (m_fd < 0) {
+        return;
+    }
+    m_batch.insert(m_batch.end(), events, events + count);
+}
+
+void UInputKeyboard::releaseModifiers() {
+    m_shiftHeld = false;
+    m_modifiersReleased = m_batching;
+    // Guard against stuck modifiers from the host session.
+    emitEvent(EV_KEY, KEY_LEFTSHIFT, 0);
+    emitEvent(EV_KEY, KEY_RIGHTSHIFT, 0);
+    emitEvent(EV_KEY, KEY_LEFTCTRL, 0);
+    emitEvent(EV_KEY, KEY_RIGHTCTRL, 0);
+    emitEvent(EV_KEY, KEY_LEFTALT, 0);
+    emitEvent(EV_KEY, KEY_RIGHTALT, 0);
+    emitEvent(EV_KEY, KEY_LEFTMETA, 0);
+    emitEvent(EV_KEY, KEY_RIGHTMETA, 0);
+    emitSync();
+}
+
 void UInputKeyboard::emitSync() {
     emitEvent(EV_SYN, SYN_REPORT, 0);
 }
 
 void UInputKeyboard::logUnavailable(const QString &reason) {
+    Metrics::increment(Counter::UInputFailures);
     if (!m_errorLogged) {
         Logging::log(LogLevel::Error, "COMMIT", reason);
         m_errorLogged = true;
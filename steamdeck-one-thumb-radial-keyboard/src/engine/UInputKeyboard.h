@@ -3,28 +3,58 @@
 #include <QString>
 #include <QtGlobal>
 #include <cstdint>
+#include <vector>
+
+struct input_event;
 
 namespace radialkb {
 
+class Keymap;
+
 class UInputKeyboard {
 public:
     UInputKeyboard();
+    // Writes events to an already-open fd (e.g. /dev/null for benchmarks); takes ownership.
+    explicit UInputKeyboard(int adoptedFd);
     ~UInputKeyboard();
 
     bool available() const;
     void sendKey(int linuxKeyCode, bool pressRelease = true);
+    // Presses modifierKeyCode around one press/release of linuxKeyCode (e.g. ctrl+backspace).
+    void sendChord(int modifierKeyCode, int linuxKeyCode);
+    // Characters go through the compiled Keymap; shift is pressed once per run of shifted
+    // characters, including across calls inside one batch.
+    void sendChar(QChar ch);
     void sendText(const QString &text);
 
+    // Events sent between beginBatch() and endBatch() are buffered and written with a single
+    // write(), so the compositor sees the whole sequence at once.
+    void beginBatch();
+    void endBatch();
+
 private:
     bool ensureInitialized();
     void emitEvent(std::uint16_t type, std::uint16_t code, std::int32_t value);
     void emitSync();
+    void releaseModifiers();
+    // Appends one character's events; the caller holds a batch open.
+    void typeChar(QChar ch);
+    void appendEvents(const input_event *events, std::size_t count);
+
+    // Room for a replace() burst without reallocating.
+    static constexpr std::size_t kBatchReserve = 512;
     void logUnavailable(const QString &reason);
 
     int m_fd;
+    bool m_adopted;
     bool m_available;
     bool m_errorLogged;
     qint64 m_lastInitAttemptMs;
+    bool m_batching{false};
+    bool m_shiftHeld{false};
+    bool m_modifiersReleased{false};
+    const Keymap &m_keymap;
+    std::vector<input_event> m_batch;
 };
 
 } // namespace radialkb
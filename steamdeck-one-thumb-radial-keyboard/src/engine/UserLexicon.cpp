@@ -0,0 +1,572 @@
+#include "UserLexicon.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "Dictionary.h"
+#include "Logging.h"
+
+namespace radialkb {
+
+namespace {
+
+constexpr char kSnapshotMagic[4] = {'R', 'K', 'L', 'X'};
+constexpr std::uint32_t kSnapshotVersion = 1;
+constexpr int kWordBytes = Dictionary::kMaxWordLength;
+
+// On-disk layout, host byte order: header, then wordCount WordRecords sorted by word, then
+// bigramCount BigramRecords sorted by (first, second).
+struct SnapshotHeader {
+    char magic[4];
+    std::uint32_t version;
+    // Log segments up to and including this generation are folded in.
+    std::uint64_t foldedGeneration;
+    std::uint32_t wordCount;
+    std::uint32_t bigramCount;
+};
+
+struct WordRecord {
+    char word[kWordBytes];  // NUL padded
+    std::uint32_t count;
+};
+
+struct BigramRecord {
+    std::uint32_t first;  // WordRecord indices
+    std::uint32_t second;
+    std::uint32_t count;
+};
+
+bool wordLess(const WordRecord &record, const char *padded) {
+    return std::memcmp(record.word, padded, kWordBytes) < 0;
+}
+
+void padWord(const QByteArray &word, char (&padded)[kWordBytes]) {
+    std::memset(padded, 0, kWordBytes);
+    std::memcpy(padded, word.constData(), std::min<int>(word.size(), kWordBytes));
+}
+
+std::uint32_t saturatingAdd(std::uint32_t a, std::uint32_t b) {
+    return a > std::numeric_limits<std::uint32_t>::max() - b ? std::numeric_limits<std::uint32_t>::max() : a + b;
+}
+
+} // namespace
+
+struct UserLexicon::Snapshot {
+    void *data = MAP_FAILED;
+    std::size_t size = 0;
+    const WordRecord *words = nullptr;
+    const BigramRecord *bigrams = nullptr;
+    std::uint32_t wordCount = 0;
+    std::uint32_t bigramCount = 0;
+    std::uint64_t foldedGeneration = 0;
+
+    ~Snapshot() {
+        if (data != MAP_FAILED) {
+            munmap(data, size);
+        }
+    }
+
+    static std::unique_ptr<Snapshot> map(const QString &path) {
+        const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat info {};
+        auto snapshot = std::make_unique<Snapshot>();
+        if (fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(SnapshotHeader))) {
+            snapshot->size = static_cast<std::size_t>(info.st_size);
+            snapshot->data = mmap(nullptr, snapshot->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (snapshot->data == MAP_FAILED) {
+            return nullptr;
+        }
+        SnapshotHeader header;
+        std::memcpy(&header, snapshot->data, sizeof(header));
+        const std::size_t expected = sizeof(SnapshotHeader) + std::size_t(header.wordCount) * sizeof(WordRecord)
+            + std::size_t(header.bigramCount) * sizeof(BigramRecord);
+        if (std::memcmp(header.magic, kSnapshotMagic, 4) != 0 || header.version != kSnapshotVersion
+            || expected != snapshot->size) {
+            return nullptr;
+        }
+        const char *base = static_cast<const char *>(snapshot->data);
+        snapshot->words = reinterpret_cast<const WordRecord *>(base + sizeof(SnapshotHeader));
+        snapshot->bigrams = reinterpret_cast<const BigramRecord *>(snapshot->words + header.wordCount);
+        snapshot->wordCount = header.wordCount;
+        snapshot->bigramCount = header.bigramCount;
+        snapshot->foldedGeneration = header.foldedGeneration;
+        return snapshot;
+    }
+
+    // Index of word, or -1.
+    int find(const QByteArray &word) const {
+        char padded[kWordBytes];
+        padWord(word, padded);
+        const WordRecord *end = words + wordCount;
+        const WordRecord *it = std::lower_bound(words, end, padded, wordLess);
+        return it != end && std::memcmp(it->word, padded, kWordBytes) == 0 ? static_cast<int>(it - words) : -1;
+    }
+
+    std::uint32_t bigram(int first, int second) const {
+        const BigramRecord key{std::uint32_t(first), std::uint32_t(second), 0};
+        const BigramRecord *end = bigrams + bigramCount;
+        const BigramRecord *it = std::lower_bound(bigrams, end, key, [](const BigramRecord &a, const BigramRecord &b) {
+            return a.first != b.first ? a.first < b.first : a.second < b.second;
+        });
+        return it != end && it->first == key.first && it->second == key.second ? it->count : 0;
+    }
+
+    QByteArray word(std::uint32_t index) const {
+        const char *text = words[index].word;
+        return QByteArray(text, int(strnlen(text, kWordBytes)));
+    }
+};
+
+UserLexicon::UserLexicon(UserLexiconConfig config)
+    : m_config(config) {
+}
+
+UserLexicon::~UserLexicon() {
+    close();
+}
+
+bool UserLexicon::open(const QString &directory) {
+    close();
+    m_words.clear();
+    m_bigrams.clear();
+    m_previous.clear();
+    m_tailRecords = 0;
+    if (!QDir().mkpath(directory)) {
+        return false;
+    }
+    m_directory = directory;
+    m_snapshot = Snapshot::map(snapshotPath());
+    const std::uint64_t folded = m_snapshot ? m_snapshot->foldedGeneration : 0;
+
+    // Replay the segments written after the snapshot, oldest first; older ones are leftovers
+    // of a compaction interrupted before it could delete them.
+    QVector<std::uint64_t> generations;
+    const QStringList names = QDir(directory).entryList({QStringLiteral("learned-*.log")}, QDir::Files);
+    for (const QString &name : names) {
+        bool ok = false;
+        const std::uint64_t generation = name.mid(8, name.size() - 12).toULongLong(&ok);
+        if (!ok) {
+            continue;
+        }
+        if (generation <= folded) {
+            QFile::remove(segmentPath(generation));
+        } else {
+            generations.push_back(generation);
+        }
+    }
+    std::sort(generations.begin(), generations.end());
+    for (const std::uint64_t generation : generations) {
+        if (!replaySegment(segmentPath(generation))) {
+            Logging::log(LogLevel::Warn, "LEARN", QString("could not read %1").arg(segmentPath(generation)));
+        }
+    }
+    const std::uint64_t generation = generations.isEmpty() ? folded + 1 : generations.last();
+    m_logFd = openSegment(generation);
+    if (m_logFd < 0) {
+        return false;
+    }
+    m_generation = generation;
+    m_logStop = false;
+    m_logWriter = std::thread([this]() { runLogWriter(); });
+    Logging::log(LogLevel::Info, "LEARN", QString("user lexicon: %1 snapshot words, %2 log records replayed")
+                                              .arg(snapshotWords())
+                                              .arg(m_tailRecords));
+    if (m_tailRecords >= m_config.compactAfter) {
+        compact();
+    }
+    return true;
+}
+
+void UserLexicon::close() {
+    waitForCompaction();
+    if (m_logWriter.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_logMutex);
+            m_logStop = true;
+        }
+        m_logWake.notify_one();
+        // It writes and syncs everything queued before it exits.
+        m_logWriter.join();
+    }
+    if (m_logFd >= 0) {
+        ::close(m_logFd);
+        m_logFd = -1;
+    }
+}
+
+void UserLexicon::learnWord(const QByteArray &word) {
+    if (!isLearnable(word)) {
+        breakContext();
+        return;
+    }
+    collectCompaction();
+    QByteArray record = "w " + word + '\n';
+    add(m_words, word, 1);
+    if (!m_previous.isEmpty()) {
+        add(m_bigrams, bigramKey(m_previous, word), 1);
+        record += "b " + m_previous + ' ' + word + '\n';
+    }
+    m_previous = word;
+    ++m_tailRecords;
+    appendRecord(record);
+    if (m_tailRecords >= m_config.compactAfter) {
+        compact();
+    }
+}
+
+std::uint32_t UserLexicon::wordCount(const QByteArray &word) const {
+    std::uint32_t count = saturatingAdd(lookup(m_words, word), lookup(m_foldingWords, word));
+    if (m_snapshot) {
+        const int index = m_snapshot->find(word);
+        if (index >= 0) {
+            count = saturatingAdd(count, m_snapshot->words[index].count);
+        }
+    }
+    return count;
+}
+
+std::uint32_t UserLexicon::bigramCount(const QByteArray &first, const QByteArray &second) const {
+    const QByteArray key = bigramKey(first, second);
+    std::uint32_t count = saturatingAdd(lookup(m_bigrams, key), lookup(m_foldingBigrams, key));
+    if (m_snapshot) {
+        const int firstIndex = m_snapshot->find(first);
+        const int secondIndex = firstIndex >= 0 ? m_snapshot->find(second) : -1;
+        if (secondIndex >= 0) {
+            count = saturatingAdd(count, m_snapshot->bigram(firstIndex, secondIndex));
+        }
+    }
+    return count;
+}
+
+void UserLexicon::sync() {
+    if (!isOpen()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_logMutex);
+        m_syncRequested = true;
+    }
+    m_logWake.notify_one();
+}
+
+bool UserLexicon::compact() {
+    collectCompaction();
+    if (!isOpen() || m_compaction.joinable() || m_tailRecords == 0) {
+        return false;
+    }
+    // Later records go to a new segment, so the folded ones can be deleted as a whole. The
+    // writer finishes (and syncs) the current one before it switches.
+    const std::uint64_t folding = m_generation;
+    const int nextFd = openSegment(folding + 1);
+    if (nextFd < 0) {
+        return false;
+    }
+    {
+        std::unique_lock<std::mutex> lock(m_logMutex);
+        // The previous switch was a whole compaction ago; it has long been taken.
+        m_logSwitched.wait(lock, [this]() { return m_nextLogFd < 0; });
+        m_retiringPending.swap(m_logPending);
+        m_retiringRecords = m_logPendingRecords;
+        m_logPendingRecords = 0;
+        m_nextLogFd = nextFd;
+    }
+    m_logWake.notify_one();
+    m_generation = folding + 1;
+    m_foldingWords.swap(m_words);
+    m_foldingBigrams.swap(m_bigrams);
+    m_foldingRecords = m_tailRecords;
+    m_tailRecords = 0;
+    m_foldingGeneration = folding;
+    m_compactionDone.store(false);
+    const Snapshot *base = m_snapshot.get();
+    const QString path = snapshotPath();
+    m_compaction = std::thread([this, path, base, folding]() {
+        m_compactionOk = writeSnapshot(path, base, m_foldingWords, m_foldingBigrams, folding);
+        m_compactionDone.store(true, std::memory_order_release);
+    });
+    return true;
+}
+
+void UserLexicon::waitForCompaction() {
+    if (m_compaction.joinable()) {
+        m_compaction.join();
+        installCompaction();
+    }
+}
+
+void UserLexicon::collectCompaction() {
+    if (m_compaction.joinable() && m_compactionDone.load(std::memory_order_acquire)) {
+        m_compaction.join();
+        installCompaction();
+    }
+}
+
+void UserLexicon::installCompaction() {
+    std::unique_ptr<Snapshot> snapshot = m_compactionOk ? Snapshot::map(snapshotPath()) : nullptr;
+    if (!snapshot) {
+        // Keep the counts in memory; the next compaction folds them again, and the segments
+        // stay on disk until one succeeds.
+        Logging::log(LogLevel::Warn, "LEARN", "compaction failed; keeping the log");
+        for (auto it = m_foldingWords.cbegin(); it != m_foldingWords.cend(); ++it) {
+            add(m_words, it.key(), it.value());
+        }
+        for (auto it = m_foldingBigrams.cbegin(); it != m_foldingBigrams.cend(); ++it) {
+            add(m_bigrams, it.key(), it.value());
+        }
+        m_tailRecords += m_foldingRecords;
+    } else {
+        m_snapshot = std::move(snapshot);
+        for (std::uint64_t generation = m_foldingGeneration;
+             generation > 0 && QFile::exists(segmentPath(generation)); --generation) {
+            QFile::remove(segmentPath(generation));
+        }
+        Logging::log(LogLevel::Info, "LEARN", QString("compacted %1 log records into %2 words")
+                                                  .arg(m_foldingRecords)
+                                                  .arg(snapshotWords()));
+    }
+    m_foldingWords.clear();
+    m_foldingBigrams.clear();
+    m_foldingRecords = 0;
+}
+
+int UserLexicon::snapshotWords() const {
+    return m_snapshot ? static_cast<int>(m_snapshot->wordCount) : 0;
+}
+
+QString UserLexicon::defaultDirectory() {
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/radialkb/learning";
+}
+
+bool UserLexicon::isLearnable(const QByteArray &word) {
+    if (word.size() < 1 || word.size() > Dictionary::kMaxWordLength) {
+        return false;
+    }
+    for (char ch : word) {
+        if (ch < 'a' || ch > 'z') {
+            return false;
+        }
+    }
+    return true;
+}
+
+QByteArray UserLexicon::bigramKey(const QByteArray &first, const QByteArray &second) {
+    return first + ' ' + second;
+}
+
+void UserLexicon::add(Counts &counts, const QByteArray &key, std::uint32_t amount) {
+    std::uint32_t &count = counts[key];
+    count = saturatingAdd(count, amount);
+}
+
+std::uint32_t UserLexicon::lookup(const Counts &counts, const QByteArray &key) {
+    return counts.value(key, 0);
+}
+
+QString UserLexicon::segmentPath(std::uint64_t generation) const {
+    return m_directory + QString("/learned-%1.log").arg(generation);
+}
+
+QString UserLexicon::snapshotPath() const {
+    return m_directory + "/learned.snap";
+}
+
+bool UserLexicon::replaySegment(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    // A record torn by a crash has no newline yet and is dropped.
+    const int end = data.lastIndexOf('\n') + 1;
+    int start = 0;
+    while (start < end) {
+        const int newline = data.indexOf('\n', start);
+        const QList<QByteArray> fields = data.mid(start, newline - start).split(' ');
+        start = newline + 1;
+        if (fields.size() == 2 && fields.at(0) == "w" && isLearnable(fields.at(1))) {
+            add(m_words, fields.at(1), 1);
+            ++m_tailRecords;
+        } else if (fields.size() == 3 && fields.at(0) == "b" && isLearnable(fields.at(1)) && isLearnable(fields.at(2))) {
+            add(m_bigrams, bigramKey(fields.at(1), fields.at(2)), 1);
+        }
+    }
+    return true;
+}
+
+int UserLexicon::openSegment(std::uint64_t generation) {
+    const QByteArray path = QFile::encodeName(segmentPath(generation));
+    const int fd = ::open(path.constData(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        Logging::log(LogLevel::Warn, "LEARN", QString("could not open %1: %2")
+                                                  .arg(segmentPath(generation))
+                                                  .arg(QString::fromLocal8Bit(strerror(errno))));
+        return -1;
+    }
+    // Terminate a torn last record so the next one starts on its own line.
+    struct stat info {};
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        QFile existing(segmentPath(generation));
+        if (existing.open(QIODevice::ReadOnly) && existing.seek(info.st_size - 1) && existing.read(1) != "\n") {
+            [[maybe_unused]] const ssize_t written = ::write(fd, "\n", 1);
+        }
+    }
+    return fd;
+}
+
+void UserLexicon::appendRecord(const QByteArray &record) {
+    if (!isOpen()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_logMutex);
+        m_logPending += record;
+        ++m_logPendingRecords;
+    }
+    m_logWake.notify_one();
+}
+
+void UserLexicon::runLogWriter() {
+    // Shows up in traces and top -H.
+    pthread_setname_np(pthread_self(), "radialkb-learn");
+    QByteArray batch;
+    QByteArray retiring;
+    int unsynced = 0;
+    for (;;) {
+        int records = 0;
+        int retiringRecords = 0;
+        int nextFd = -1;
+        bool syncRequested = false;
+        bool stop = false;
+        {
+            std::unique_lock<std::mutex> lock(m_logMutex);
+            m_logWake.wait(lock, [this]() {
+                return m_logStop || m_syncRequested || m_nextLogFd >= 0 || !m_logPending.isEmpty();
+            });
+            batch.swap(m_logPending);
+            records = std::exchange(m_logPendingRecords, 0);
+            retiring.swap(m_retiringPending);
+            retiringRecords = std::exchange(m_retiringRecords, 0);
+            nextFd = std::exchange(m_nextLogFd, -1);
+            syncRequested = std::exchange(m_syncRequested, false);
+            stop = m_logStop;
+        }
+        if (nextFd >= 0) {
+            m_logSwitched.notify_all();
+            // The finished segment is complete and durable before the next one is written.
+            writeLog(m_logFd, retiring);
+            if (unsynced + retiringRecords > 0) {
+                fdatasync(m_logFd);
+            }
+            ::close(m_logFd);
+            m_logFd = nextFd;
+            unsynced = 0;
+            retiring.resize(0);
+        }
+        writeLog(m_logFd, batch);
+        batch.resize(0);
+        unsynced += records;
+        if (unsynced > 0 && (unsynced >= m_config.syncEvery || syncRequested || stop)) {
+            fdatasync(m_logFd);
+            unsynced = 0;
+        }
+        if (stop) {
+            return;
+        }
+    }
+}
+
+void UserLexicon::writeLog(int fd, const QByteArray &data) {
+    if (data.isEmpty()) {
+        return;
+    }
+    if (::write(fd, data.constData(), data.size()) != data.size()) {
+        Logging::log(LogLevel::Warn, "LEARN", QString("log write failed: %1").arg(QString::fromLocal8Bit(strerror(errno))));
+    }
+}
+
+bool UserLexicon::writeSnapshot(const QString &path, const Snapshot *base, const Counts &words,
+                                const Counts &bigrams, std::uint64_t foldedGeneration) {
+    // Merge into sorted word order; every bigram's words are counted as words too.
+    QHash<QByteArray, std::uint32_t> merged = words;
+    QHash<QByteArray, std::uint32_t> mergedBigrams = bigrams;
+    if (base) {
+        for (std::uint32_t i = 0; i < base->wordCount; ++i) {
+            std::uint32_t &count = merged[base->word(i)];
+            count = saturatingAdd(count, base->words[i].count);
+        }
+        for (std::uint32_t i = 0; i < base->bigramCount; ++i) {
+            const BigramRecord &record = base->bigrams[i];
+            std::uint32_t &count = mergedBigrams[bigramKey(base->word(record.first), base->word(record.second))];
+            count = saturatingAdd(count, record.count);
+        }
+    }
+    QVector<WordRecord> wordRecords;
+    wordRecords.reserve(merged.size());
+    for (auto it = merged.cbegin(); it != merged.cend(); ++it) {
+        WordRecord record{};
+        padWord(it.key(), record.word);
+        record.count = it.value();
+        wordRecords.push_back(record);
+    }
+    std::sort(wordRecords.begin(), wordRecords.end(), [](const WordRecord &a, const WordRecord &b) {
+        return std::memcmp(a.word, b.word, kWordBytes) < 0;
+    });
+    QHash<QByteArray, std::uint32_t> indexOf;
+    indexOf.reserve(wordRecords.size());
+    for (int i = 0; i < wordRecords.size(); ++i) {
+        const char *text = wordRecords.at(i).word;
+        indexOf.insert(QByteArray(text, int(strnlen(text, kWordBytes))), std::uint32_t(i));
+    }
+    QVector<BigramRecord> bigramRecords;
+    bigramRecords.reserve(mergedBigrams.size());
+    for (auto it = mergedBigrams.cbegin(); it != mergedBigrams.cend(); ++it) {
+        const int space = it.key().indexOf(' ');
+        const auto first = indexOf.constFind(it.key().left(space));
+        const auto second = indexOf.constFind(it.key().mid(space + 1));
+        if (first != indexOf.cend() && second != indexOf.cend()) {
+            bigramRecords.push_back(BigramRecord{first.value(), second.value(), it.value()});
+        }
+    }
+    std::sort(bigramRecords.begin(), bigramRecords.end(), [](const BigramRecord &a, const BigramRecord &b) {
+        return a.first != b.first ? a.first < b.first : a.second < b.second;
+    });
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kSnapshotMagic, 4);
+    header.version = kSnapshotVersion;
+    header.foldedGeneration = foldedGeneration;
+    header.wordCount = std::uint32_t(wordRecords.size());
+    header.bigramCount = std::uint32_t(bigramRecords.size());
+    // QSaveFile writes a temporary file, syncs it and renames it over the old snapshot, which
+    // stays valid for readers that still have it mapped.
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(wordRecords.constData()), wordRecords.size() * sizeof(WordRecord));
+    file.write(reinterpret_cast<const char *>(bigramRecords.constData()), bigramRecords.size() * sizeof(BigramRecord));
+    return file.commit();
+}
+
+} // namespace radialkb
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// INTENT: Per-user word and bigram counts learned from committed text. Increments are appended
+// INTENT: to a text log by a writer thread (fdatasync in batches), so learning a word never
+// INTENT: blocks the caller on the disk; a background compaction folds
+// INTENT: the log into a sorted binary snapshot that is mmapped read-only. Opening maps the
+// INTENT: snapshot and replays only the log segments written since, so startup cost is bounded
+// INTENT: by the compaction threshold rather than by the user's history.
+
+namespace radialkb {
+
+struct UserLexiconConfig {
+    // Log records between fdatasync calls; sync() forces one.
+    int syncEvery = 32;
+    // Log records since the last snapshot that trigger a background compaction.
+    int compactAfter = 4096;
+};
+
+class UserLexicon {
+public:
+    explicit UserLexicon(UserLexiconConfig config = {});
+    // Waits for a running compaction and for the log writer to sync.
+    ~UserLexicon();
+
+    UserLexicon(const UserLexicon &) = delete;
+    UserLexicon &operator=(const UserLexicon &) = delete;
+
+    // Maps directory/learned.snap and replays the newer learned-<generation>.log segments.
+    // Creates the directory if needed. Without a successful open, learning stays in memory.
+    bool open(const QString &directory);
+    void close();
+    bool isOpen() const { return m_logWriter.joinable(); }
+
+    // Counts a committed word (lowercase a-z, at most Dictionary::kMaxWordLength letters; other
+    // words are ignored and break the bigram context) and the bigram with the previous word.
+    void learnWord(const QByteArray &word);
+    // The next word starts a new context: after sentence punctuation, enter or a focus change.
+    void breakContext() { m_previous.clear(); }
+
+    std::uint32_t wordCount(const QByteArray &word) const;
+    std::uint32_t bigramCount(const QByteArray &first, const QByteArray &second) const;
+
+    // Has the log writer write out and fdatasync pending log records; does not wait for it.
+    // close() (and the destructor) does.
+    void sync();
+    // Starts folding the log into a new snapshot on a background thread. Lookups keep using the
+    // old snapshot plus the in-memory counts until it is done. false when one is already running
+    // or nothing is open.
+    bool compact();
+    // Blocks until a running compaction has finished and installs its snapshot.
+    void waitForCompaction();
+
+    int snapshotWords() const;
+    // Log records not yet folded into the snapshot.
+    int tailRecords() const { return m_tailRecords; }
+
+    // GenericDataLocation/radialkb/learning
+    static QString defaultDirectory();
+
+private:
+    struct Snapshot;
+    using Counts = QHash<QByteArray, std::uint32_t>;
+
+    static bool isLearnable(const QByteArray &word);
+    static QByteArray bigramKey(const QByteArray &first, const QByteArray &second);
+    static void add(Counts &counts, const QByteArray &key, std::uint32_t amount);
+    static std::uint32_t lookup(const Counts &counts, const QByteArray &key);
+    QString segmentPath(std::uint64_t generation) const;
+    QString snapshotPath() const;
+    bool replaySegment(const QString &path);
+    // Opens the segment for appending; -1 on failure.
+    int openSegment(std::uint64_t generation);
+    // Queues a record for the log writer.
+    void appendRecord(const QByteArray &record);
+    // Runs on the log writer thread.
+    void runLogWriter();
+    static void writeLog(int fd, const QByteArray &data);
+    // Installs a finished compaction; no-op while it is still running.
+    void collectCompaction();
+    // After the compaction thread was joined: maps its snapshot and drops the folded segments.
+    void installCompaction();
+    // Runs on the compaction thread.
+    static bool writeSnapshot(const QString &path, const Snapshot *base, const Counts &words,
+                              const Counts &bigrams, std::uint64_t foldedGeneration);
+
+    UserLexiconConfig m_config;
+    QString m_directory;
+    std::unique_ptr<Snapshot> m_snapshot;
+    // Counts logged since the snapshot; m_folding holds those a running compaction is writing.
+    Counts m_words;
+    Counts m_bigrams;
+    Counts m_foldingWords;
+    Counts m_foldingBigrams;
+    QByteArray m_previous;
+    // Owned by the log writer while it runs.
+    int m_logFd{-1};
+    std::uint64_t m_generation{0};
+    int m_tailRecords{0};
+    int m_foldingRecords{0};
+    std::thread m_compaction;
+    std::atomic<bool> m_compactionDone{false};
+    bool m_compactionOk{false};
+    std::uint64_t m_foldingGeneration{0};
+
+    // Log writer state, guarded by m_logMutex. A compaction switches segments by handing over
+    // the next segment's fd with the records still due in the current one.
+    std::thread m_logWriter;
+    std::mutex m_logMutex;
+    std::condition_variable m_logWake;
+    std::condition_variable m_logSwitched;
+    QByteArray m_logPending;
+    int m_logPendingRecords{0};
+    QByteArray m_retiringPending;
+    int m_retiringRecords{0};
+    int m_nextLogFd{-1};
+    bool m_syncRequested{false};
+    bool m_logStop{false};
+};
+
+} // namespace radialkb
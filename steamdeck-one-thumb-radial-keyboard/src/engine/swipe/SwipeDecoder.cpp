@@ -0,0 +1,90 @@
+#include "SwipeDecoder.h"
+
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <limits>
+
+namespace radialkb {
+
+namespace {
+
+struct Scored {
+    int index;
+    double score;
+};
+
+} // namespace
+
+SwipeDecoder::SwipeDecoder(const SwipeTemplateStore &store, SwipeDecoderConfig config)
+    : m_store(store),
+      m_config(config) {
+}
+
+QVector<SwipeCandidate> SwipeDecoder::decode(const SwipePath &path, int maxCandidates) const {
+    const std::shared_ptr<const SwipeTemplateSet> templates = m_store.current();
+    float points[SwipeTemplateSet::kPoints * 2];
+    if (!templates || !path.resample(points, SwipeTemplateSet::kPoints)) {
+        return {};
+    }
+    return decode(*templates, points, maxCandidates, m_config);
+}
+
+QVector<SwipeCandidate> SwipeDecoder::decode(const SwipeTemplateSet &templates, const float *points,
+                                             int maxCandidates, const SwipeDecoderConfig &config) {
+    constexpr int kPoints = SwipeTemplateSet::kPoints;
+    const int wanted = std::clamp(maxCandidates, 0, kMaxCandidates);
+    const float scale = static_cast<float>(1.0 / (2.0 * config.sigma * config.sigma));
+    const float radius2 = static_cast<float>(config.endpointRadius * config.endpointRadius);
+    const float startX = points[0];
+    const float startY = points[1];
+    const float endX = points[2 * kPoints - 2];
+    const float endY = points[2 * kPoints - 1];
+
+    // Sorted best first; only the last entry matters for the early exit.
+    QVarLengthArray<Scored, kMaxCandidates> best;
+    for (int index = 0; index < templates.size() && wanted > 0; ++index) {
+        const SwipeTemplateSet::Template &entry = templates.at(index);
+        const float *ideal = entry.points;
+        const float sx = ideal[0] - startX;
+        const float sy = ideal[1] - startY;
+        const float ex = ideal[2 * kPoints - 2] - endX;
+        const float ey = ideal[2 * kPoints - 1] - endY;
+        if (sx * sx + sy * sy > radius2 || ex * ex + ey * ey > radius2) {
+            continue;
+        }
+        const double prior = config.priorWeight * entry.logPrior;
+        // A word that costs more than this cannot displace the worst kept candidate.
+        const float budget = best.size() < wanted ? std::numeric_limits<float>::infinity()
+                                                  : static_cast<float>(prior - best.constLast().score);
+        float cost = 0.0f;
+        int i = 0;
+        for (; i < kPoints; ++i) {
+            const float dx = ideal[2 * i] - points[2 * i];
+            const float dy = ideal[2 * i + 1] - points[2 * i + 1];
+            cost += (dx * dx + dy * dy) * scale;
+            if (cost >= budget) {
+                break;
+            }
+        }
+        if (i < kPoints) {
+            continue;
+        }
+        const Scored scored{index, prior - cost};
+        if (best.size() == wanted) {
+            best.removeLast();
+        }
+        auto at = std::upper_bound(best.begin(), best.end(), scored,
+                                   [](const Scored &a, const Scored &b) { return a.score > b.score; });
+        best.insert(at, scored);
+    }
+
+    QVector<SwipeCandidate> candidates;
+    candidates.reserve(best.size());
+    for (const Scored &scored : best) {
+        candidates.push_back(SwipeCandidate{templates.word(scored.index), scored.score});
+    }
+    return candidates;
+}
+
+} // namespace radialkb
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+
+#include "SwipePath.h"
+#include "SwipeTemplates.h"
+
+// INTENT: SHARK2-style word decoding: a conditioned swipe, resampled like the templates, is
+// INTENT: scored against every word's ideal path with a Gaussian point-to-point likelihood plus
+// INTENT: the word prior. Templates whose start or end is far from the swipe's are skipped, and
+// INTENT: the sum over points stops as soon as a word cannot enter the current top list.
+
+namespace radialkb {
+
+struct SwipeDecoderConfig {
+    // Spread of swiped points around the ideal path, in pad units (about one key width).
+    double sigma = 0.06;
+    // Weight of the word log prior against the spatial log-likelihood.
+    double priorWeight = 1.0;
+    // Words whose path starts or ends farther than this from the swipe's are not scored.
+    double endpointRadius = 0.2;
+};
+
+struct SwipeCandidate {
+    QByteArray word;
+    // Log-likelihood plus weighted log prior; higher is better.
+    double score = 0.0;
+};
+
+class SwipeDecoder {
+public:
+    static constexpr int kMaxCandidates = 8;
+
+    explicit SwipeDecoder(const SwipeTemplateStore &store, SwipeDecoderConfig config = {});
+
+    // Best words first, at most maxCandidates (capped at kMaxCandidates). Empty while the store
+    // has no template set yet or the path is empty.
+    QVector<SwipeCandidate> decode(const SwipePath &path, int maxCandidates = 3) const;
+    // points holds SwipeTemplateSet::kPoints resampled x, y pairs.
+    static QVector<SwipeCandidate> decode(const SwipeTemplateSet &templates, const float *points, int maxCandidates,
+                                          const SwipeDecoderConfig &config);
+
+    const SwipeDecoderConfig &config() const { return m_config; }
+
+private:
+    const SwipeTemplateStore &m_store;
+    SwipeDecoderConfig m_config;
+};
+
+} // namespace radialkb
@@ -1,2 +1,85 @@
 #include "SwipePath.h"
-// Intentionally minimal in Phase 2a.
+
+#include <QVarLengthArray>
+
+#include <cmath>
+
+namespace radialkb {
+
+SwipePath::SwipePath(SwipePathConfig config)
+    : m_config(config) {
+}
+
+void SwipePath::clear() {
+    m_points.clear();
+}
+
+void SwipePath::addPoint(const QPointF &p) {
+    m_lastRaw = p;
+    if (m_points.isEmpty()) {
+        m_filtered = p;
+        m_points.push_back(p);
+        return;
+    }
+    m_filtered += (p - m_filtered) * m_config.smoothing;
+    const QPointF step = m_filtered - m_points.constLast();
+    if (std::hypot(step.x(), step.y()) >= m_config.minStep) {
+        m_points.push_back(m_filtered);
+    }
+}
+
+bool SwipePath::resample(float *out, int count) const {
+    if (m_points.isEmpty()) {
+        return false;
+    }
+    if (m_lastRaw == m_points.constLast()) {
+        resamplePolyline(m_points.constData(), m_points.size(), out, count);
+        return true;
+    }
+    QVarLengthArray<QPointF, 256> path(m_points.constBegin(), m_points.constEnd());
+    path.append(m_lastRaw);
+    resamplePolyline(path.constData(), path.size(), out, count);
+    return true;
+}
+
+void SwipePath::resamplePolyline(const QPointF *points, int size, float *out, int count) {
+    double total = 0.0;
+    for (int i = 1; i < size; ++i) {
+        total += std::hypot(points[i].x() - points[i - 1].x(), points[i].y() - points[i - 1].y());
+    }
+    if (total <= 0.0 || count < 2) {
+        for (int i = 0; i < count; ++i) {
+            out[2 * i] = static_cast<float>(points[0].x());
+            out[2 * i + 1] = static_cast<float>(points[0].y());
+        }
+        return;
+    }
+    const double interval = total / (count - 1);
+    // Walk the segments once; segmentStart is the arc length at points[segment].
+    int segment = 0;
+    double segmentStart = 0.0;
+    for (int i = 0; i < count - 1; ++i) {
+        const double target = interval * i;
+        double segmentLength = 0.0;
+        while (segment < size - 1) {
+            segmentLength = std::hypot(points[segment + 1].x() - points[segment].x(),
+                                       points[segment + 1].y() - points[segment].y());
+            if (segmentStart + segmentLength >= target) {
+                break;
+            }
+            segmentStart += segmentLength;
+            ++segment;
+        }
+        QPointF point = points[size - 1];
+        if (segment < size - 1) {
+            const double t = segmentLength > 0.0 ? (target - segmentStart) / segmentLength : 0.0;
+            point = points[segment] + (points[segment + 1] - points[segment]) * t;
+        }
+        out[2 * i] = static_cast<float>(point.x());
+        out[2 * i + 1] = static_cast<float>(point.y());
+    }
+    out[2 * (count - 1)] = static_cast<float>(points[size - 1].x());
+    out[2 * (count - 1) + 1] = static_cast<float>(points[size - 1].y());
+}
+
+} // namespace radialkb
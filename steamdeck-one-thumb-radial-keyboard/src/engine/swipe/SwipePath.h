@@ -1,12 +1,44 @@
 #pragma once
-#include <QVector>
+
 #include <QPointF>
+#include <QVector>
 
-// Captures a continuous thumb path on the radial surface.
-// Phase 2a: data collection only (no scoring, no dictionary).
-struct SwipePath {
-    QVector<QPointF> points;
-    void clear() { points.clear(); }
-    void addPoint(const QPointF& p) { points.push_back(p); }
-    bool empty() const { return points.isEmpty(); }
+// INTENT: Captures a continuous thumb path on the radial surface and conditions it for the
+// INTENT: swipe decoder: a light EMA removes trackpad jitter, samples that barely move are
+// INTENT: dropped, and resample() spaces a fixed number of points evenly along the path so
+// INTENT: observed swipes and word templates are compared point for point.
+
+namespace radialkb {
+
+struct SwipePathConfig {
+    // EMA weight of a new sample; 1 disables smoothing.
+    double smoothing = 0.5;
+    // Filtered samples closer than this to the last kept point are dropped, in pad units.
+    double minStep = 0.004;
 };
+
+class SwipePath {
+public:
+    explicit SwipePath(SwipePathConfig config = {});
+
+    void clear();
+    void addPoint(const QPointF &p);
+    bool empty() const { return m_points.isEmpty(); }
+    // Kept (filtered) points; the last raw sample is only added by resample().
+    const QVector<QPointF> &points() const { return m_points; }
+
+    // Writes count points, evenly spaced along the path, to out as x, y pairs. The last raw
+    // sample ends the path, so the filter's lag does not pull the end point back. false when
+    // the path is empty.
+    bool resample(float *out, int count) const;
+    // The same spacing for any polyline; word templates are built with it.
+    static void resamplePolyline(const QPointF *points, int size, float *out, int count);
+
+private:
+    SwipePathConfig m_config;
+    QVector<QPointF> m_points;
+    QPointF m_filtered;
+    QPointF m_lastRaw;
+};
+
+} // namespace radialkb
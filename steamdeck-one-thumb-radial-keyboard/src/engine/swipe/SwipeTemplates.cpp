@@ -0,0 +1,328 @@
+#include "SwipeTemplates.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QPointF>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVarLengthArray>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "Logging.h"
+#include "SwipePath.h"
+
+namespace radialkb {
+
+namespace {
+
+constexpr char kCacheMagic[4] = {'R', 'K', 'S', 'T'};
+constexpr std::uint32_t kCacheVersion = 1;
+// Words per work item: small enough to balance, large enough to keep the counter cold.
+constexpr std::size_t kBuildChunk = 256;
+
+// On-disk layout, host byte order: header, then count Template records.
+struct CacheHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t points;
+    std::uint32_t count;
+    std::uint64_t key;
+};
+
+class Fnv1a {
+public:
+    void add(const void *data, std::size_t size) {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            m_hash = (m_hash ^ bytes[i]) * 0x100000001b3ull;
+        }
+    }
+    template <typename T>
+    void add(const T &value) {
+        add(&value, sizeof(value));
+    }
+    std::uint64_t value() const { return m_hash; }
+
+private:
+    std::uint64_t m_hash{0xcbf29ce484222325ull};
+};
+
+struct BuildJob {
+    const Dictionary::Bucket *bucket;
+    int index;
+};
+
+void buildTemplate(const SwipeTemplateSource &source, const BuildJob &job, SwipeTemplateSet::Template &out) {
+    const int length = job.bucket->length;
+    const char *word = job.bucket->word(job.index);
+    QVarLengthArray<QPointF, Dictionary::kMaxWordLength> path;
+    for (int i = 0; i < length; ++i) {
+        const LayoutPoint &anchor = source.anchors[word[i] - 'a'];
+        path.append(QPointF(anchor.x, anchor.y));
+    }
+    std::memcpy(out.word, word, length);
+    out.logPrior = job.bucket->logPrior.at(job.index);
+    out.length = static_cast<std::uint32_t>(length);
+    SwipePath::resamplePolyline(path.constData(), path.size(), out.points, SwipeTemplateSet::kPoints);
+}
+
+} // namespace
+
+SwipeTemplateSource SwipeTemplateSource::capture(const RadialHitTester &layout, const Dictionary &dictionary) {
+    SwipeTemplateSource source;
+    source.dictionary = dictionary;
+    for (int sector = 0; sector < layout.sectors(); ++sector) {
+        for (int key = 0; key < layout.keyCount(sector); ++key) {
+            const KeyAction action = layout.keyAction(sector, key);
+            if (action.type != KeyAction::Char || action.ch < 'a' || action.ch > 'z') {
+                continue;
+            }
+            source.anchors[action.ch - 'a'] = layout.keyAnchor(sector, key);
+            source.onLayout[action.ch - 'a'] = true;
+        }
+    }
+    return source;
+}
+
+std::uint64_t SwipeTemplateSource::key() const {
+    Fnv1a hash;
+    hash.add(kCacheVersion);
+    hash.add(SwipeTemplateSet::kPoints);
+    for (int letter = 0; letter < kLetters; ++letter) {
+        hash.add(onLayout[letter]);
+        hash.add(anchors[letter].x);
+        hash.add(anchors[letter].y);
+    }
+    for (int length = 1; length <= Dictionary::kMaxWordLength; ++length) {
+        const Dictionary::Bucket &bucket = dictionary.wordsOfLength(length);
+        hash.add(length);
+        hash.add(bucket.size());
+        hash.add(bucket.letters.constData(), bucket.letters.size());
+        hash.add(bucket.logPrior.constData(), bucket.logPrior.size() * sizeof(float));
+    }
+    return hash.value();
+}
+
+SwipeTemplateSet::~SwipeTemplateSet() {
+    if (m_mapping) {
+        munmap(m_mapping, m_mappingSize);
+    }
+}
+
+std::shared_ptr<const SwipeTemplateSet> SwipeTemplateSet::build(const SwipeTemplateSource &source, int threads,
+                                                                const std::atomic<bool> *cancel) {
+    std::vector<BuildJob> jobs;
+    jobs.reserve(source.dictionary.size());
+    for (int length = 1; length <= Dictionary::kMaxWordLength; ++length) {
+        const Dictionary::Bucket &bucket = source.dictionary.wordsOfLength(length);
+        for (int index = 0; index < bucket.size(); ++index) {
+            const char *word = bucket.word(index);
+            bool typeable = true;
+            for (int i = 0; i < length; ++i) {
+                typeable = typeable && source.onLayout[word[i] - 'a'];
+            }
+            if (typeable) {
+                jobs.push_back(BuildJob{&bucket, index});
+            }
+        }
+    }
+
+    std::shared_ptr<SwipeTemplateSet> set(new SwipeTemplateSet);
+    set->m_key = source.key();
+    set->m_built.resize(jobs.size());
+    const std::size_t chunks = (jobs.size() + kBuildChunk - 1) / kBuildChunk;
+    std::size_t workers = threads > 0 ? std::size_t(threads) : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::max<std::size_t>(1, std::min(workers, chunks));
+
+    // Workers claim chunks from a shared counter and write disjoint records, so the only
+    // synchronization is the counter and the final join.
+    std::atomic<std::size_t> next{0};
+    auto work = [&]() {
+        for (;;) {
+            const std::size_t begin = next.fetch_add(kBuildChunk);
+            if (begin >= jobs.size() || (cancel && cancel->load())) {
+                return;
+            }
+            const std::size_t end = std::min(begin + kBuildChunk, jobs.size());
+            for (std::size_t i = begin; i < end; ++i) {
+                buildTemplate(source, jobs[i], set->m_built[i]);
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (std::size_t i = 1; i < workers; ++i) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+    if (cancel && cancel->load()) {
+        return nullptr;
+    }
+    set->m_templates = set->m_built.data();
+    set->m_count = static_cast<int>(set->m_built.size());
+    return set;
+}
+
+std::shared_ptr<const SwipeTemplateSet> SwipeTemplateSet::map(const QString &path, std::uint64_t key) {
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info {};
+    void *data = MAP_FAILED;
+    std::size_t size = 0;
+    if (fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(CacheHeader))) {
+        size = static_cast<std::size_t>(info.st_size);
+        data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    std::shared_ptr<SwipeTemplateSet> set(new SwipeTemplateSet);
+    set->m_mapping = data;
+    set->m_mappingSize = size;
+    CacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kCacheMagic, 4) != 0 || header.version != kCacheVersion
+        || header.points != std::uint32_t(kPoints) || header.key != key
+        || size != sizeof(CacheHeader) + std::size_t(header.count) * sizeof(Template)) {
+        return nullptr;
+    }
+    // Every decode scans the whole set; fault it in now rather than on the first swipe.
+    madvise(data, size, MADV_WILLNEED);
+    set->m_key = key;
+    set->m_templates = reinterpret_cast<const Template *>(static_cast<const char *>(data) + sizeof(CacheHeader));
+    set->m_count = static_cast<int>(header.count);
+    return set;
+}
+
+bool SwipeTemplateSet::save(const QString &path) const {
+    CacheHeader header{};
+    std::memcpy(header.magic, kCacheMagic, 4);
+    header.version = kCacheVersion;
+    header.points = kPoints;
+    header.count = static_cast<std::uint32_t>(m_count);
+    header.key = m_key;
+    // Readers that still map an older file keep their copy; the rename replaces it atomically.
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(m_templates), qint64(m_count) * qint64(sizeof(Template)));
+    return file.commit();
+}
+
+QByteArray SwipeTemplateSet::word(int index) const {
+    const Template &entry = m_templates[index];
+    return QByteArray(entry.word, static_cast<int>(entry.length));
+}
+
+SwipeTemplateStore::SwipeTemplateStore(const QString &cacheDirectory)
+    : m_directory(cacheDirectory) {
+}
+
+SwipeTemplateStore::~SwipeTemplateStore() {
+    cancelBuild();
+}
+
+void SwipeTemplateStore::prepare(const RadialHitTester &layout, const Dictionary &dictionary) {
+    SwipeTemplateSource source = SwipeTemplateSource::capture(layout, dictionary);
+    const std::uint64_t key = source.key();
+    cancelBuild();
+    const std::shared_ptr<const SwipeTemplateSet> active = current();
+    if (active && active->key() == key) {
+        return;
+    }
+    const QString path = m_directory.isEmpty() ? QString() : cachePath(key);
+    if (!path.isEmpty()) {
+        if (std::shared_ptr<const SwipeTemplateSet> cached = SwipeTemplateSet::map(path, key)) {
+            Logging::log(LogLevel::Info, "SWIPE", QString("mapped %1 word templates from %2").arg(cached->size()).arg(path));
+            install(std::move(cached));
+            return;
+        }
+    }
+
+    m_building = true;
+    m_builder = std::thread([this, source = std::move(source), path, directory = m_directory]() {
+        QElapsedTimer timer;
+        timer.start();
+        std::shared_ptr<const SwipeTemplateSet> set = SwipeTemplateSet::build(source, 0, &m_cancel);
+        if (set) {
+            Logging::log(LogLevel::Info, "SWIPE", QString("built %1 word templates in %2 ms")
+                                                      .arg(set->size())
+                                                      .arg(timer.elapsed()));
+            if (!path.isEmpty()) {
+                if (QDir().mkpath(directory) && set->save(path)) {
+                    removeStaleCaches(directory, set->key());
+                } else {
+                    Logging::log(LogLevel::Warn, "SWIPE", QString("cannot write template cache %1").arg(path));
+                }
+            }
+            install(std::move(set));
+        }
+        m_building = false;
+    });
+}
+
+std::shared_ptr<const SwipeTemplateSet> SwipeTemplateStore::current() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_current;
+}
+
+void SwipeTemplateStore::waitForBuild() {
+    if (m_builder.joinable()) {
+        m_builder.join();
+    }
+}
+
+QString SwipeTemplateStore::cachePath(std::uint64_t key) const {
+    return m_directory + QString("/templates-%1.bin").arg(key, 16, 16, QChar('0'));
+}
+
+QString SwipeTemplateStore::defaultCacheDirectory() {
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/radialkb";
+}
+
+void SwipeTemplateStore::cancelBuild() {
+    if (!m_builder.joinable()) {
+        return;
+    }
+    m_cancel = true;
+    m_builder.join();
+    m_cancel = false;
+}
+
+void SwipeTemplateStore::install(std::shared_ptr<const SwipeTemplateSet> set) {
+    std::shared_ptr<const SwipeTemplateSet> previous;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        previous = std::move(m_current);
+        m_current = std::move(set);
+    }
+    // The old set is released outside the lock; decodes still holding it finish first.
+}
+
+void SwipeTemplateStore::removeStaleCaches(const QString &directory, std::uint64_t keep) {
+    const QString kept = QString("templates-%1.bin").arg(keep, 16, 16, QChar('0'));
+    const QStringList names = QDir(directory).entryList({"templates-*.bin"}, QDir::Files);
+    for (const QString &name : names) {
+        if (name != kept) {
+            QFile::remove(directory + "/" + name);
+        }
+    }
+}
+
+} // namespace radialkb
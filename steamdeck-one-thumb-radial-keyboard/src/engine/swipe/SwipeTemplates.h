@@ -0,0 +1,122 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Dictionary.h"
+#include "RadialHitTester.h"
+
+// INTENT: Ideal swipe paths ("templates") of every dictionary word over the layout's letter
+// INTENT: anchors, resampled to a fixed point count. They depend only on the word list and the
+// INTENT: anchor positions, so a set is built once, in parallel, written to a cache file named
+// INTENT: after a hash of both and mmapped on later starts. The store keeps serving the previous
+// INTENT: set while a changed layout or dictionary is rebuilt in the background.
+
+namespace radialkb {
+
+// Everything a template set is built from, copied so a background build never touches the
+// live layout or dictionary.
+struct SwipeTemplateSource {
+    static constexpr int kLetters = 26;
+
+    std::array<LayoutPoint, kLetters> anchors{};
+    std::array<bool, kLetters> onLayout{};
+    Dictionary dictionary;
+
+    static SwipeTemplateSource capture(const RadialHitTester &layout, const Dictionary &dictionary);
+    // FNV-1a over the cache format, the anchors and every word with its prior.
+    std::uint64_t key() const;
+};
+
+class SwipeTemplateSet {
+public:
+    static constexpr int kPoints = 32;
+
+    // Also the cache file record, host byte order.
+    struct Template {
+        char word[Dictionary::kMaxWordLength];  // NUL padded
+        float logPrior;
+        std::uint32_t length;
+        float points[kPoints * 2];  // x, y pairs
+    };
+
+    ~SwipeTemplateSet();
+    SwipeTemplateSet(const SwipeTemplateSet &) = delete;
+    SwipeTemplateSet &operator=(const SwipeTemplateSet &) = delete;
+
+    // Splits the words over threads workers (0: one per core). Words with a letter missing from
+    // the layout get no template. Returns nullptr once cancel is set.
+    static std::shared_ptr<const SwipeTemplateSet> build(const SwipeTemplateSource &source, int threads = 0,
+                                                         const std::atomic<bool> *cancel = nullptr);
+    // nullptr when the file is missing, truncated or was built for another key.
+    static std::shared_ptr<const SwipeTemplateSet> map(const QString &path, std::uint64_t key);
+    bool save(const QString &path) const;
+
+    std::uint64_t key() const { return m_key; }
+    int size() const { return m_count; }
+    bool mapped() const { return m_mapping != nullptr; }
+    const Template &at(int index) const { return m_templates[index]; }
+    QByteArray word(int index) const;
+
+private:
+    SwipeTemplateSet() = default;
+
+    std::uint64_t m_key{0};
+    const Template *m_templates{nullptr};
+    int m_count{0};
+    // Built sets own their templates; mapped ones point into the mapping.
+    std::vector<Template> m_built;
+    void *m_mapping{nullptr};
+    std::size_t m_mappingSize{0};
+};
+
+class SwipeTemplateStore {
+public:
+    // An empty cache directory builds every time and writes nothing.
+    explicit SwipeTemplateStore(const QString &cacheDirectory = QString());
+    // Cancels a running build.
+    ~SwipeTemplateStore();
+
+    SwipeTemplateStore(const SwipeTemplateStore &) = delete;
+    SwipeTemplateStore &operator=(const SwipeTemplateStore &) = delete;
+
+    void setCacheDirectory(const QString &directory) { m_directory = directory; }
+    const QString &cacheDirectory() const { return m_directory; }
+
+    // Makes the templates of layout and dictionary current. A cache file for them is mapped
+    // right away; otherwise they are built on a background thread, cached and installed when
+    // done, and the previous set keeps serving until then. A build for an older source is
+    // cancelled.
+    void prepare(const RadialHitTester &layout, const Dictionary &dictionary);
+    // nullptr until the first set is ready. Safe from any thread.
+    std::shared_ptr<const SwipeTemplateSet> current() const;
+    bool building() const { return m_building.load(); }
+    void waitForBuild();
+
+    QString cachePath(std::uint64_t key) const;
+    // GenericCacheLocation (XDG_CACHE_HOME)/radialkb
+    static QString defaultCacheDirectory();
+
+private:
+    void cancelBuild();
+    void install(std::shared_ptr<const SwipeTemplateSet> set);
+    // Cache files of other keys; a layout or word list change leaves them unreachable.
+    static void removeStaleCaches(const QString &directory, std::uint64_t keep);
+
+    QString m_directory;
+    mutable std::mutex m_mutex;
+    std::shared_ptr<const SwipeTemplateSet> m_current;
+    std::thread m_builder;
+    std::atomic<bool> m_building{false};
+    std::atomic<bool> m_cancel{false};
+};
+
+} // namespace radialkb
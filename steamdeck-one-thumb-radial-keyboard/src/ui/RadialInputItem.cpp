@@ -0,0 +1,213 @@
+#include "RadialInputItem.h"
+
+#include <QHoverEvent>
+#include <QMouseEvent>
+#include <QPointingDevice>
+#include <QQuickWindow>
+
+#include "UiBridge.h"
+
+namespace radialkb {
+
+RadialInputItem::RadialInputItem(QQuickItem *parent)
+    : QQuickItem(parent) {
+    setAcceptedMouseButtons(Qt::LeftButton | Qt::RightButton);
+    setAcceptHoverEvents(true);
+}
+
+QObject *RadialInputItem::bridge() const {
+    return m_bridge.data();
+}
+
+void RadialInputItem::setBridge(QObject *bridge) {
+    UiBridge *next = qobject_cast<UiBridge *>(bridge);
+    if (next == m_bridge) {
+        return;
+    }
+    m_bridge = next;
+    emit bridgeChanged();
+}
+
+void RadialInputItem::setPad(const QString &pad) {
+    const QByteArray next = pad.toLatin1();
+    if (next == m_pad) {
+        return;
+    }
+    m_pad = next;
+    emit padChanged();
+}
+
+void RadialInputItem::setDevice(const QString &device) {
+    if (device == m_device) {
+        return;
+    }
+    m_device = device;
+    emit deviceChanged();
+}
+
+bool RadialInputItem::acceptsDevice(const QPointerEvent *event) const {
+    return m_device.isEmpty()
+        || (event->pointingDevice() && event->pointingDevice()->name().contains(m_device, Qt::CaseInsensitive));
+}
+
+void RadialInputItem::mousePressEvent(QMouseEvent *event) {
+    if (!acceptsDevice(event)) {
+        event->ignore();
+        return;
+    }
+    if (event->button() == Qt::RightButton) {
+        emit secondaryClicked();
+        event->accept();
+        return;
+    }
+    if (event->button() != Qt::LeftButton) {
+        event->ignore();
+        return;
+    }
+    m_pressed = true;
+    startTouch(event->position(), event->timestamp());
+    event->accept();
+}
+
+void RadialInputItem::mouseMoveEvent(QMouseEvent *event) {
+    if (!acceptsDevice(event)) {
+        event->ignore();
+        return;
+    }
+    if (event->buttons() & Qt::LeftButton) {
+        queueSample(event->position(), event->timestamp());
+    }
+    event->accept();
+}
+
+void RadialInputItem::mouseReleaseEvent(QMouseEvent *event) {
+    if (!acceptsDevice(event)) {
+        event->ignore();
+        return;
+    }
+    if (event->button() != Qt::LeftButton) {
+        event->accept();
+        return;
+    }
+    m_pressed = false;
+    endTouch(event->position());
+    event->accept();
+}
+
+void RadialInputItem::hoverMoveEvent(QHoverEvent *event) {
+    if (!acceptsDevice(event)) {
+        event->ignore();
+        return;
+    }
+    // Trackpad hover drives the wheel like a held touch.
+    if (!m_tracking) {
+        startTouch(event->position(), event->timestamp());
+    } else {
+        queueSample(event->position(), event->timestamp());
+    }
+    event->accept();
+}
+
+void RadialInputItem::hoverLeaveEvent(QHoverEvent *event) {
+    if (!m_pressed && m_tracking) {
+        endTouch(m_lastPos);
+    }
+    emit exited();
+    event->accept();
+}
+
+void RadialInputItem::itemChange(ItemChange change, const ItemChangeData &value) {
+    if (change == ItemSceneChange) {
+        QObject::disconnect(m_frameConnection);
+        QObject::disconnect(m_visibleConnection);
+        if (value.window) {
+            // afterAnimating runs on the GUI thread once per frame, before the scene is synced.
+            m_frameConnection = connect(value.window, &QQuickWindow::afterAnimating, this,
+                                        &RadialInputItem::flushBatch);
+            m_visibleConnection = connect(value.window, &QWindow::visibleChanged, this,
+                                          &RadialInputItem::onWindowVisibleChanged);
+            onWindowVisibleChanged(value.window->isVisible());
+        }
+    }
+    QQuickItem::itemChange(change, value);
+}
+
+void RadialInputItem::onWindowVisibleChanged(bool visible) {
+    setAcceptHoverEvents(visible);
+    if (visible) {
+        return;
+    }
+    // The engine clears its own state on ui_hide; sending touch_up here could commit a key.
+    m_pending.clear();
+    m_pressed = false;
+    if (m_tracking) {
+        m_tracking = false;
+        emit trackingChanged();
+        emit touchEnded();
+    }
+}
+
+void RadialInputItem::startTouch(QPointF pos, quint64 timestampMs) {
+    flushBatch();
+    m_lastPos = pos;
+    m_lastTimestampMs = timestampMs;
+    emit touchStarted(pos.x(), pos.y());
+    if (m_bridge) {
+        m_bridge->sendTouchDown(normalizedX(pos.x()), normalizedY(pos.y()), pad());
+    }
+    if (!m_tracking) {
+        m_tracking = true;
+        emit trackingChanged();
+    }
+}
+
+void RadialInputItem::endTouch(QPointF pos) {
+    flushBatch();
+    emit touchEnding(pos.x(), pos.y());
+    if (m_bridge) {
+        m_bridge->sendTouchUp(normalizedX(pos.x()), normalizedY(pos.y()), pad());
+    }
+    if (m_tracking) {
+        m_tracking = false;
+        emit trackingChanged();
+    }
+    emit touchEnded();
+}
+
+void RadialInputItem::queueSample(QPointF pos, quint64 timestampMs) {
+    const quint64 dtMs = timestampMs >= m_lastTimestampMs ? timestampMs - m_lastTimestampMs : 0;
+    m_pending.append(static_cast<float>(normalizedX(pos.x())));
+    m_pending.append(static_cast<float>(normalizedY(pos.y())));
+    m_pending.append(static_cast<float>(dtMs));
+    m_lastPos = pos;
+    m_lastTimestampMs = timestampMs;
+    if (m_pending.size() >= kMaxBatchPoints * 3 || !window()) {
+        flushBatch();
+        return;
+    }
+    if (m_pending.size() == 3) {
+        // Make sure a frame (and with it afterAnimating) is coming even if nothing else changed.
+        window()->update();
+    }
+}
+
+void RadialInputItem::flushBatch() {
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    if (m_bridge) {
+        m_bridge->sendTouchBatch("move", m_pending.constData(), m_pending.size() / 3, m_pad);
+    }
+    m_pending.clear();
+    emit frameSampled(m_lastPos.x(), m_lastPos.y());
+}
+
+double RadialInputItem::normalizedX(qreal x) const {
+    return width() > 0.0 ? qBound(0.0, x / width(), 1.0) : 0.5;
+}
+
+double RadialInputItem::normalizedY(qreal y) const {
+    return height() > 0.0 ? qBound(0.0, y / height(), 1.0) : 0.5;
+}
+
+} // namespace radialkb
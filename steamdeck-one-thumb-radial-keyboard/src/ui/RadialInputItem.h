@@ -0,0 +1,85 @@
+#pragma once
+
+#include <QMetaObject>
+#include <QPointF>
+#include <QPointer>
+#include <QQuickItem>
+#include <QVarLengthArray>
+
+class UiBridge;
+
+namespace radialkb {
+
+// INTENT: Captures every pointer sample in C++ and forwards moves to the engine as one
+// INTENT: touch_batch per frame with per-point timestamps; QML only hears about touch start/end
+// INTENT: and one frameSampled() per frame. Requires AA_CompressHighFrequencyEvents to be off.
+// INTENT: In dual-pad mode there is one item per trackpad, each taking only its device's events.
+class RadialInputItem : public QQuickItem {
+    Q_OBJECT
+    Q_PROPERTY(QObject *bridge READ bridge WRITE setBridge NOTIFY bridgeChanged)
+    Q_PROPERTY(bool tracking READ tracking NOTIFY trackingChanged)
+    Q_PROPERTY(QString pad READ pad WRITE setPad NOTIFY padChanged)
+    Q_PROPERTY(QString device READ device WRITE setDevice NOTIFY deviceChanged)
+public:
+    explicit RadialInputItem(QQuickItem *parent = nullptr);
+
+    QObject *bridge() const;
+    void setBridge(QObject *bridge);
+    bool tracking() const { return m_tracking; }
+    // "left" or "right": sent as the pad field of every touch message. Empty sends none.
+    QString pad() const { return QString::fromLatin1(m_pad); }
+    void setPad(const QString &pad);
+    // Only pointer events from devices whose name contains this (case-insensitive) are taken;
+    // others are ignored and go on to the items below. Empty takes every device.
+    QString device() const { return m_device; }
+    void setDevice(const QString &device);
+
+signals:
+    void bridgeChanged();
+    void trackingChanged();
+    void padChanged();
+    void deviceChanged();
+    // Sent before the corresponding touch_down; position in item coordinates.
+    void touchStarted(qreal x, qreal y);
+    // Sent before touch_up so QML can commit the current selection first.
+    void touchEnding(qreal x, qreal y);
+    void touchEnded();
+    // Once per frame after the batch was forwarded; position of the newest sample.
+    void frameSampled(qreal x, qreal y);
+    void exited();
+    void secondaryClicked();
+
+protected:
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void hoverMoveEvent(QHoverEvent *event) override;
+    void hoverLeaveEvent(QHoverEvent *event) override;
+    void itemChange(ItemChange change, const ItemChangeData &value) override;
+
+private:
+    static constexpr int kMaxBatchPoints = 64;
+
+    bool acceptsDevice(const QPointerEvent *event) const;
+    void startTouch(QPointF pos, quint64 timestampMs);
+    void endTouch(QPointF pos);
+    void queueSample(QPointF pos, quint64 timestampMs);
+    void flushBatch();
+    // Hidden windows take no hover tracking; a touch in progress is dropped without committing.
+    void onWindowVisibleChanged(bool visible);
+    double normalizedX(qreal x) const;
+    double normalizedY(qreal y) const;
+
+    QPointer<UiBridge> m_bridge;
+    QByteArray m_pad;
+    QString m_device;
+    QMetaObject::Connection m_frameConnection;
+    QMetaObject::Connection m_visibleConnection;
+    QVarLengthArray<float, kMaxBatchPoints * 3> m_pending;
+    QPointF m_lastPos;
+    quint64 m_lastTimestampMs{0};
+    bool m_tracking{false};
+    bool m_pressed{false};
+};
+
+} // namespace radialkb
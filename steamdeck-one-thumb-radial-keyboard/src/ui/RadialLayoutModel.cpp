@@ -0,0 +1,52 @@
+#include "RadialLayoutModel.h"
+
+#include <QStringList>
+
+namespace radialkb {
+
+RadialLayoutModel::RadialLayoutModel(QObject *parent)
+    : QObject(parent),
+      m_layout(kDefaultRadialTables) {
+    for (int sector = 0; sector < m_layout.sectors(); ++sector) {
+        QStringList labels;
+        for (int key = 0; key < m_layout.keyCount(sector); ++key) {
+            labels.append(QString::fromUtf8(keyLabel(m_layout.keyAction(sector, key))));
+        }
+        m_sectorKeys.append(labels);
+    }
+}
+
+QVariantMap RadialLayoutModel::hitTest(qreal x, qreal y, qreal width, qreal height,
+                                       int previousSector, int previousLetter, bool previousTracking) const {
+    const double xNorm = width > 0.0 ? qBound(0.0, x / width, 1.0) : 0.5;
+    const double yNorm = height > 0.0 ? qBound(0.0, y / height, 1.0) : 0.5;
+    const SelectionState next = resolveSelection(
+        m_layout, xNorm, yNorm, SelectionState{previousSector, previousLetter, previousTracking}, m_thresholds);
+    return QVariantMap{{QStringLiteral("sector"), next.sector},
+                       {QStringLiteral("letter"), next.key},
+                       {QStringLiteral("tracking"), next.trackingLetter}};
+}
+
+QString RadialLayoutModel::commitText(int sector, int letter) const {
+    const KeyAction action = m_layout.keyAction(sector, letter);
+    switch (action.type) {
+    case KeyAction::Char:
+        return QString(QChar::fromLatin1(action.ch));
+    case KeyAction::Space:
+        return QStringLiteral(" ");
+    case KeyAction::Backspace:
+        return QStringLiteral("\b");
+    case KeyAction::Enter:
+        return QStringLiteral("\n");
+    case KeyAction::Tab:
+        return QStringLiteral("\t");
+    case KeyAction::Escape:
+    case KeyAction::CapsLock:
+    case KeyAction::DeleteWord:
+    case KeyAction::None:
+        break;
+    }
+    return QString();
+}
+
+} // namespace radialkb
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QObject>
+#include <QVariantList>
+#include <QVariantMap>
+
+#include "SelectionRules.h"
+#include "StaticRadialLayout.h"
+
+namespace radialkb {
+
+// INTENT: QML view of the engine's compiled layout and selection rules. The UI must not carry
+// INTENT: its own copy of key data or hit-testing math; everything comes from radialkb_layout.
+class RadialLayoutModel : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(int sectorCount READ sectorCount CONSTANT)
+    Q_PROPERTY(QVariantList sectorKeys READ sectorKeys CONSTANT)
+    Q_PROPERTY(qreal deadzoneRadius READ deadzoneRadius CONSTANT)
+    Q_PROPERTY(qreal innerRadius READ innerRadius CONSTANT)
+public:
+    explicit RadialLayoutModel(QObject *parent = nullptr);
+
+    int sectorCount() const { return m_layout.sectors(); }
+    // One list of display labels per sector.
+    QVariantList sectorKeys() const { return m_sectorKeys; }
+    qreal deadzoneRadius() const { return m_thresholds.deadzoneRadius; }
+    qreal innerRadius() const { return m_thresholds.innerRadius; }
+
+    // Item-space point to {sector, letter, tracking}, given the previous selection; identical to
+    // what InputRouter computes for the same normalized sample.
+    Q_INVOKABLE QVariantMap hitTest(qreal x, qreal y, qreal width, qreal height,
+                                    int previousSector, int previousLetter, bool previousTracking) const;
+    // Text for UiBridge.sendChar: the character, or " ", "\b", "\n" for the command keys.
+    Q_INVOKABLE QString commitText(int sector, int letter) const;
+
+private:
+    DefaultRadialLayout m_layout;
+    SelectionThresholds m_thresholds;
+    QVariantList m_sectorKeys;
+};
+
+} // namespace radialkb
@@ -0,0 +1,301 @@
+#include "RadialWheelItem.h"
+
+#include <QSGFlatColorMaterial>
+#include <QSGGeometry>
+#include <QSGGeometryNode>
+#include <QSGNode>
+#include <QSGOpacityNode>
+#include <QtMath>
+
+#include <cmath>
+
+namespace radialkb {
+
+namespace {
+
+constexpr int kArcSegmentsPerSector = 24;
+constexpr int kDiscSegments = 20;
+constexpr float kKeyHighlightRadiusPx = 16.0f;
+constexpr float kStrokeWidthPx = 2.0f;
+
+// Matches the engine layout: sector 0 starts at the top and sectors run clockwise.
+double sectorStartAngle(int sector, int sectorCount) {
+    return (2.0 * M_PI * sector) / sectorCount - M_PI / 2.0;
+}
+
+QSGGeometryNode *makeNode(QSGGeometry *geometry, const QColor &color) {
+    auto *material = new QSGFlatColorMaterial;
+    material->setColor(color);
+    auto *node = new QSGGeometryNode;
+    node->setGeometry(geometry);
+    node->setMaterial(material);
+    node->setFlags(QSGNode::OwnsGeometry | QSGNode::OwnsMaterial);
+    return node;
+}
+
+// Pie slice as a triangle list: (center, arc[i], arc[i + 1]).
+QSGGeometry *sectorGeometry(QPointF center, float radius, double startAngle, double sweep) {
+    auto *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), kArcSegmentsPerSector * 3);
+    geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+    QSGGeometry::Point2D *v = geometry->vertexDataAsPoint2D();
+    for (int i = 0; i < kArcSegmentsPerSector; ++i) {
+        const double a0 = startAngle + sweep * i / kArcSegmentsPerSector;
+        const double a1 = startAngle + sweep * (i + 1) / kArcSegmentsPerSector;
+        v[i * 3].set(center.x(), center.y());
+        v[i * 3 + 1].set(center.x() + radius * std::cos(a0), center.y() + radius * std::sin(a0));
+        v[i * 3 + 2].set(center.x() + radius * std::cos(a1), center.y() + radius * std::sin(a1));
+    }
+    return geometry;
+}
+
+// Sector outlines: one radial spoke per boundary plus the rim, as a line list.
+QSGGeometry *outlineGeometry(QPointF center, float radius, int sectorCount) {
+    const int rimSegments = kArcSegmentsPerSector * sectorCount;
+    auto *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), (sectorCount + rimSegments) * 2);
+    geometry->setDrawingMode(QSGGeometry::DrawLines);
+    geometry->setLineWidth(kStrokeWidthPx);
+    QSGGeometry::Point2D *v = geometry->vertexDataAsPoint2D();
+    int n = 0;
+    for (int s = 0; s < sectorCount; ++s) {
+        const double a = sectorStartAngle(s, sectorCount);
+        v[n++].set(center.x(), center.y());
+        v[n++].set(center.x() + radius * std::cos(a), center.y() + radius * std::sin(a));
+    }
+    for (int i = 0; i < rimSegments; ++i) {
+        const double a0 = -M_PI / 2.0 + 2.0 * M_PI * i / rimSegments;
+        const double a1 = -M_PI / 2.0 + 2.0 * M_PI * (i + 1) / rimSegments;
+        v[n++].set(center.x() + radius * std::cos(a0), center.y() + radius * std::sin(a0));
+        v[n++].set(center.x() + radius * std::cos(a1), center.y() + radius * std::sin(a1));
+    }
+    return geometry;
+}
+
+QSGGeometry *discGeometry(QPointF center, float radius) {
+    auto *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), kDiscSegments + 2);
+    geometry->setDrawingMode(QSGGeometry::DrawTriangleFan);
+    QSGGeometry::Point2D *v = geometry->vertexDataAsPoint2D();
+    v[0].set(center.x(), center.y());
+    for (int i = 0; i <= kDiscSegments; ++i) {
+        const double a = 2.0 * M_PI * i / kDiscSegments;
+        v[i + 1].set(center.x() + radius * std::cos(a), center.y() + radius * std::sin(a));
+    }
+    return geometry;
+}
+
+} // namespace
+
+RadialWheelItem::RadialWheelItem(QQuickItem *parent)
+    : QQuickItem(parent) {
+    setFlag(ItemHasContents, true);
+}
+
+void RadialWheelItem::setSectorCount(int count) {
+    count = qMax(1, count);
+    if (count == m_sectorCount) {
+        return;
+    }
+    m_sectorCount = count;
+    emit sectorCountChanged();
+    invalidateGeometry();
+}
+
+QVariantList RadialWheelItem::keyCounts() const {
+    QVariantList counts;
+    for (int count : m_keyCounts) {
+        counts.append(count);
+    }
+    return counts;
+}
+
+void RadialWheelItem::setKeyCounts(const QVariantList &counts) {
+    QVector<int> next;
+    next.reserve(counts.size());
+    for (const QVariant &count : counts) {
+        next.push_back(qMax(0, count.toInt()));
+    }
+    if (next == m_keyCounts) {
+        return;
+    }
+    m_keyCounts = next;
+    emit keyCountsChanged();
+    invalidateGeometry();
+}
+
+void RadialWheelItem::setActiveSector(int sector) {
+    if (sector == m_activeSector) {
+        return;
+    }
+    m_activeSector = sector;
+    emit activeSectorChanged();
+    invalidateHighlight();
+}
+
+void RadialWheelItem::setActiveLetter(int letter) {
+    if (letter == m_activeLetter) {
+        return;
+    }
+    m_activeLetter = letter;
+    emit activeLetterChanged();
+    invalidateHighlight();
+}
+
+void RadialWheelItem::setRadiusRatio(qreal ratio) {
+    if (qFuzzyCompare(ratio, m_radiusRatio)) {
+        return;
+    }
+    m_radiusRatio = ratio;
+    emit radiusRatioChanged();
+    invalidateGeometry();
+}
+
+void RadialWheelItem::setLabelRadiusRatio(qreal ratio) {
+    if (qFuzzyCompare(ratio, m_labelRadiusRatio)) {
+        return;
+    }
+    m_labelRadiusRatio = ratio;
+    emit labelRadiusRatioChanged();
+    invalidateGeometry();
+}
+
+void RadialWheelItem::setBaseColor(const QColor &color) {
+    if (color == m_baseColor) {
+        return;
+    }
+    m_baseColor = color;
+    emit colorsChanged();
+    invalidateHighlight();
+}
+
+void RadialWheelItem::setHighlightColor(const QColor &color) {
+    if (color == m_highlightColor) {
+        return;
+    }
+    m_highlightColor = color;
+    emit colorsChanged();
+    invalidateHighlight();
+}
+
+// Stroke and key-disc colors are baked into their nodes, so changing them rebuilds the tree.
+void RadialWheelItem::setStrokeColor(const QColor &color) {
+    if (color == m_strokeColor) {
+        return;
+    }
+    m_strokeColor = color;
+    emit colorsChanged();
+    invalidateGeometry();
+}
+
+void RadialWheelItem::setKeyHighlightColor(const QColor &color) {
+    if (color == m_keyHighlightColor) {
+        return;
+    }
+    m_keyHighlightColor = color;
+    emit colorsChanged();
+    invalidateGeometry();
+}
+
+QPointF RadialWheelItem::labelPosition(int sector, int key) const {
+    const int keys = keyCountFor(sector);
+    if (sector < 0 || sector >= m_sectorCount || key < 0 || key >= keys) {
+        return QPointF(width() / 2.0, height() / 2.0);
+    }
+    const double sweep = 2.0 * M_PI / m_sectorCount;
+    const double angle = sectorStartAngle(sector, m_sectorCount) + (sweep / keys) * (key + 0.5);
+    const double radius = qMin(width(), height()) * m_radiusRatio * m_labelRadiusRatio;
+    return QPointF(width() / 2.0 + std::cos(angle) * radius, height() / 2.0 + std::sin(angle) * radius);
+}
+
+void RadialWheelItem::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) {
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        invalidateGeometry();
+    }
+}
+
+void RadialWheelItem::invalidateGeometry() {
+    m_geometryDirty = true;
+    update();
+}
+
+void RadialWheelItem::invalidateHighlight() {
+    m_highlightDirty = true;
+    update();
+}
+
+int RadialWheelItem::keyCountFor(int sector) const {
+    return (sector >= 0 && sector < m_keyCounts.size()) ? m_keyCounts.at(sector) : 0;
+}
+
+QSGNode *RadialWheelItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) {
+    Q_UNUSED(data);
+    QSGNode *root = oldNode;
+    if (!root || m_geometryDirty) {
+        delete root;
+        root = buildTree();
+        m_geometryDirty = false;
+        m_highlightDirty = true;
+    }
+    if (m_highlightDirty) {
+        applyHighlight();
+        m_highlightDirty = false;
+    }
+    return root;
+}
+
+QSGNode *RadialWheelItem::buildTree() {
+    auto *root = new QSGNode;
+    m_sectorNodes.clear();
+    m_keyHighlights.clear();
+
+    const QPointF center(width() / 2.0, height() / 2.0);
+    const float radius = static_cast<float>(qMin(width(), height()) * m_radiusRatio);
+    if (radius <= 0.0f) {
+        return root;
+    }
+    const double sweep = 2.0 * M_PI / m_sectorCount;
+
+    for (int s = 0; s < m_sectorCount; ++s) {
+        QSGGeometryNode *node =
+            makeNode(sectorGeometry(center, radius, sectorStartAngle(s, m_sectorCount), sweep), m_baseColor);
+        root->appendChildNode(node);
+        m_sectorNodes.push_back(node);
+    }
+    root->appendChildNode(makeNode(outlineGeometry(center, radius, m_sectorCount), m_strokeColor));
+
+    // Key discs sit under the QML labels; hidden ones are blocked subtrees and cost nothing to render.
+    m_keyHighlights.resize(m_sectorCount);
+    for (int s = 0; s < m_sectorCount; ++s) {
+        for (int k = 0; k < keyCountFor(s); ++k) {
+            auto *opacity = new QSGOpacityNode;
+            opacity->setOpacity(0.0);
+            opacity->appendChildNode(makeNode(discGeometry(labelPosition(s, k), kKeyHighlightRadiusPx),
+                                              m_keyHighlightColor));
+            root->appendChildNode(opacity);
+            m_keyHighlights[s].push_back(opacity);
+        }
+    }
+    return root;
+}
+
+void RadialWheelItem::applyHighlight() {
+    for (int s = 0; s < m_sectorNodes.size(); ++s) {
+        QSGGeometryNode *node = m_sectorNodes.at(s);
+        auto *material = static_cast<QSGFlatColorMaterial *>(node->material());
+        const QColor wanted = (s == m_activeSector) ? m_highlightColor : m_baseColor;
+        if (material->color() != wanted) {
+            material->setColor(wanted);
+            node->markDirty(QSGNode::DirtyMaterial);
+        }
+    }
+    for (int s = 0; s < m_keyHighlights.size(); ++s) {
+        for (int k = 0; k < m_keyHighlights.at(s).size(); ++k) {
+            QSGOpacityNode *opacity = m_keyHighlights.at(s).at(k);
+            const qreal wanted = (s == m_activeSector && k == m_activeLetter) ? 1.0 : 0.0;
+            if (!qFuzzyCompare(opacity->opacity() + 1.0, wanted + 1.0)) {
+                opacity->setOpacity(wanted);
+            }
+        }
+    }
+}
+
+} // namespace radialkb
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <QColor>
+#include <QQuickItem>
+#include <QVariantList>
+#include <QVector>
+
+class QSGGeometryNode;
+class QSGOpacityNode;
+
+namespace radialkb {
+
+// INTENT: Scene-graph renderer for the wheel. Sector and key-highlight geometry is built once
+// INTENT: per size/layout change; a selection change only swaps flat-color materials, so fast
+// INTENT: sector sweeps never re-rasterize the wheel on the CPU. Letters stay QML Text items.
+class RadialWheelItem : public QQuickItem {
+    Q_OBJECT
+    Q_PROPERTY(int sectorCount READ sectorCount WRITE setSectorCount NOTIFY sectorCountChanged)
+    Q_PROPERTY(QVariantList keyCounts READ keyCounts WRITE setKeyCounts NOTIFY keyCountsChanged)
+    Q_PROPERTY(int activeSector READ activeSector WRITE setActiveSector NOTIFY activeSectorChanged)
+    Q_PROPERTY(int activeLetter READ activeLetter WRITE setActiveLetter NOTIFY activeLetterChanged)
+    Q_PROPERTY(qreal radiusRatio READ radiusRatio WRITE setRadiusRatio NOTIFY radiusRatioChanged)
+    Q_PROPERTY(qreal labelRadiusRatio READ labelRadiusRatio WRITE setLabelRadiusRatio NOTIFY labelRadiusRatioChanged)
+    Q_PROPERTY(QColor baseColor READ baseColor WRITE setBaseColor NOTIFY colorsChanged)
+    Q_PROPERTY(QColor highlightColor READ highlightColor WRITE setHighlightColor NOTIFY colorsChanged)
+    Q_PROPERTY(QColor strokeColor READ strokeColor WRITE setStrokeColor NOTIFY colorsChanged)
+    Q_PROPERTY(QColor keyHighlightColor READ keyHighlightColor WRITE setKeyHighlightColor NOTIFY colorsChanged)
+public:
+    explicit RadialWheelItem(QQuickItem *parent = nullptr);
+
+    int sectorCount() const { return m_sectorCount; }
+    void setSectorCount(int count);
+    QVariantList keyCounts() const;
+    void setKeyCounts(const QVariantList &counts);
+    int activeSector() const { return m_activeSector; }
+    void setActiveSector(int sector);
+    int activeLetter() const { return m_activeLetter; }
+    void setActiveLetter(int letter);
+    qreal radiusRatio() const { return m_radiusRatio; }
+    void setRadiusRatio(qreal ratio);
+    qreal labelRadiusRatio() const { return m_labelRadiusRatio; }
+    void setLabelRadiusRatio(qreal ratio);
+    QColor baseColor() const { return m_baseColor; }
+    void setBaseColor(const QColor &color);
+    QColor highlightColor() const { return m_highlightColor; }
+    void setHighlightColor(const QColor &color);
+    QColor strokeColor() const { return m_strokeColor; }
+    void setStrokeColor(const QColor &color);
+    QColor keyHighlightColor() const { return m_keyHighlightColor; }
+    void setKeyHighlightColor(const QColor &color);
+
+    // Item-local position of a key label; matches the highlight disc drawn for that key.
+    Q_INVOKABLE QPointF labelPosition(int sector, int key) const;
+
+signals:
+    void sectorCountChanged();
+    void keyCountsChanged();
+    void activeSectorChanged();
+    void activeLetterChanged();
+    void radiusRatioChanged();
+    void labelRadiusRatioChanged();
+    void colorsChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+
+private:
+    void invalidateGeometry();
+    void invalidateHighlight();
+    QSGNode *buildTree();
+    void applyHighlight();
+    int keyCountFor(int sector) const;
+
+    int m_sectorCount{8};
+    QVector<int> m_keyCounts;
+    int m_activeSector{-1};
+    int m_activeLetter{-1};
+    qreal m_radiusRatio{0.45};
+    qreal m_labelRadiusRatio{0.68};
+    QColor m_baseColor{QStringLiteral("#1e1f22")};
+    QColor m_highlightColor{QStringLiteral("#4aa3ff")};
+    QColor m_strokeColor{QStringLiteral("#2a2c30")};
+    QColor m_keyHighlightColor{255, 255, 255, 46};
+    bool m_geometryDirty{true};
+    bool m_highlightDirty{true};
+
+    // Owned by the scene graph; only touched from updatePaintNode().
+    QVector<QSGGeometryNode *> m_sectorNodes;
+    QVector<QVector<QSGOpacityNode *>> m_keyHighlights;
+};
+
+} // namespace radialkb
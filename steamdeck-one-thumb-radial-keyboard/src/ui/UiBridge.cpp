@@ -0,0 +1,148 @@
+#include "UiBridge.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+
+#include <unistd.h>
+
+UiBridge::UiBridge(QObject *parent)
+    : QObject(parent) {
+    connect(&m_socket, &QLocalSocket::connected, this, [this]() {
+        // The engine may have restarted in its default single-pad mode.
+        if (m_dualPad) {
+            sendPadMode();
+        }
+    });
+    connect(&m_socket, &QLocalSocket::connected, this, &UiBridge::connectedChanged);
+    connect(&m_socket, &QLocalSocket::disconnected, this, &UiBridge::connectedChanged);
+    connect(&m_socket, &QLocalSocket::readyRead, this, &UiBridge::readReplies);
+}
+
+void UiBridge::connectEngine() {
+    if (m_socket.state() == QLocalSocket::ConnectedState) {
+        return;
+    }
+    m_socket.connectToServer(socketPath());
+}
+
+void UiBridge::readReplies() {
+    while (m_socket.canReadLine()) {
+        const QByteArray line = m_socket.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        QJsonParseError error{};
+        const QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+        if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+            continue;
+        }
+        const QJsonObject obj = doc.object();
+        const bool clearSelection = obj.value("clearSelection").toBool(false);
+        if (obj.contains("sector") || clearSelection) {
+            int sector = obj.value("sector").toInt(-1);
+            int letter = obj.value("letter").toInt(-1);
+            const QString stage = obj.value("stage").toString();
+            if (clearSelection) {
+                sector = -1;
+                letter = -1;
+            }
+            emit selectionReceived(sector, letter, stage, clearSelection);
+        }
+    }
+}
+
+void UiBridge::setDualPad(bool dual) {
+    if (dual == m_dualPad) {
+        return;
+    }
+    m_dualPad = dual;
+    sendPadMode();
+}
+
+void UiBridge::sendPadMode() {
+    QJsonObject obj;
+    obj.insert("type", "pad_mode");
+    obj.insert("mode", m_dualPad ? "dual" : "single");
+    sendObject(obj);
+}
+
+void UiBridge::sendTouchBatch(const char *phase, const float *points, int pointCount, const QByteArray &pad) {
+    if (m_socket.state() != QLocalSocket::ConnectedState || pointCount <= 0) {
+        return;
+    }
+    // Formatted by hand: this runs once per frame while the thumb moves, and the buffer's
+    // capacity is reused across frames.
+    m_batchBuffer.clear();
+    m_batchBuffer.append("{\"type\":\"touch_batch\",\"phase\":\"");
+    m_batchBuffer.append(phase);
+    if (!pad.isEmpty()) {
+        m_batchBuffer.append("\",\"pad\":\"");
+        m_batchBuffer.append(pad);
+    }
+    m_batchBuffer.append("\",\"points\":[");
+    for (int i = 0; i < pointCount; ++i) {
+        if (i > 0) {
+            m_batchBuffer.append(',');
+        }
+        m_batchBuffer.append(QByteArray::number(points[i * 3], 'f', 4));
+        m_batchBuffer.append(',');
+        m_batchBuffer.append(QByteArray::number(points[i * 3 + 1], 'f', 4));
+        m_batchBuffer.append(',');
+        m_batchBuffer.append(QByteArray::number(points[i * 3 + 2], 'f', 2));
+    }
+    m_batchBuffer.append("]}\n");
+    m_socket.write(m_batchBuffer);
+}
+
+void UiBridge::sendChar(const QString &ch) {
+    const QString trimmed = ch.left(1).toLower();
+    if (trimmed.isEmpty()) {
+        return;
+    }
+    QJsonObject obj;
+    obj.insert("type", "commit_char");
+    obj.insert("char", trimmed);
+    sendObject(obj);
+}
+
+void UiBridge::sendAction(const QString &action) {
+    QJsonObject obj;
+    obj.insert("type", "action");
+    obj.insert("action", action);
+    sendObject(obj);
+}
+
+void UiBridge::sendType(const QString &type) {
+    QJsonObject obj;
+    obj.insert("type", type);
+    sendObject(obj);
+}
+
+void UiBridge::sendJson(const QString &type, double x, double y, const QString &pad) {
+    QJsonObject obj;
+    obj.insert("type", type);
+    if (!pad.isEmpty()) {
+        obj.insert("pad", pad);
+    }
+    obj.insert("x", x);
+    obj.insert("y", y);
+    sendObject(obj);
+}
+
+void UiBridge::sendObject(const QJsonObject &obj) {
+    if (m_socket.state() != QLocalSocket::ConnectedState) {
+        return;
+    }
+    const QJsonDocument doc(obj);
+    m_socket.write(doc.toJson(QJsonDocument::Compact));
+    m_socket.write("\n");
+}
+
+QString UiBridge::socketPath() {
+    const QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (!runtimeDir.isEmpty()) {
+        return runtimeDir + "/radialkb.sock";
+    }
+    return QString("/tmp/radialkb-%1.sock").arg(getuid());
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QLocalSocket>
+#include <QObject>
+#include <QString>
+
+class QJsonObject;
+
+// INTENT: UiBridge is the UI's only channel to the engine; it forwards raw input and renders
+// INTENT: engine replies back into QML signals. It must never interpret input itself.
+class UiBridge : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(bool connected READ connected NOTIFY connectedChanged)
+public:
+    explicit UiBridge(QObject *parent = nullptr);
+
+    Q_INVOKABLE void connectEngine();
+
+    // pad ("left" or "right") names the trackpad in dual-pad mode; empty sends no pad field.
+    Q_INVOKABLE void sendTouchDown(double x, double y, const QString &pad = QString()) { sendJson("touch_down", x, y, pad); }
+    Q_INVOKABLE void sendTouchMove(double x, double y, const QString &pad = QString()) { sendJson("touch_move", x, y, pad); }
+    Q_INVOKABLE void sendTouchUp(double x, double y, const QString &pad = QString()) { sendJson("touch_up", x, y, pad); }
+    // points holds (x, y, dtMs) triples in normalized pad coordinates; one message per call.
+    void sendTouchBatch(const char *phase, const float *points, int pointCount, const QByteArray &pad = QByteArray());
+    // Switches the engine between single- and dual-pad input; resent on every reconnect.
+    Q_INVOKABLE void setDualPad(bool dual);
+    Q_INVOKABLE void sendChar(const QString &ch);
+    void sendUiShow() { sendType("ui_show"); }
+    void sendUiHide() { sendType("ui_hide"); }
+    Q_INVOKABLE void sendAction(const QString &action);
+
+    Q_INVOKABLE bool isConnected() const { return connected(); }
+    bool connected() const { return m_socket.state() == QLocalSocket::ConnectedState; }
+
+signals:
+    void connectedChanged();
+    void selectionReceived(int sector, int letter, const QString &stage, bool clearSelection);
+
+private:
+    void readReplies();
+    void sendType(const QString &type);
+    void sendJson(const QString &type, double x, double y, const QString &pad);
+    void sendPadMode();
+    void sendObject(const QJsonObject &obj);
+    static QString socketPath();
+
+    QLocalSocket m_socket;
+    QByteArray m_batchBuffer;
+    bool m_dualPad{false};
+};
@@ -2,130 +2,20 @@
 #include <QCoreApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
-#include <QLocalSocket>
-#include <QJsonDocument>
-#include <QJsonObject>
+#include <QtQml>
 #include <QDBusConnection>
 #include <QDBusError>
-#include <QStandardPaths>
 #include <QWindow>
 #include <QPointer>
-#include <unistd.h>
+
+#include "RadialInputItem.h"
+#include "RadialLayoutModel.h"
+#include "RadialWheelItem.h"
+#include "UiBridge.h"
 
 // INTENT: UI overlay must NOT steal focus from the target application.
 // INTENT: Keep the overlay responsive and non-invasive; diagnostics should be high-signal.
 
-class UiBridge : public QObject {
-    Q_OBJECT
-    Q_PROPERTY(bool connected READ connected NOTIFY connectedChanged)
-public:
-    explicit UiBridge(QObject *parent = nullptr)
-        : QObject(parent) {
-        connect(&m_socket, &QLocalSocket::connected, this, &UiBridge::connectedChanged);
-        connect(&m_socket, &QLocalSocket::disconnected, this, &UiBridge::connectedChanged);
-        connect(&m_socket, &QLocalSocket::readyRead, this, [this]() {
-            while (m_socket.canReadLine()) {
-                const QByteArray line = m_socket.readLine().trimmed();
-                if (line.isEmpty()) {
-                    continue;
-                }
-                QJsonParseError error{};
-                const QJsonDocument doc = QJsonDocument::fromJson(line, &error);
-                if (error.error != QJsonParseError::NoError || !doc.isObject()) {
-                    continue;
-                }
-                const QJsonObject obj = doc.object();
-                const bool clearSelection = obj.value("clearSelection").toBool(false);
-                if (obj.contains("sector") || clearSelection) {
-                    int sector = obj.value("sector").toInt(-1);
-                    int letter = obj.value("letter").toInt(-1);
-                    const QString stage = obj.value("stage").toString();
-                    if (clearSelection) {
-                        sector = -1;
-                        letter = -1;
-                    }
-                    emit selectionReceived(sector, letter, stage, clearSelection);
-                }
-            }
-        });
-    }
-
-    Q_INVOKABLE void connectEngine() {
-        if (m_socket.state() == QLocalSocket::ConnectedState) {
-            return;
-        }
-        m_socket.connectToServer(socketPath());
-    }
-
-    Q_INVOKABLE void sendTouchDown(double x, double y) { sendJson("touch_down", x, y); }
-    Q_INVOKABLE void sendTouchMove(double x, double y) { sendJson("touch_move", x, y); }
-    Q_INVOKABLE void sendTouchUp(double x, double y) { sendJson("touch_up", x, y); }
-    Q_INVOKABLE void sendChar(const QString &ch) {
-        const QString trimmed = ch.left(1).toLower();
-        if (trimmed.isEmpty()) {
-            return;
-        }
-        QJsonObject obj;
-        obj.insert("type", "commit_char");
-        obj.insert("char", trimmed);
-        sendObject(obj);
-    }
-    void sendUiShow() { sendType("ui_show"); }
-    void sendUiHide() { sendType("ui_hide"); }
-    Q_INVOKABLE void sendAction(const QString &action) {
-        QJsonObject obj;
-        obj.insert("type", "action");
-        obj.insert("action", action);
-        sendObject(obj);
-    }
-
-    Q_INVOKABLE bool isConnected() const {
-        return m_socket.state() == QLocalSocket::ConnectedState;
-    }
-
-    bool connected() const {
-        return m_socket.state() == QLocalSocket::ConnectedState;
-    }
-
-signals:
-    void connectedChanged();
-    void selectionReceived(int sector, int letter, const QString &stage, bool clearSelection);
-
-private:
-    void sendType(const QString &type) {
-        QJsonObject obj;
-        obj.insert("type", type);
-        sendObject(obj);
-    }
-
-    void sendJson(const QString &type, double x, double y) {
-        QJsonObject obj;
-        obj.insert("type", type);
-        obj.insert("x", x);
-        obj.insert("y", y);
-        sendObject(obj);
-    }
-
-    void sendObject(const QJsonObject &obj) {
-        if (m_socket.state() != QLocalSocket::ConnectedState) {
-            return;
-        }
-        const QJsonDocument doc(obj);
-        m_socket.write(doc.toJson(QJsonDocument::Compact));
-        m_socket.write("\n");
-    }
-
-    static QString socketPath() {
-        const QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
-        if (!runtimeDir.isEmpty()) {
-            return runtimeDir + "/radialkb.sock";
-        }
-        return QString("/tmp/radialkb-%1.sock").arg(getuid());
-    }
-
-    QLocalSocket m_socket;
-};
-
 class OverlayController : public QObject {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.radialkb.Overlay")
@@ -149,9 +39,13 @@ private:
         if (!m_window) {
             return;
         }
+        // Wake the engine before the first frame is drawn; park it only once nothing is on screen.
+        if (visible && m_bridge) {
+            m_bridge->sendUiShow();
+        }
         m_window->setVisible(visible);
-        if (m_bridge) {
-            visible ? m_bridge->sendUiShow() : m_bridge->sendUiHide();
+        if (!visible && m_bridge) {
+            m_bridge->sendUiHide();
         }
     }
 
@@ -160,15 +54,32 @@ private:
 };
 
 int main(int argc, char *argv[]) {
+    // Deliver every pointer sample; RadialInputItem batches them per frame itself.
+    QCoreApplication::setAttribute(Qt::AA_CompressHighFrequencyEvents, false);
     QGuiApplication app(argc, argv);
 
     QCoreApplication::setOrganizationName("radialkb");
     QCoreApplication::setOrganizationDomain("radialkb.local");
     QCoreApplication::setApplicationName("radialkb-ui");
+    qmlRegisterType<radialkb::RadialWheelItem>("RadialKb", 1, 0, "RadialWheel");
+    qmlRegisterType<radialkb::RadialInputItem>("RadialKb", 1, 0, "RadialInput");
+    qmlRegisterType<radialkb::RadialLayoutModel>("RadialKb", 1, 0, "RadialLayout");
     QQmlApplicationEngine engine;
     UiBridge bridge;
     engine.rootContext()->setContextProperty("uiBridge", &bridge);
     engine.rootContext()->setContextProperty("qmlDir", QStringLiteral(RADIALKB_QML_DIR));
+    // Dual-pad mode needs each trackpad as its own input device, named by a part of its name.
+    const QString leftPadDevice = qEnvironmentVariable("RADIALKB_LEFT_PAD_DEVICE");
+    const QString rightPadDevice = qEnvironmentVariable("RADIALKB_RIGHT_PAD_DEVICE");
+    bool dualPad = qgetenv("RADIALKB_DUAL_PAD") == "1";
+    if (dualPad && (leftPadDevice.isEmpty() || rightPadDevice.isEmpty())) {
+        qWarning() << "RADIALKB_DUAL_PAD needs RADIALKB_LEFT_PAD_DEVICE and RADIALKB_RIGHT_PAD_DEVICE;"
+                   << "staying in single-pad mode";
+        dualPad = false;
+    }
+    engine.rootContext()->setContextProperty("dualPadEnabled", dualPad);
+    engine.rootContext()->setContextProperty("leftPadDevice", leftPadDevice);
+    engine.rootContext()->setContextProperty("rightPadDevice", rightPadDevice);
 
     const QUrl url = QUrl::fromLocalFile(QStringLiteral(RADIALKB_QML_DIR) + "/MainOverlay.qml");
     QObject::connect(&engine, &QQmlApplicationEngine::objectCreated,
@@ -3,7 +3,9 @@ import QtQuick 2.15
 Rectangle {
     id: root
     property bool connected: false
-    width: 160
+    // Share of predicted highlights the engine corrected; negative hides it.
+    property real predictionMismatch: -1
+    width: predictionMismatch >= 0 ? 220 : 160
     height: 32
     color: "#121315"
     radius: 6
@@ -11,7 +13,8 @@ Rectangle {
 
     Text {
         anchors.centerIn: parent
-        text: root.connected ? "Engine: connected" : "Engine: disconnected"
+        text: (root.connected ? "Engine: connected" : "Engine: disconnected")
+              + (root.predictionMismatch >= 0 ? " · pred miss " + Math.round(root.predictionMismatch * 100) + "%" : "")
         color: root.connected ? "#8ce99a" : "#ffa94d"
         font.pixelSize: 12
     }
@@ -56,6 +56,8 @@ Window {
         anchors.left: parent.left
         anchors.top: parent.top
         connected: uiBridge.connected
+        predictionMismatch: (keyboard.predictor.confirmed + keyboard.predictor.corrected) > 0
+                            ? keyboard.predictor.mismatchRate : -1
     }
 
     // ─────────────────────────────────────────────────────────────
@@ -136,7 +138,8 @@ Window {
 
         MouseArea {
             anchors.fill: parent
-            hoverEnabled: true
+            // No hover tracking while hidden.
+            hoverEnabled: overlay.visible
             onEntered: opacityButton.opacity = 0.55
             onExited: opacityButton.opacity = 0.35
             onClicked: {
@@ -1,11 +1,12 @@
 import QtQuick 2.15
+import RadialKb 1.0
 
 // INTENT: QML renders state but should not become the authority for input interpretation.
 // INTENT: Keep visuals lightweight; avoid adding focus-stealing Items.
 
 Item {
     id: root
-    property int sectorCount: 8
+    property int sectorCount: layout.sectorCount
     property int selectedSector: -1
     property int selectedLetter: -1
     property int engineSelectedSector: -1
@@ -14,242 +15,181 @@ Item {
     property color highlightColor: "#4aa3ff"
     property color letterColor: "#cfd2d8"
     property color letterHighlight: "#f8f9fa"
-    property int activeSector: (uiBridge.connected && engineSelectedSector >= 0) ? engineSelectedSector : selectedSector
-    property int activeLetter: (uiBridge.connected && engineSelectedLetter >= 0) ? engineSelectedLetter : selectedLetter
-    property real deadzoneRadius: 0.12
-    property real innerRadius: 0.28
-    property real innerHysteresis: 0.03
+    // Predictive highlight: while a touch message is in flight, show the selection the engine
+    // is expected to report for the extrapolated thumb position; the next reply confirms or corrects it.
+    property bool predictionEnabled: true
+    // Left pad picks the sector, right pad the key (one RadialInput per trackpad). The predictor
+    // models a single thumb, so it is off in this mode.
+    readonly property bool dualPad: dualPadEnabled
+    property bool predictionFresh: false
+    property int predictedSector: -1
+    property int predictedLetter: -1
+    property bool predictedTrackingLetter: false
+    readonly property bool showPrediction: uiBridge.connected && predictionEnabled && !dualPad && predictionFresh
+    property int activeSector: showPrediction ? predictedSector
+        : ((uiBridge.connected && engineSelectedSector >= 0) ? engineSelectedSector : selectedSector)
+    property int activeLetter: showPrediction ? predictedLetter
+        : ((uiBridge.connected && engineSelectedLetter >= 0) ? engineSelectedLetter : selectedLetter)
+    // Commits use the engine's selection (the local one while disconnected), never the prediction.
+    readonly property int commitSector: uiBridge.connected ? engineSelectedSector : selectedSector
+    readonly property int commitLetter: uiBridge.connected ? engineSelectedLetter : selectedLetter
+    property alias predictor: predictor
     property bool localTrackingLetter: false
-    property bool hoverTracking: false
-    property real lastHoverX: width / 2
-    property real lastHoverY: height / 2
-    property var sectorKeys: [
-        ["E", "T", "A", "O"],
-        ["I", "N", "S", "H"],
-        ["R", "D", "L", "U"],
-        ["C", "M", "F", "W"],
-        ["G", "P", "B", "Y"],
-        ["V", "K", "J", "X"],
-        ["Q", "Z", ".", ",", "?"],
-        ["␠", "⌫", "↵"]
-    ]
+    // Key labels come from the engine's compiled layout (radialkb_layout).
+    readonly property var sectorKeys: layout.sectorKeys
+    readonly property var labelModel: {
+        var labels = []
+        for (var s = 0; s < root.sectorKeys.length; s++) {
+            for (var k = 0; k < root.sectorKeys[s].length; k++) {
+                labels.push({ sector: s, key: k, label: root.sectorKeys[s][k] })
+            }
+        }
+        return labels
+    }
 
     signal selectionChanged(int sector, int letter)
 
-    Canvas {
-        id: canvas
-        anchors.fill: parent
-        onPaint: {
-            var ctx = getContext("2d")
-            ctx.clearRect(0, 0, width, height)
-            var centerX = width / 2
-            var centerY = height / 2
-            var radius = Math.min(width, height) * 0.45
-            var sectorSize = 2 * Math.PI / root.sectorCount
+    RadialLayout {
+        id: layout
+    }
 
-            for (var i = 0; i < root.sectorCount; i++) {
-                var startAngle = (i * sectorSize) - Math.PI / 2
-                var endAngle = startAngle + sectorSize
-                ctx.beginPath()
-                ctx.moveTo(centerX, centerY)
-                ctx.arc(centerX, centerY, radius, startAngle, endAngle)
-                ctx.closePath()
-                ctx.fillStyle = (i === root.activeSector) ? root.highlightColor : root.baseColor
-                ctx.fill()
-                ctx.strokeStyle = "#2a2c30"
-                ctx.lineWidth = 2
-                ctx.stroke()
-            }
+    SelectionPredictor {
+        id: predictor
+    }
+
+    RadialWheel {
+        id: wheel
+        anchors.fill: parent
+        sectorCount: root.sectorCount
+        keyCounts: root.sectorKeys.map(function(keys) { return keys.length })
+        activeSector: root.activeSector
+        activeLetter: root.activeLetter
+        baseColor: root.baseColor
+        highlightColor: root.highlightColor
+    }
 
-            ctx.textAlign = "center"
-            ctx.textBaseline = "middle"
-            ctx.font = "16px sans-serif"
-            for (var sectorIndex = 0; sectorIndex < root.sectorCount; sectorIndex++) {
-                var keys = root.sectorKeys[sectorIndex] || []
-                var start = (sectorIndex * sectorSize) - Math.PI / 2
-                var perKey = sectorSize / Math.max(keys.length, 1)
-                for (var keyIndex = 0; keyIndex < keys.length; keyIndex++) {
-                    var keyAngle = start + perKey * (keyIndex + 0.5)
-                    var textRadius = radius * 0.68
-                    var textX = centerX + Math.cos(keyAngle) * textRadius
-                    var textY = centerY + Math.sin(keyAngle) * textRadius
-                    var isActive = (sectorIndex === root.activeSector) && (keyIndex === root.activeLetter)
-                    if (isActive) {
-                        ctx.beginPath()
-                        ctx.fillStyle = "rgba(255,255,255,0.18)"
-                        ctx.arc(textX, textY, 16, 0, 2 * Math.PI)
-                        ctx.fill()
-                    }
-                    ctx.fillStyle = isActive ? root.letterHighlight : root.letterColor
-                    ctx.fillText(keys[keyIndex], textX, textY)
-                }
+    // Static labels; a selection change only touches the color of the two affected items.
+    Repeater {
+        model: root.labelModel
+        delegate: Text {
+            required property var modelData
+            readonly property bool isActive: modelData.sector === root.activeSector
+                                             && modelData.key === root.activeLetter
+            readonly property point anchorPoint: {
+                wheel.width
+                wheel.height
+                wheel.keyCounts
+                return wheel.labelPosition(modelData.sector, modelData.key)
             }
+            x: anchorPoint.x - width / 2
+            y: anchorPoint.y - height / 2
+            text: modelData.label
+            color: isActive ? root.letterHighlight : root.letterColor
+            font.pixelSize: 16
         }
     }
 
-    MouseArea {
+    // Pointer samples are captured and batched per frame in C++; JS runs once per frame.
+    onDualPadChanged: uiBridge.setDualPad(root.dualPad)
+    Component.onCompleted: uiBridge.setDualPad(root.dualPad)
+
+    RadialInput {
+        id: input
         anchors.fill: parent
-        hoverEnabled: true
-        onExited: {
-            // Some Qt versions do not provide mouse.buttons on onExited; use MouseArea state.
-            if (pressed) {
-                return
-            }
-            if (root.hoverTracking) {
+        bridge: uiBridge
+        pad: root.dualPad ? "right" : ""
+        device: root.dualPad ? rightPadDevice : ""
+        onTouchStarted: (x, y) => {
+            root.updateSelection(x, y)
+            root.predictSelection(x, y, true)
+        }
+        onFrameSampled: (x, y) => {
+            root.updateSelection(x, y)
+            root.predictSelection(x, y, false)
+        }
+        // In dual-pad mode the engine commits on the right pad's touch_up itself.
+        onTouchEnding: (x, y) => {
+            if (!root.dualPad) {
                 root.commitSelection()
-                uiBridge.sendTouchUp(root.normalizedX(root.lastHoverX), root.normalizedY(root.lastHoverY))
-                root.hoverTracking = false
-            }
-            root.updateSelection(width / 2, height / 2)
-        }
-        onPressed: (mouse) => {
-            if (mouse.button !== Qt.LeftButton) {
-                return
-            }
-            root.updateSelection(mouse.x, mouse.y)
-            uiBridge.sendTouchDown(root.normalizedX(mouse.x), root.normalizedY(mouse.y))
-        }
-        onPositionChanged: (mouse) => {
-            if (mouse.buttons & Qt.LeftButton) {
-                root.lastHoverX = mouse.x
-                root.lastHoverY = mouse.y
-                root.updateSelection(mouse.x, mouse.y)
-                uiBridge.sendTouchMove(root.normalizedX(mouse.x), root.normalizedY(mouse.y))
-                return
-            }
-            if (!root.hoverTracking) {
-                root.hoverTracking = true
-                uiBridge.sendTouchDown(root.normalizedX(mouse.x), root.normalizedY(mouse.y))
-            }
-            root.lastHoverX = mouse.x
-            root.lastHoverY = mouse.y
-            root.updateSelection(mouse.x, mouse.y)
-            uiBridge.sendTouchMove(root.normalizedX(mouse.x), root.normalizedY(mouse.y))
-        }
-        onReleased: (mouse) => {
-            if (mouse.button !== Qt.LeftButton) {
-                return
             }
-            root.commitSelection()
-            uiBridge.sendTouchUp(root.normalizedX(mouse.x), root.normalizedY(mouse.y))
         }
-        onClicked: (mouse) => {
-            if (mouse.button === Qt.RightButton) {
-                uiBridge.sendAction("enter")
-            }
-        }
-    }
-
-    function normalizedX(x) {
-        var value = x / width
-        return Math.max(0, Math.min(1, value))
+        onTouchEnded: root.endPrediction()
+        onExited: root.updateSelection(width / 2, height / 2)
+        onSecondaryClicked: uiBridge.sendAction("enter")
     }
 
-    function normalizedY(y) {
-        var value = y / height
-        return Math.max(0, Math.min(1, value))
+    // Sector pad; events of the right pad's device pass through to the item below.
+    RadialInput {
+        id: leftInput
+        anchors.fill: parent
+        visible: root.dualPad
+        enabled: root.dualPad
+        bridge: uiBridge
+        pad: "left"
+        device: leftPadDevice
     }
 
+    // Local selection while the engine is unreachable; same compiled rules as the engine.
     function updateSelection(x, y) {
         if (uiBridge.connected) {
             return
         }
-        var dx = x - width / 2
-        var dy = y - height / 2
-        var angle = Math.atan2(dy, dx)
-        var radius = Math.sqrt(dx * dx + dy * dy) / (Math.min(width, height) * 0.5)
-        if (angle < 0) {
-            angle += 2 * Math.PI
-        }
-        angle += Math.PI / 2
-        if (angle >= 2 * Math.PI) {
-            angle -= 2 * Math.PI
-        }
-        if (radius < root.deadzoneRadius) {
-            if (root.selectedSector !== -1 || root.selectedLetter !== -1) {
-                root.selectedSector = -1
-                root.selectedLetter = -1
-                root.localTrackingLetter = false
-                root.selectionChanged(-1, -1)
-                canvas.requestPaint()
-            }
-            return
-        }
-        var index = Math.floor(angle / (2 * Math.PI / root.sectorCount))
-        if (index !== root.selectedSector) {
-            root.selectedSector = index
-            root.selectionChanged(index, root.selectedLetter)
-            canvas.requestPaint()
+        var sel = layout.hitTest(x, y, width, height, root.selectedSector, root.selectedLetter,
+                                 root.localTrackingLetter)
+        root.localTrackingLetter = sel.tracking
+        if (sel.sector !== root.selectedSector || sel.letter !== root.selectedLetter) {
+            root.selectedSector = sel.sector
+            root.selectedLetter = sel.letter
+            root.selectionChanged(sel.sector, sel.letter)
         }
+    }
 
-        if (!root.localTrackingLetter && radius >= root.innerRadius) {
-            root.localTrackingLetter = true
-        } else if (root.localTrackingLetter && radius < (root.innerRadius - root.innerHysteresis)) {
-            root.localTrackingLetter = false
+    // Call once per touch_down / touch_batch sent; each gets exactly one selection reply.
+    function predictSelection(x, y, isDown) {
+        if (!uiBridge.connected || !root.predictionEnabled || root.dualPad) {
+            return
         }
+        var now = Date.now()
+        if (isDown) {
+            predictor.reset()
+        }
+        var p = predictor.update(x, y, now)
+        var sel = layout.hitTest(p.x, p.y, width, height,
+                                 root.predictedSector, root.predictedLetter, root.predictedTrackingLetter)
+        root.predictedSector = sel.sector
+        root.predictedLetter = sel.letter
+        root.predictedTrackingLetter = sel.tracking
+        root.predictionFresh = true
+        predictor.notePrediction(now, sel.sector, sel.letter)
+        predictor.noteSent(now)
+    }
 
-        if (root.localTrackingLetter) {
-            var keys = root.sectorKeys[index] || []
-            if (keys.length > 0) {
-                var localAngle = angle - (index * (2 * Math.PI / root.sectorCount))
-                if (localAngle < 0) {
-                    localAngle += 2 * Math.PI
-                }
-                var keyIndex = Math.floor(localAngle / ((2 * Math.PI / root.sectorCount) / keys.length))
-                if (keyIndex !== root.selectedLetter) {
-                    root.selectedLetter = keyIndex
-                    root.selectionChanged(index, keyIndex)
-                }
-            }
-        } else if (root.selectedLetter !== -1) {
-            root.selectedLetter = -1
-            root.selectionChanged(index, -1)
-            canvas.requestPaint()
-        }
+    function endPrediction() {
+        root.predictionFresh = false
+        root.predictedSector = -1
+        root.predictedLetter = -1
+        root.predictedTrackingLetter = false
     }
 
     function commitSelection() {
-        if (!uiBridge.connected || root.activeSector < 0) {
+        if (!uiBridge.connected || root.commitSector < 0) {
             return false
         }
-        var keys = root.sectorKeys[root.activeSector] || []
-        var keyIndex = root.activeLetter
-        if (keyIndex < 0) {
-            keyIndex = 0
-        }
-        if (keyIndex >= keys.length) {
+        var charToSend = layout.commitText(root.commitSector, Math.max(root.commitLetter, 0))
+        if (charToSend.length === 0) {
             return false
         }
-        var label = keys[keyIndex]
-        if (!label || label.length === 0) {
-            return false
-        }
-        var charToSend = label
-        if (label === "␠") {
-            charToSend = " "
-        } else if (label === "⌫") {
-            charToSend = "\b"
-        } else if (label === "↵") {
-            charToSend = "\n"
-        }
-        console.log("[UI] commitSelection", label, "->", charToSend)
+        console.log("[UI] commitSelection", root.commitSector, root.commitLetter, "->", JSON.stringify(charToSend))
         uiBridge.sendChar(charToSend)
-        if (label === "␠") {
-            return true
-        }
         return true
     }
 
-    onSelectedSectorChanged: canvas.requestPaint()
-    onSelectedLetterChanged: canvas.requestPaint()
-    onActiveSectorChanged: canvas.requestPaint()
-    onActiveLetterChanged: canvas.requestPaint()
-    onWidthChanged: canvas.requestPaint()
-    onHeightChanged: canvas.requestPaint()
-
     Connections {
         target: uiBridge
         function onSelectionReceived(sector, letter, stage, clearSelection) {
+            predictor.noteReply(Date.now(), clearSelection ? -1 : sector, clearSelection ? -1 : letter)
+            // Once the engine has answered everything sent so far, its selection is current.
+            root.predictionFresh = predictor.pendingSends.length > 0
             if (clearSelection || sector === -1) {
                 root.engineSelectedSector = -1
                 root.engineSelectedLetter = -1
@@ -259,6 +199,8 @@ Item {
             root.engineSelectedLetter = letter
         }
         function onConnectedChanged() {
+            predictor.reset()
+            root.endPrediction()
             if (!uiBridge.connected) {
                 root.engineSelectedSector = -1
                 root.engineSelectedLetter = -1
@@ -0,0 +1,103 @@
+import QtQuick 2.15
+
+// INTENT: Prediction only hides round-trip latency in the highlight; the engine stays
+// INTENT: authoritative for selection and commits. Mismatch counters exist to tune the filter.
+
+QtObject {
+    id: predictor
+
+    // Alpha-beta (steady-state constant-velocity Kalman) gains.
+    property real alpha: 0.85
+    property real beta: 0.3
+    // How far ahead to extrapolate. Tracks the measured engine round trip, clamped.
+    property real leadMs: 8
+    property real maxLeadMs: 40
+    property real rttEmaMs: 8
+
+    property real x: 0
+    property real y: 0
+    property real vx: 0
+    property real vy: 0
+    property real lastMs: 0
+    property bool primed: false
+
+    property int confirmed: 0
+    property int corrected: 0
+    readonly property real mismatchRate: (confirmed + corrected) > 0 ? corrected / (confirmed + corrected) : 0
+
+    // Replies can stop arriving (engine restart); both backlogs are kept this short, and a send
+    // unanswered for replyTimeoutMs is taken as lost.
+    readonly property int maxPending: 64
+    property real replyTimeoutMs: 500
+
+    // Send times of touch_down/touch_move messages still waiting for their selection reply.
+    property var pendingSends: []
+    // Predicted selections, each tagged with the time the thumb was expected to be there.
+    property var pendingPredictions: []
+
+    function reset() {
+        primed = false
+        vx = 0
+        vy = 0
+        pendingSends = []
+        pendingPredictions = []
+    }
+
+    // Feeds one pointer sample (item pixels) and returns the extrapolated position.
+    function update(px, py, nowMs) {
+        if (!primed) {
+            x = px
+            y = py
+            vx = 0
+            vy = 0
+            lastMs = nowMs
+            primed = true
+            return { x: px, y: py }
+        }
+        var dt = Math.max(1, nowMs - lastMs)
+        var predX = x + vx * dt
+        var predY = y + vy * dt
+        var rx = px - predX
+        var ry = py - predY
+        x = predX + alpha * rx
+        y = predY + alpha * ry
+        vx += beta * rx / dt
+        vy += beta * ry / dt
+        lastMs = nowMs
+        return { x: x + vx * leadMs, y: y + vy * leadMs }
+    }
+
+    function noteSent(nowMs) {
+        while (pendingSends.length > 0
+               && (pendingSends.length >= maxPending || nowMs - pendingSends[0] > replyTimeoutMs)) {
+            pendingSends.shift()
+        }
+        pendingSends.push(nowMs)
+    }
+
+    function notePrediction(nowMs, sector, letter) {
+        pendingPredictions.push({ targetMs: nowMs + leadMs, sector: sector, letter: letter })
+        if (pendingPredictions.length > maxPending) {
+            pendingPredictions.shift()
+        }
+    }
+
+    // Called for every engine selection reply. The reply describes the thumb at the time its
+    // touch message was sent; every prediction aimed at or before that time is scored against it.
+    function noteReply(nowMs, sector, letter) {
+        if (pendingSends.length === 0) {
+            return
+        }
+        var sentMs = pendingSends.shift()
+        rttEmaMs = rttEmaMs * 0.9 + (nowMs - sentMs) * 0.1
+        leadMs = Math.min(maxLeadMs, Math.max(0, rttEmaMs))
+        while (pendingPredictions.length > 0 && pendingPredictions[0].targetMs <= sentMs) {
+            var p = pendingPredictions.shift()
+            if (p.sector === sector && p.letter === letter) {
+                confirmed++
+            } else {
+                corrected++
+            }
+        }
+    }
+}
@@ -2,16 +2,93 @@
 #include <QDBusConnection>
 #include <QDBusInterface>
 #include <QDBusReply>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QStandardPaths>
 #include <QTextStream>
+#include <QThread>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+
+#include <unistd.h>
 
 namespace {
 
+constexpr int kEngineTimeoutMs = 2000;
+
 int printUsage(const QString &appName) {
     QTextStream err(stderr);
-    err << "Usage: " << appName << " toggle|show|hide|status\n";
+    err << "Usage: " << appName << " toggle|show|hide|status\n"
+        << "       " << appName << " stats [--json]\n"
+        << "       " << appName << " trace start|stop|dump [file]\n"
+        << "       " << appName << " probe [--rounds N] [--json]\n"
+        << "       " << appName << " wakeups [seconds]\n";
     return 2;
 }
 
+QString engineSocketPath() {
+    const QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (!runtimeDir.isEmpty()) {
+        return runtimeDir + "/radialkb.sock";
+    }
+    return QString("/tmp/radialkb-%1.sock").arg(getuid());
+}
+
+// Sends one message to the engine and waits for its one-line reply.
+bool requestEngine(QLocalSocket &socket, const QByteArray &message, QByteArray &reply) {
+    if (socket.state() != QLocalSocket::ConnectedState) {
+        socket.connectToServer(engineSocketPath());
+        if (!socket.waitForConnected(kEngineTimeoutMs)) {
+            return false;
+        }
+    }
+    socket.write(message);
+    socket.write("\n", 1);
+    while (!socket.canReadLine()) {
+        if (!socket.waitForReadyRead(kEngineTimeoutMs)) {
+            return false;
+        }
+    }
+    reply = socket.readLine().trimmed();
+    return true;
+}
+
+int printStats(bool asJson) {
+    QLocalSocket socket;
+    QByteArray reply;
+    QTextStream err(stderr);
+    if (!requestEngine(socket, QByteArrayLiteral("{\"type\":\"stats\"}"), reply)) {
+        err << "radialkbctl: engine is not reachable at " << engineSocketPath() << ": " << socket.errorString() << "\n";
+        return 1;
+    }
+    const QJsonObject stats = QJsonDocument::fromJson(reply).object();
+    if (stats.value("type").toString() != "stats") {
+        err << "radialkbctl: unexpected reply: " << reply << "\n";
+        return 1;
+    }
+    QTextStream out(stdout);
+    if (asJson) {
+        out << QJsonDocument(stats).toJson(QJsonDocument::Indented);
+        return 0;
+    }
+    out << "uptime_ms " << stats.value("uptime_ms").toVariant().toLongLong() << "\n";
+    for (const char *section : {"counters", "gauges", "process"}) {
+        const QJsonObject values = stats.value(QLatin1String(section)).toObject();
+        for (auto it = values.begin(); it != values.end(); ++it) {
+            out << it.key() << " " << it.value().toVariant().toLongLong() << "\n";
+        }
+    }
+    return 0;
+}
+
 bool ensureInterfaceValid(const QDBusInterface &iface) {
     return iface.isValid() && QDBusConnection::sessionBus().isConnected();
 }
@@ -38,11 +115,288 @@ int callAndReport(QDBusInterface &iface, const QString &method) {
     return printStatus(iface);
 }
 
+int controlTrace(const QString &command, const QString &path) {
+    QJsonObject message;
+    if (command == "dump") {
+        message.insert("type", "trace_dump");
+        // The engine only writes into its own trace directory; the file is copied out below.
+        if (!path.isEmpty()) {
+            const QString name = QFileInfo(path).fileName();
+            message.insert("name", name.endsWith(".json") ? name : name + ".json");
+        }
+    } else {
+        message.insert("type", "trace");
+        message.insert("enabled", command == "start");
+    }
+    QLocalSocket socket;
+    QByteArray reply;
+    QTextStream err(stderr);
+    if (!requestEngine(socket, QJsonDocument(message).toJson(QJsonDocument::Compact), reply)) {
+        err << "radialkbctl: engine is not reachable at " << engineSocketPath() << ": " << socket.errorString() << "\n";
+        return 1;
+    }
+    const QJsonObject result = QJsonDocument::fromJson(reply).object();
+    if (result.contains("error")) {
+        err << "radialkbctl: " << result.value("error").toString() << "\n";
+        return 1;
+    }
+    QTextStream out(stdout);
+    if (command == "dump") {
+        QString written = result.value("path").toString();
+        if (!path.isEmpty() && QFileInfo(path).absoluteFilePath() != written) {
+            QFile::remove(path);
+            if (!QFile::copy(written, path)) {
+                err << "radialkbctl: cannot copy " << written << " to " << path << "\n";
+                return 1;
+            }
+            written = path;
+        }
+        out << "wrote " << result.value("events").toInt() << " events to " << written << "\n";
+    } else {
+        out << "tracing=" << (result.value("enabled").toBool() ? "on" : "off") << "\n";
+    }
+    return 0;
+}
+
+// Round trips slower than a 60 Hz frame are visible to the user.
+constexpr qint64 kStallRttUs = 16000;
+
+struct ProbeMessage {
+    QByteArray type;
+    QByteArray line;
+};
+
+QByteArray touchLine(const char *type, double x, double y) {
+    return QByteArray("{\"type\":\"") + type + "\",\"x\":" + QByteArray::number(x, 'f', 4)
+        + ",\"y\":" + QByteArray::number(y, 'f', 4) + "}";
+}
+
+// Ring drags ending in a tap, a batched drag, and swipes: the message mix of real typing.
+QVector<ProbeMessage> probeScript(int rounds) {
+    QVector<ProbeMessage> script;
+    auto ringX = [](double angle, double radius) { return 0.5 + radius * std::sin(angle); };
+    auto ringY = [](double angle, double radius) { return 0.5 - radius * std::cos(angle); };
+    for (int round = 0; round < rounds; ++round) {
+        const double start = round * 0.7;
+        script.push_back({"touch_down", touchLine("touch_down", ringX(start, 0.2), ringY(start, 0.2))});
+        for (int i = 1; i <= 12; ++i) {
+            const double radius = qMin(0.38, 0.2 + i * 0.03);
+            script.push_back({"touch_move", touchLine("touch_move", ringX(start + i * 0.02, radius),
+                                                      ringY(start + i * 0.02, radius))});
+        }
+        QByteArray points;
+        for (int i = 0; i < 6; ++i) {
+            const double angle = start + 0.24 + i * 0.01;
+            points += (i ? "," : "") + QByteArray::number(ringX(angle, 0.38), 'f', 4) + ","
+                + QByteArray::number(ringY(angle, 0.38), 'f', 4) + ",4";
+        }
+        script.push_back({"touch_batch", "{\"type\":\"touch_batch\",\"phase\":\"move\",\"points\":[" + points + "]}"});
+        script.push_back({"touch_up", touchLine("touch_up", ringX(start + 0.3, 0.38), ringY(start + 0.3, 0.38))});
+
+        // Alternate space and backspace swipes; every fifth round cancels with a down swipe.
+        const double direction = round % 5 == 4 ? 0.0 : (round % 2 ? -1.0 : 1.0);
+        const double dy = direction == 0.0 ? 0.3 : 0.0;
+        script.push_back({"touch_down", touchLine("touch_down", 0.5 - 0.15 * direction, 0.4)});
+        script.push_back({"touch_move", touchLine("touch_move", 0.5, 0.4 + dy / 2.0)});
+        script.push_back({"touch_up", touchLine("touch_up", 0.5 + 0.15 * direction, 0.4 + dy)});
+    }
+    return script;
+}
+
+qint64 percentile(const QVector<qint64> &sorted, double fraction) {
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+    const int index = qBound(0, static_cast<int>(std::ceil(fraction * sorted.size())) - 1, sorted.size() - 1);
+    return sorted.at(index);
+}
+
+QJsonObject requestStats(QLocalSocket &socket) {
+    QByteArray reply;
+    if (!requestEngine(socket, QByteArrayLiteral("{\"type\":\"stats\"}"), reply)) {
+        return {};
+    }
+    return QJsonDocument::fromJson(reply).object();
+}
+
+qint64 statValue(const QJsonObject &stats, const char *section, const char *name) {
+    return stats.value(QLatin1String(section)).toObject().value(QLatin1String(name)).toVariant().toLongLong();
+}
+
+int runProbe(int rounds, bool asJson) {
+    QTextStream err(stderr);
+    QLocalSocket socket;
+    QByteArray reply;
+    if (!requestEngine(socket, QByteArrayLiteral("{\"type\":\"probe_session\"}"), reply)) {
+        err << "radialkbctl: engine is not reachable at " << engineSocketPath() << ": " << socket.errorString() << "\n";
+        return 1;
+    }
+    if (QJsonDocument::fromJson(reply).object().value("ok").toBool() != true) {
+        // An engine without probe sessions would type the script into the focused app.
+        err << "radialkbctl: engine does not support probe sessions; refusing to send input\n";
+        return 1;
+    }
+
+    const QJsonObject before = requestStats(socket);
+    const QVector<ProbeMessage> script = probeScript(rounds);
+    QHash<QByteArray, QVector<qint64>> rtts;
+    QVector<QByteArray> order;
+    QElapsedTimer total;
+    total.start();
+    QElapsedTimer timer;
+    for (const ProbeMessage &message : script) {
+        timer.start();
+        if (!requestEngine(socket, message.line, reply)) {
+            err << "radialkbctl: no reply to " << message.type << ": " << socket.errorString() << "\n";
+            return 1;
+        }
+        if (!rtts.contains(message.type)) {
+            order.push_back(message.type);
+        }
+        rtts[message.type].push_back(timer.nsecsElapsed() / 1000);
+    }
+    const qint64 elapsedMs = total.elapsed();
+    const QJsonObject after = requestStats(socket);
+    const qint64 engineStalls = statValue(after, "counters", "event_loop.stalls") - statValue(before, "counters", "event_loop.stalls");
+    const qint64 engineStallMaxMs = statValue(after, "gauges", "event_loop.stall_max_ms");
+
+    QJsonArray types;
+    int slowReplies = 0;
+    for (const QByteArray &type : order) {
+        QVector<qint64> samples = rtts.value(type);
+        std::sort(samples.begin(), samples.end());
+        const int slow = static_cast<int>(samples.end() - std::upper_bound(samples.begin(), samples.end(), kStallRttUs));
+        slowReplies += slow;
+        QJsonObject entry;
+        entry.insert("type", QString::fromLatin1(type));
+        entry.insert("count", samples.size());
+        entry.insert("p50_us", percentile(samples, 0.50));
+        entry.insert("p90_us", percentile(samples, 0.90));
+        entry.insert("p99_us", percentile(samples, 0.99));
+        entry.insert("max_us", samples.last());
+        entry.insert("slow", slow);
+        types.append(entry);
+    }
+    const bool stalled = slowReplies > 0 || engineStalls > 0;
+
+    QTextStream out(stdout);
+    if (asJson) {
+        QJsonObject report;
+        report.insert("messages", script.size());
+        report.insert("elapsed_ms", elapsedMs);
+        report.insert("types", types);
+        report.insert("slow_replies", slowReplies);
+        report.insert("engine_stalls", engineStalls);
+        report.insert("engine_stall_max_ms", engineStallMaxMs);
+        report.insert("stalled", stalled);
+        out << QJsonDocument(report).toJson(QJsonDocument::Indented);
+    } else {
+        out << "probe: " << script.size() << " messages in " << elapsedMs << " ms (commits discarded)\n";
+        out << QString("%1 %2 %3 %4 %5 %6\n")
+                   .arg(QStringLiteral("type"), -12)
+                   .arg(QStringLiteral("count"), 6)
+                   .arg(QStringLiteral("p50_us"), 8)
+                   .arg(QStringLiteral("p90_us"), 8)
+                   .arg(QStringLiteral("p99_us"), 8)
+                   .arg(QStringLiteral("max_us"), 8);
+        for (const QJsonValue &value : types) {
+            const QJsonObject entry = value.toObject();
+            out << QString("%1 %2 %3 %4 %5 %6\n")
+                       .arg(entry.value("type").toString(), -12)
+                       .arg(entry.value("count").toInt(), 6)
+                       .arg(entry.value("p50_us").toVariant().toLongLong(), 8)
+                       .arg(entry.value("p90_us").toVariant().toLongLong(), 8)
+                       .arg(entry.value("p99_us").toVariant().toLongLong(), 8)
+                       .arg(entry.value("max_us").toVariant().toLongLong(), 8);
+        }
+        if (slowReplies > 0) {
+            out << "STALL: " << slowReplies << " replies took longer than " << kStallRttUs / 1000 << " ms\n";
+        }
+        if (engineStalls > 0) {
+            out << "STALL: engine event loop stalled " << engineStalls << " times during the probe (max "
+                << engineStallMaxMs << " ms since start)\n";
+        }
+        if (!stalled) {
+            out << "no stalls\n";
+        }
+    }
+    return stalled ? 3 : 0;
+}
+
+// Engine wakeups per second: context switches of all engine threads over an idle window.
+// The connection stays open but silent in between, so only the closing stats request adds one.
+int measureWakeups(int seconds) {
+    QTextStream err(stderr);
+    QLocalSocket socket;
+    const QJsonObject before = requestStats(socket);
+    if (before.isEmpty()) {
+        err << "radialkbctl: engine is not reachable at " << engineSocketPath() << ": " << socket.errorString() << "\n";
+        return 1;
+    }
+    QElapsedTimer window;
+    window.start();
+    QThread::msleep(static_cast<unsigned long>(seconds) * 1000);
+    const QJsonObject after = requestStats(socket);
+    const qint64 elapsedMs = window.elapsed();
+    if (after.isEmpty()) {
+        err << "radialkbctl: no reply from engine: " << socket.errorString() << "\n";
+        return 1;
+    }
+    const qint64 switches = statValue(after, "process", "context_switches") - statValue(before, "process", "context_switches");
+    QTextStream out(stdout);
+    out << "engine wakeups " << QString::number(switches * 1000.0 / qMax<qint64>(1, elapsedMs), 'f', 2) << "/s ("
+        << switches << " context switches in " << elapsedMs << " ms, "
+        << statValue(after, "process", "threads") << " threads, "
+        << (statValue(after, "gauges", "power.parked") ? "parked" : "ready") << ")\n";
+    return 0;
+}
+
 } // namespace
 
 int main(int argc, char *argv[]) {
     QCoreApplication app(argc, argv);
     const QStringList args = app.arguments();
+    if (args.value(1).toLower() == "stats") {
+        if (args.size() > 3 || (args.size() == 3 && args.at(2) != "--json")) {
+            return printUsage(args.value(0, QStringLiteral("radialkbctl")));
+        }
+        return printStats(args.size() == 3);
+    }
+    if (args.value(1).toLower() == "probe") {
+        int rounds = 50;
+        bool asJson = false;
+        for (int i = 2; i < args.size(); ++i) {
+            bool ok = true;
+            if (args.at(i) == "--json") {
+                asJson = true;
+            } else if (args.at(i) == "--rounds" && i + 1 < args.size()) {
+                rounds = args.at(++i).toInt(&ok);
+            } else {
+                ok = false;
+            }
+            if (!ok || rounds <= 0) {
+                return printUsage(args.value(0, QStringLiteral("radialkbctl")));
+            }
+        }
+        return runProbe(rounds, asJson);
+    }
+    if (args.value(1).toLower() == "wakeups") {
+        bool ok = true;
+        const int seconds = args.size() > 2 ? args.at(2).toInt(&ok) : 10;
+        if (!ok || seconds <= 0 || args.size() > 3) {
+            return printUsage(args.value(0, QStringLiteral("radialkbctl")));
+        }
+        return measureWakeups(seconds);
+    }
+    if (args.value(1).toLower() == "trace") {
+        const QString command = args.value(2).toLower();
+        const bool valid = ((command == "start" || command == "stop") && args.size() == 3)
+            || (command == "dump" && args.size() <= 4);
+        if (!valid) {
+            return printUsage(args.value(0, QStringLiteral("radialkbctl")));
+        }
+        return controlTrace(command, args.value(3));
+    }
     if (args.size() != 2) {
         return printUsage(args.value(0, QStringLiteral("radialkbctl")));
     }
@@ -1,12 +1,70 @@
 #include <QtTest/QtTest>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QThread>
 #include <QtMath>
 
+#include "../src/engine/AdaptiveTouchModel.h"
+#include "../src/engine/Autocorrect.h"
 #include "../src/engine/RadialLayout.h"
-#include "../src/engine/GestureRecognizer.h"
+#include "../src/core/SelectionRules.h"
+#include "../src/core/StaticRadialLayout.h"
+#include "../src/core/GestureRecognizer.h"
+#include "../src/core/GestureTuner.h"
+#include "../src/core/TouchSession.h"
 #include "../src/engine/StateMachine.h"
+#include "../src/engine/ClientSession.h"
+#include "../src/engine/CommitBridge.h"
+#include "../src/engine/Haptics.h"
+#include "../src/engine/InputRouter.h"
+#include "../src/engine/Keymap.h"
+#include "../src/engine/Logging.h"
+#include "../src/engine/Metrics.h"
+#include "../src/engine/Trace.h"
+#include "../src/engine/UInputKeyboard.h"
+#include "../src/engine/UserLexicon.h"
+#include "../src/engine/swipe/SwipeTemplates.h"
+#include "../bench/AllocCounter.h"
+
+#include <fcntl.h>
+#include <linux/input.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
 
 using namespace radialkb;
 
+namespace {
+
+class MockHapticsSink : public HapticsSink {
+public:
+    void play(HapticPulse pulse) override {
+        switch (pulse) {
+        case HapticPulse::Tick:
+            ++ticks;
+            break;
+        case HapticPulse::Commit:
+            ++commits;
+            break;
+        case HapticPulse::Cancel:
+            ++cancels;
+            break;
+        case HapticPulse::None:
+            break;
+        }
+    }
+
+    std::atomic<int> ticks{0};
+    std::atomic<int> commits{0};
+    std::atomic<int> cancels{0};
+};
+
+} // namespace
+
 class EngineTests : public QObject {
     Q_OBJECT
 
@@ -15,6 +73,29 @@ private slots:
     void swipeClassification();
     void stateTransitions();
     void layoutExtendsToTwelve();
+    void commitBridgePreservesOrder();
+    void commitBridgeReplacesMinimalSuffix();
+    void hapticsCoalescesTickBursts();
+    void hapticsCommitOverridesTick();
+    void hapticsDeliversToSink();
+    void touchFastPathMatchesJsonReply();
+    void touchMoveSteadyStateAllocatesNothing();
+    void staticLayoutMatchesRuntime();
+    void touchBatchMatchesIndividualMoves();
+    void selectionRulesApplyHysteresis();
+    void adaptiveTouchShiftsBoundaries();
+    void autocorrectFixesNeighborSlip();
+    void metricsCountRouterEvents();
+    void probeSessionIsolatesTraffic();
+    void traceExportsChromeEvents();
+    void dualPadOverlapsSectorAndKey();
+    void hiddenUiParksEngine();
+    void shapeGesturesMapToActions();
+    void keymapCoalescesShift();
+    void userLexiconReplaysLogTail();
+    void swipeTemplatesCacheAndRebuild();
+    void touchSessionMatchesRouter();
+    void gestureTunerLearnsFromCorrections();
 };
 
 void EngineTests::angleToSectorMaps() {
@@ -53,5 +134,1158 @@ void EngineTests::layoutExtendsToTwelve() {
     }
 }
 
+void EngineTests::commitBridgePreservesOrder() {
+    std::vector<KeyAction> emitted;
+    CommitBridge bridge([&emitted](const KeyAction &action) { emitted.push_back(action); });
+
+    const QString word = QStringLiteral("radial");
+    for (int round = 0; round < 100; ++round) {
+        for (QChar ch : word) {
+            bridge.commitChar(ch);
+        }
+        bridge.commitAction(QStringLiteral("space"));
+    }
+    bridge.commitAction(KeyAction::make(KeyAction::None));
+    bridge.flush();
+
+    QCOMPARE(emitted.size(), std::size_t(100 * (word.size() + 1)));
+    for (std::size_t i = 0; i < emitted.size(); ++i) {
+        const std::size_t pos = i % (word.size() + 1);
+        if (pos == std::size_t(word.size())) {
+            QCOMPARE(emitted[i].type, KeyAction::Space);
+        } else {
+            QCOMPARE(emitted[i].type, KeyAction::Char);
+            QCOMPARE(emitted[i].ch, word.at(int(pos)).toLatin1());
+        }
+    }
+}
+
+void EngineTests::commitBridgeReplacesMinimalSuffix() {
+    std::vector<KeyAction> emitted;
+    CommitBridge bridge([&emitted](const KeyAction &action) { emitted.push_back(action); });
+    for (QChar ch : QStringLiteral("say thw")) {
+        if (ch == ' ') {
+            bridge.commitAction(QStringLiteral("space"));
+        } else {
+            bridge.commitChar(ch);
+        }
+    }
+    QVERIFY(bridge.replace(QStringLiteral("thw"), QStringLiteral("the")));
+    QVERIFY(!bridge.replace(QStringLiteral("xyz"), QStringLiteral("abc")));
+    bridge.flush();
+    QCOMPARE(bridge.journal(), QStringLiteral("say the"));
+    QCOMPARE(emitted.size(), std::size_t(9));
+    QCOMPARE(emitted[7].type, KeyAction::Backspace);
+    QCOMPARE(emitted[8].type, KeyAction::Char);
+    QCOMPARE(emitted[8].ch, 'e');
+
+    // A batch reaches the device as one write.
+    int fds[2];
+    QCOMPARE(pipe2(fds, O_NONBLOCK | O_CLOEXEC), 0);
+    {
+        UInputKeyboard keyboard(fds[1]);
+        keyboard.beginBatch();
+        keyboard.sendKey(KEY_BACKSPACE);
+        keyboard.sendText(QStringLiteral("e"));
+        char probe;
+        QCOMPARE(read(fds[0], &probe, 1), ssize_t(-1));
+        keyboard.endBatch();
+        input_event events[64];
+        const ssize_t bytes = read(fds[0], events, sizeof(events));
+        QVERIFY(bytes > 0);
+        QCOMPARE(bytes % ssize_t(sizeof(input_event)), ssize_t(0));
+    }
+    close(fds[0]);
+}
+
+void EngineTests::hapticsCoalescesTickBursts() {
+    HapticsScheduler scheduler({35});
+    QVERIFY(scheduler.submit(HapticPulse::Tick));
+    QCOMPARE(scheduler.takeDue(1000), HapticPulse::Tick);
+
+    // A sweep across five sectors inside one interval yields a single deferred tick.
+    for (int i = 0; i < 5; ++i) {
+        scheduler.submit(HapticPulse::Tick);
+    }
+    QCOMPARE(scheduler.nextDueMs(), std::int64_t(1035));
+    QCOMPARE(scheduler.takeDue(1030), HapticPulse::None);
+    QCOMPARE(scheduler.takeDue(1035), HapticPulse::Tick);
+    QCOMPARE(scheduler.fired(), std::uint64_t(2));
+    QCOMPARE(scheduler.coalesced(), std::uint64_t(4));
+    QCOMPARE(scheduler.nextDueMs(), std::int64_t(-1));
+}
+
+void EngineTests::hapticsCommitOverridesTick() {
+    HapticsScheduler scheduler({35});
+    scheduler.submit(HapticPulse::Tick);
+    QCOMPARE(scheduler.takeDue(0), HapticPulse::Tick);
+    scheduler.submit(HapticPulse::Tick);
+    scheduler.submit(HapticPulse::Commit);
+    scheduler.submit(HapticPulse::Tick);
+    QCOMPARE(scheduler.takeDue(35), HapticPulse::Commit);
+    QCOMPARE(scheduler.takeDue(80), HapticPulse::None);
+
+    // Fast typing: commits inside one interval are deferred one interval apart, never merged.
+    scheduler.submit(HapticPulse::Commit);
+    scheduler.submit(HapticPulse::Tick);
+    scheduler.submit(HapticPulse::Commit);
+    scheduler.submit(HapticPulse::Cancel);
+    QCOMPARE(scheduler.takeDue(100), HapticPulse::Commit);
+    QCOMPARE(scheduler.takeDue(120), HapticPulse::None);
+    QCOMPARE(scheduler.takeDue(135), HapticPulse::Commit);
+    QCOMPARE(scheduler.takeDue(170), HapticPulse::Cancel);
+    QCOMPARE(scheduler.takeDue(300), HapticPulse::None);
+    QCOMPARE(scheduler.coalesced(), std::uint64_t(3));
+}
+
+void EngineTests::hapticsDeliversToSink() {
+    auto sink = std::make_unique<MockHapticsSink>();
+    MockHapticsSink *mock = sink.get();
+    Haptics haptics(std::move(sink));
+    for (int i = 0; i < 20; ++i) {
+        haptics.onSelectionChange();
+    }
+    haptics.onCommit();
+    QTRY_COMPARE(mock->commits.load(), 1);
+    QVERIFY(mock->ticks.load() <= 1);
+    QCOMPARE(mock->cancels.load(), 0);
+}
+
+void EngineTests::touchFastPathMatchesJsonReply() {
+    InputRouter router([](const KeyAction &) {}, std::make_unique<NullHapticsSink>());
+    const QByteArray fast = router.handleMessageUtf8(
+        QByteArrayLiteral("{\"type\":\"touch_down\",\"x\":0.5765,\"y\":0.315}"));
+    // An escaped type name forces the general QJsonDocument path; the reply must be identical.
+    const QByteArray general = router.handleMessageUtf8(
+        QByteArrayLiteral("{\"y\":0.315,\"type\":\"touch\\u005fmove\",\"x\":0.5765}"));
+    QCOMPARE(fast, general);
+
+    const QJsonObject reply = QJsonDocument::fromJson(fast).object();
+    QCOMPARE(reply.value("type").toString(), QStringLiteral("selection"));
+    QCOMPARE(reply.value("sector").toInt(), 0);
+    QCOMPARE(reply.value("letter").toInt(), -1);
+    QCOMPARE(reply.value("stage").toString(), QStringLiteral("group"));
+    QCOMPARE(reply.value("clearSelection").toBool(), false);
+    QCOMPARE(reply.value("ack").toBool(), true);
+
+    // Non-finite coordinates are not JSON; they are rejected and leave the selection alone.
+    for (const char *line : {"{\"type\":\"touch_move\",\"x\":nan,\"y\":0.315}",
+                             "{\"type\":\"touch_move\",\"x\":0.5765,\"y\":-inf}"}) {
+        QCOMPARE(router.handleMessageUtf8(line), QByteArrayLiteral("{\"error\":\"invalid_json\"}"));
+    }
+    QCOMPARE(router.handleMessageUtf8(QByteArrayLiteral("{\"type\":\"touch_move\",\"x\":0.5765,\"y\":0.315}")),
+             fast);
+}
+
+void EngineTests::touchMoveSteadyStateAllocatesNothing() {
+    Logging::setMinLevel(LogLevel::Info);
+    InputRouter router([](const KeyAction &) {}, std::make_unique<NullHapticsSink>());
+
+    // Hold the thumb inside sector 0 on the group ring with a little jitter.
+    QVector<QByteArray> moves;
+    for (int i = 0; i < 32; ++i) {
+        moves.push_back(QString("{\"type\":\"touch_move\",\"x\":%1,\"y\":%2}")
+                            .arg(0.5765 + 0.0002 * (i % 5), 0, 'f', 4)
+                            .arg(0.315 - 0.0002 * (i % 3), 0, 'f', 4)
+                            .toUtf8());
+    }
+    // The same jitter as per-frame batches of four samples, as the UI sends them.
+    for (int i = 0; i < 8; ++i) {
+        QString points;
+        for (int j = 0; j < 4; ++j) {
+            const int sample = i * 4 + j;
+            points += QString("%1%2,%3,2").arg(j == 0 ? "" : ",")
+                          .arg(0.5765 + 0.0002 * (sample % 5), 0, 'f', 4)
+                          .arg(0.315 - 0.0002 * (sample % 3), 0, 'f', 4);
+        }
+        moves.push_back(QString("{\"type\":\"touch_batch\",\"phase\":\"move\",\"points\":[%1]}").arg(points).toUtf8());
+    }
+    router.handleMessageUtf8(QByteArrayLiteral("{\"type\":\"touch_down\",\"x\":0.5765,\"y\":0.315}"));
+    for (const QByteArray &line : moves) {
+        QCOMPARE(QJsonDocument::fromJson(router.handleMessageUtf8(line)).object().value("sector").toInt(), 0);
+    }
+
+    const AllocationScope allocations;
+    for (int round = 0; round < 10; ++round) {
+        for (const QByteArray &line : moves) {
+            const QByteArray reply = router.handleMessageUtf8(line);
+            Q_UNUSED(reply);
+        }
+    }
+    const std::uint64_t count = allocations.count();
+    Logging::setMinLevel(LogLevel::Debug);
+    QCOMPARE(count, std::uint64_t(0));
+}
+
+void EngineTests::staticLayoutMatchesRuntime() {
+    const RadialLayout runtime({8, 0.5, 0.5, M_PI / 2.0});
+    const DefaultRadialLayout compiled(kDefaultRadialTables);
+    QCOMPARE(compiled.sectors(), runtime.sectors());
+
+    for (int sector = 0; sector < runtime.sectors(); ++sector) {
+        QCOMPARE(compiled.keyCount(sector), runtime.keyCount(sector));
+        for (int key = 0; key < runtime.keyCount(sector); ++key) {
+            const KeyAction a = compiled.keyAction(sector, key);
+            const KeyAction b = runtime.keyAction(sector, key);
+            QCOMPARE(int(a.type), int(b.type));
+            QCOMPARE(a.ch, b.ch);
+            QCOMPARE(QString::fromUtf8(keyLabel(a)), runtime.keyLabel(sector, key));
+            QVERIFY(qAbs(compiled.keyAnchor(sector, key).x - runtime.keyAnchor(sector, key).x) < 1e-9);
+            QVERIFY(qAbs(compiled.keyAnchor(sector, key).y - runtime.keyAnchor(sector, key).y) < 1e-9);
+        }
+    }
+
+    // Pseudo-random points; the tables must agree with the runtime math everywhere except
+    // within rounding distance of a boundary, which the fixed seed avoids.
+    const double hysteresis = 3.0 * M_PI / 180.0;
+    quint32 seed = 12345u;
+    auto next = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) / double(1u << 24);
+    };
+    for (int i = 0; i < 5000; ++i) {
+        const double x = next();
+        const double y = next();
+        const double angle = runtime.angleForPoint(x, y);
+        QVERIFY(qAbs(compiled.angleForPoint(x, y) - angle) < 1e-12);
+        QCOMPARE(compiled.radiusForPoint(x, y), runtime.radiusForPoint(x, y));
+        const int previous = i % 9 - 1;
+        const int sector = runtime.angleToSectorWithHysteresis(angle, previous, hysteresis);
+        QCOMPARE(compiled.angleToSectorWithHysteresis(angle, previous, hysteresis), sector);
+        const int previousKey = i % 5 - 1;
+        QCOMPARE(compiled.angleToKeyIndexWithHysteresis(angle, sector, previousKey, hysteresis),
+                 runtime.angleToKeyIndexWithHysteresis(angle, sector, previousKey, hysteresis));
+        const int otherSector = (sector + 3) % 8;
+        QCOMPARE(compiled.angleToKeyIndexWithHysteresis(angle, otherSector, -1, 0.0),
+                 runtime.angleToKeyIndexWithHysteresis(angle, otherSector, -1, 0.0));
+    }
+}
+
+void EngineTests::touchBatchMatchesIndividualMoves() {
+    InputRouter one([](const KeyAction &) {}, std::make_unique<NullHapticsSink>());
+    InputRouter batch([](const KeyAction &) {}, std::make_unique<NullHapticsSink>());
+
+    // Sweep from the group ring of sector 0 out to the letter ring.
+    QString points;
+    QByteArray lastMoveReply;
+    one.handleMessageUtf8(QByteArrayLiteral("{\"type\":\"touch_down\",\"x\":0.5765,\"y\":0.315}"));
+    for (int i = 1; i <= 6; ++i) {
+        const double x = 0.5765 + 0.005 * i;
+        const double y = 0.315 - 0.02 * i;
+        lastMoveReply = one.handleMessageUtf8(QString("{\"type\":\"touch_move\",\"x\":%1,\"y\":%2}")
+                                                  .arg(x, 0, 'f', 4)
+                                                  .arg(y, 0, 'f', 4)
+                                                  .toUtf8());
+        points += QString("%1%2,%3,8").arg(i == 1 ? "" : ",").arg(x, 0, 'f', 4).arg(y, 0, 'f', 4);
+    }
+    batch.handleMessageUtf8(QByteArrayLiteral("{\"type\":\"touch_down\",\"x\":0.5765,\"y\":0.315}"));
+    const QByteArray batchReply = batch.handleMessageUtf8(
+        QString("{\"type\":\"touch_batch\",\"phase\":\"move\",\"points\":[%1]}").arg(points).toUtf8());
+    QCOMPARE(batchReply, lastMoveReply);
+    QCOMPARE(QJsonDocument::fromJson(batchReply).object().value("stage").toString(), QString("letter"));
+}
+
+void EngineTests::selectionRulesApplyHysteresis() {
+    const DefaultRadialLayout layout(kDefaultRadialTables);
+    auto pointAt = [](double angleFromTop, double radius) {
+        // Layout angles run clockwise from the top of the pad.
+        return QPointF(0.5 + radius * std::sin(angleFromTop), 0.5 - radius * std::cos(angleFromTop));
+    };
+    const double boundary = M_PI / 4.0;
+    const double nudge = 1.0 * M_PI / 180.0;
+
+    // Group ring: just past the sector 0/1 boundary stays in sector 0, well past switches.
+    QPointF p = pointAt(boundary - 0.1, 0.2);
+    SelectionState state = resolveSelection(layout, p.x(), p.y(), SelectionState{});
+    QCOMPARE(state.sector, 0);
+    QCOMPARE(state.trackingLetter, false);
+    p = pointAt(boundary + nudge, 0.2);
+    state = resolveSelection(layout, p.x(), p.y(), state);
+    QCOMPARE(state.sector, 0);
+    p = pointAt(boundary + 0.1, 0.2);
+    state = resolveSelection(layout, p.x(), p.y(), state);
+    QCOMPARE(state.sector, 1);
+
+    // Letter ring is entered at the inner radius and kept until below it minus the hysteresis.
+    p = pointAt(boundary + 0.1, 0.3);
+    state = resolveSelection(layout, p.x(), p.y(), state);
+    QCOMPARE(state.trackingLetter, true);
+    QVERIFY(state.key >= 0);
+    p = pointAt(boundary + 0.1, 0.26);
+    state = resolveSelection(layout, p.x(), p.y(), state);
+    QCOMPARE(state.trackingLetter, true);
+    p = pointAt(boundary + 0.1, 0.2);
+    state = resolveSelection(layout, p.x(), p.y(), state);
+    QCOMPARE(state.trackingLetter, false);
+    QCOMPARE(state.key, -1);
+
+    // Deadzone clears everything.
+    state = resolveSelection(layout, 0.5, 0.52, state);
+    QCOMPARE(state.sector, -1);
+    QCOMPARE(state.key, -1);
+    QCOMPARE(state.trackingLetter, false);
+}
+
+void EngineTests::adaptiveTouchShiftsBoundaries() {
+    const DefaultRadialLayout layout(kDefaultRadialTables);
+    AdaptiveTouchModel model(layout);
+    const LayoutPoint anchor = layout.keyAnchor(1, 0);
+    const double center = layout.angleForPoint(anchor.x, anchor.y);
+    const double keyWidth = (2.0 * M_PI / layout.sectors()) / layout.keyCount(1);
+    // Just past key 0's clockwise edge: key 1 on the plain layout.
+    const double pastEdge = center + keyWidth / 2.0 + 0.01;
+    QCOMPARE(layout.angleToKeyIndexWithHysteresis(pastEdge, 1, -1, 0.0), 1);
+
+    // This user consistently lands clockwise of key 0; taps confirmed by the next commit teach that.
+    std::int64_t now = 0;
+    for (int i = 0; i < 20; ++i) {
+        model.observeTap(1, 0, center + 0.05, now += 300);
+    }
+    model.observeOtherCommit(now += 300);
+    QCOMPARE(model.samples(1, 0), 20);
+    QVERIFY(model.effectiveOffset(1, 0) > 0.0);
+    QCOMPARE(layout.angleToKeyIndexWithHysteresis(model.correctedAngle(pastEdge), 1, -1, 0.0), 0);
+    // Keys without data are untouched far from the learned one.
+    const LayoutPoint far = layout.keyAnchor(5, 2);
+    const double farAngle = layout.angleForPoint(far.x, far.y);
+    QCOMPARE(model.correctedAngle(farAngle), farAngle);
+
+    // A tap undone by backspace is not learned for the wrong key but for its retyped neighbor.
+    model.observeTap(1, 1, center + keyWidth - 0.02, now += 300);
+    model.observeBackspace(now += 200);
+    model.observeTap(1, 0, center + 0.05, now += 200);
+    model.observeOtherCommit(now += 300);
+    QCOMPARE(model.samples(1, 1), 0);
+    QCOMPARE(model.samples(1, 0), 22);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("radialkb/touch_model.bin");
+    QVERIFY(model.save(path));
+    QCOMPARE(model.unsavedUpdates(), 0);
+    AdaptiveTouchModel reloaded(layout);
+    QVERIFY(reloaded.load(path));
+    QCOMPARE(reloaded.samples(1, 0), 22);
+    QCOMPARE(reloaded.correctedAngle(pastEdge), model.correctedAngle(pastEdge));
+}
+
+void EngineTests::autocorrectFixesNeighborSlip() {
+    const DefaultRadialLayout layout(kDefaultRadialTables);
+    Autocorrector autocorrect(layout);
+    auto keyAngle = [&layout](int sector, int key) {
+        const LayoutPoint anchor = layout.keyAnchor(sector, key);
+        return layout.angleForPoint(anchor.x, anchor.y);
+    };
+    const double keyWidth = (2.0 * M_PI / layout.sectors()) / layout.keyCount(0);
+
+    // "the" with the last tap slipping from 'e' onto its neighbor 't' (sector 0: e t a o).
+    autocorrect.noteLetter('t', keyAngle(0, 1), true);
+    autocorrect.noteLetter('h', keyAngle(1, 3), true);
+    autocorrect.noteLetter('t', keyAngle(0, 1) - 0.3 * keyWidth, true);
+    AutocorrectResult result = autocorrect.finishWord();
+    QCOMPARE(result.typed, QByteArray("tht"));
+    QCOMPARE(result.corrected, QByteArray("the"));
+    QCOMPARE(autocorrect.wordLength(), 0);
+
+    // Dictionary words are left alone, and backspaced letters are forgotten.
+    autocorrect.noteLetter('a', keyAngle(0, 2), true);
+    autocorrect.noteLetter('o', keyAngle(0, 3), true);
+    autocorrect.noteBackspace();
+    autocorrect.noteLetter('t', keyAngle(0, 1), true);
+    result = autocorrect.finishWord();
+    QCOMPARE(result.typed, QByteArray("at"));
+    QVERIFY(result.corrected.isEmpty());
+
+    // Without tap positions there is no evidence of a slip.
+    autocorrect.noteLetter('t', 0.0, false);
+    autocorrect.noteLetter('h', 0.0, false);
+    autocorrect.noteLetter('t', 0.0, false);
+    QVERIFY(autocorrect.finishWord().corrected.isEmpty());
+
+    // Router: the correction is typed before the space as a minimal backspace+retype burst.
+    Metrics::reset();
+    QVector<KeyAction> committed;
+    std::mutex committedMutex;
+    {
+        InputRouter router([&](const KeyAction &action) {
+            std::lock_guard<std::mutex> lock(committedMutex);
+            committed.push_back(action);
+        }, std::make_unique<NullHapticsSink>());
+        const double ringRadius = 0.38;
+        auto tapAt = [&](double angle) {
+            // Layout angles run clockwise from the top of the pad.
+            const double x = 0.5 + ringRadius * std::sin(angle);
+            const double y = 0.5 - ringRadius * std::cos(angle);
+            router.handleTouchDown(x, y);
+            router.handleTouchUp(x, y);
+        };
+        tapAt(keyAngle(0, 1));
+        tapAt(keyAngle(1, 3));
+        tapAt(keyAngle(0, 1) - 0.3 * keyWidth);
+        router.handleMessage("{\"type\":\"action\",\"action\":\"space\"}");
+    }
+    QCOMPARE(committed.size(), 6);
+    QCOMPARE(committed.at(3).type, KeyAction::Backspace);
+    QCOMPARE(committed.at(4).ch, 'e');
+    QCOMPARE(committed.at(5).type, KeyAction::Space);
+    // Keystroke stats count what the user typed, not the correction burst.
+    QCOMPARE(Metrics::counter(Counter::CommitChar), std::uint64_t(3));
+    QCOMPARE(Metrics::counter(Counter::CommitBackspace), std::uint64_t(0));
+    QCOMPARE(Metrics::counter(Counter::CommitSpace), std::uint64_t(1));
+    QCOMPARE(Metrics::counter(Counter::Autocorrections), std::uint64_t(1));
+}
+
+void EngineTests::metricsCountRouterEvents() {
+    Metrics::reset();
+    {
+        InputRouter router([](const KeyAction &) {}, std::make_unique<NullHapticsSink>());
+        router.handleMessageUtf8("{\"type\":\"touch_down\",\"x\":0.9,\"y\":0.5}");
+        router.handleMessageUtf8("{\"type\":\"touch_move\",\"x\":0.5,\"y\":0.9}");
+        router.handleMessageUtf8("{\"type\":\"touch_batch\",\"phase\":\"move\",\"points\":[0.5,0.88,4,0.5,0.87,4]}");
+        router.handleMessageUtf8("{\"type\":\"commit_char\",\"char\":\"e\"}");
+        router.handleMessageUtf8("{not json");
+
+        const QJsonObject stats = QJsonDocument::fromJson(router.handleMessageUtf8("{\"type\":\"stats\"}")).object();
+        QCOMPARE(stats.value("type").toString(), QString("stats"));
+        const QJsonObject counters = stats.value("counters").toObject();
+        QCOMPARE(counters.value("messages.touch_down").toInt(), 1);
+        QCOMPARE(counters.value("messages.touch_move").toInt(), 1);
+        QCOMPARE(counters.value("messages.touch_batch").toInt(), 1);
+        QCOMPARE(counters.value("messages.commit_char").toInt(), 1);
+        QCOMPARE(counters.value("touch.samples").toInt(), 4);
+        QCOMPARE(counters.value("commits.char").toInt(), 1);
+        QCOMPARE(counters.value("errors.json_parse").toInt(), 1);
+        QVERIFY(counters.value("selection.changes").toInt() >= 2);
+        QVERIFY(stats.value("gauges").toObject().contains("commit_queue.depth_max"));
+    }
+    QCOMPARE(Metrics::counter(Counter::MessageStats), std::uint64_t(1));
+}
+
+void EngineTests::probeSessionIsolatesTraffic() {
+    Metrics::reset();
+    std::atomic<int> committed{0};
+    {
+        InputRouter router([&committed](const KeyAction &) { ++committed; }, std::make_unique<NullHapticsSink>());
+        ClientSession session(router);
+
+        // Only the message type starts a session, not the name appearing elsewhere.
+        session.handleLine("{\"type\":\"action\",\"action\":\"probe_session\"}");
+        QVERIFY(!session.probing());
+
+        const QJsonObject started = QJsonDocument::fromJson(session.handleLine("{\"type\":\"probe_session\"}")).object();
+        QCOMPARE(started.value("ok").toBool(), true);
+        QVERIFY(session.probing());
+        QCOMPARE(Metrics::counter(Counter::MessageProbe), std::uint64_t(1));
+
+        const std::uint64_t otherBefore = Metrics::counter(Counter::MessageOther);
+        for (int i = 0; i < 5; ++i) {
+            session.handleLine("{\"type\":\"touch_down\",\"x\":0.9,\"y\":0.5}");
+            session.handleLine("{\"type\":\"touch_up\",\"x\":0.9,\"y\":0.5}");
+            session.handleLine("{\"type\":\"commit_char\",\"char\":\"e\"}");
+        }
+        const QJsonObject stats = QJsonDocument::fromJson(session.handleLine("{\"type\":\"stats\"}")).object();
+        QCOMPARE(stats.value("type").toString(), QString("stats"));
+        const QJsonObject counters = stats.value("counters").toObject();
+        QCOMPARE(counters.value("messages.probe").toInt(), 17);
+        QCOMPARE(counters.value("messages.touch_down").toInt(), 0);
+        QCOMPARE(counters.value("messages.commit_char").toInt(), 0);
+        QCOMPARE(counters.value("touch.samples").toInt(), 0);
+        QCOMPARE(counters.value("commits.char").toInt(), 0);
+        QCOMPARE(Metrics::counter(Counter::MessageOther), otherBefore);
+        QCOMPARE(Metrics::counter(Counter::MessageStats), std::uint64_t(0));
+    }
+    QCOMPARE(committed.load(), 0);
+    QCOMPARE(Metrics::counter(Counter::CommitChar), std::uint64_t(0));
+    QCOMPARE(Metrics::gauge(Gauge::CommitQueueDepthMax), std::int64_t(0));
+}
+
+void EngineTests::traceExportsChromeEvents() {
+    InputRouter router([](const KeyAction &) {}, std::make_unique<NullHapticsSink>());
+    Trace::clear();
+    router.handleMessageUtf8("{\"type\":\"touch_down\",\"x\":0.9,\"y\":0.5}");
+    int events = -1;
+    Trace::toChromeJson(&events);
+    QCOMPARE(events, 0);
+
+    Trace::setEnabled(true);
+    router.handleMessageUtf8("{\"type\":\"touch_move\",\"x\":0.5,\"y\":0.9}");
+    router.handleMessageUtf8("{\"type\":\"touch_up\",\"x\":0.5,\"y\":0.9}");
+    Trace::setEnabled(false);
+    router.handleMessageUtf8("{\"type\":\"touch_down\",\"x\":0.9,\"y\":0.5}");
+
+    const QJsonDocument doc = QJsonDocument::fromJson(Trace::toChromeJson(&events));
+    QVERIFY(doc.isObject());
+    QSet<QString> names;
+    for (const QJsonValue &value : doc.object().value("traceEvents").toArray()) {
+        const QJsonObject event = value.toObject();
+        if (event.value("ph").toString() == "X") {
+            names.insert(event.value("name").toString());
+            QVERIFY(event.value("dur").toDouble() >= 0.0);
+        }
+    }
+    QVERIFY(events > 0);
+    QVERIFY(names.contains("parse"));
+    QVERIFY(names.contains("updateSelection"));
+    QVERIFY(names.contains("classifyGesture"));
+    QVERIFY(names.contains("transitionTo"));
+
+    // Socket clients can only name a file inside the trace directory.
+    auto dump = [&router](const char *name) {
+        return QJsonDocument::fromJson(router.handleMessageUtf8(
+                                           QByteArray("{\"type\":\"trace_dump\",\"name\":\"") + name + "\"}"))
+            .object();
+    };
+    for (const char *name : {"../escape.json", "/tmp/absolute.json", "radialkb.sock", ".hidden.json"}) {
+        QVERIFY(dump(name).contains("error"));
+    }
+    const QString written = dump("engine-tests.json").value("path").toString();
+    QCOMPARE(written, Trace::directory() + "/engine-tests.json");
+    QVERIFY(QFile::remove(written));
+    Trace::clear();
+}
+
+void EngineTests::dualPadOverlapsSectorAndKey() {
+    QVector<KeyAction> committed;
+    std::mutex committedMutex;
+    {
+        InputRouter router([&](const KeyAction &action) {
+            std::lock_guard<std::mutex> lock(committedMutex);
+            committed.push_back(action);
+        }, std::make_unique<NullHapticsSink>());
+        QCOMPARE(QJsonDocument::fromJson(router.handleMessageUtf8("{\"type\":\"pad_mode\",\"mode\":\"dual\"}"))
+                     .object().value("mode").toString(), QString("dual"));
+        QVERIFY(router.dualPadEnabled());
+
+        // Angles run clockwise from the top of each pad.
+        auto send = [&](const char *type, const char *pad, double angle, double radius) {
+            const QByteArray line = QByteArray("{\"type\":\"") + type + "\",\"pad\":\"" + pad
+                + "\",\"x\":" + QByteArray::number(0.5 + radius * std::sin(angle))
+                + ",\"y\":" + QByteArray::number(0.5 - radius * std::cos(angle)) + "}";
+            return QJsonDocument::fromJson(router.handleMessageUtf8(line)).object();
+        };
+        const double sectorWidth = 2.0 * M_PI / 8.0;
+        // Sector 1 (insh) on the left pad; the right pad's quarters are its four keys.
+        QJsonObject reply = send("touch_down", "left", 1.5 * sectorWidth, 0.35);
+        QCOMPARE(reply.value("sector").toInt(), 1);
+        QCOMPARE(reply.value("letter").toInt(), -1);
+        reply = send("touch_down", "right", 1.25 * M_PI, 0.35);
+        QCOMPARE(reply.value("sector").toInt(), 1);
+        QCOMPARE(reply.value("letter").toInt(), 2);
+        QCOMPARE(reply.value("stage").toString(), QString("letter"));
+        send("touch_up", "right", 1.25 * M_PI, 0.35);
+
+        // The left thumb moves on to the next group while still down.
+        reply = send("touch_move", "left", 0.5 * sectorWidth, 0.35);
+        QCOMPARE(reply.value("sector").toInt(), 0);
+        send("touch_down", "right", 0.75 * M_PI, 0.35);
+        send("touch_up", "left", 0.5 * sectorWidth, 0.35);
+        send("touch_up", "right", 0.75 * M_PI, 0.35);
+        // At most once per touch: a repeated up commits nothing.
+        send("touch_up", "right", 0.75 * M_PI, 0.35);
+        // A tap in the deadzone picks no key.
+        send("touch_down", "right", 0.25 * M_PI, 0.05);
+        send("touch_up", "right", 0.25 * M_PI, 0.05);
+        // The sector stays latched after the left thumb lifts.
+        send("touch_down", "right", 0.25 * M_PI, 0.35);
+        send("touch_up", "right", 0.25 * M_PI, 0.35);
+
+        // A sector change while the right thumb is down waits for its lift.
+        send("touch_down", "left", 1.5 * sectorWidth, 0.35);
+        reply = send("touch_down", "right", 1.25 * M_PI, 0.35);
+        QCOMPARE(reply.value("sector").toInt(), 1);
+        reply = send("touch_move", "left", 0.5 * sectorWidth, 0.35);
+        QCOMPARE(reply.value("sector").toInt(), 1);
+        QCOMPARE(reply.value("letter").toInt(), 2);
+        send("touch_up", "right", 1.25 * M_PI, 0.35);
+        reply = send("touch_down", "right", 0.75 * M_PI, 0.35);
+        QCOMPARE(reply.value("sector").toInt(), 0);
+        send("touch_up", "right", 0.75 * M_PI, 0.35);
+        send("touch_up", "left", 0.5 * sectorWidth, 0.35);
+
+        router.setDualPadEnabled(false);
+        reply = send("touch_down", "left", 0.0, 0.05);
+        QCOMPARE(reply.value("sector").toInt(), -1);
+    }
+    QCOMPARE(committed.size(), 5);
+    QCOMPARE(committed.at(0).ch, 's');
+    QCOMPARE(committed.at(1).ch, 't');
+    QCOMPARE(committed.at(2).ch, 'e');
+    QCOMPARE(committed.at(3).ch, 's');
+    QCOMPARE(committed.at(4).ch, 't');
+}
+
+void EngineTests::hiddenUiParksEngine() {
+    Metrics::reset();
+    InputRouter router([](const KeyAction &) {}, std::make_unique<NullHapticsSink>());
+    // Threshold far above scheduling jitter, still below the parked interval.
+    StallMonitor monitor(20, 300);
+    connect(&router, &InputRouter::parkedChanged, &monitor, [&monitor](bool parked) { monitor.setActive(!parked); });
+    QVERIFY(monitor.isActive());
+    // Waking does no deferred or blocking work: the router is ready (parkedChanged) before the
+    // message that wakes it returns, and that message is answered as usual. Wakeups while
+    // parked are measured with `radialkbctl wakeups`.
+    bool inCall = false;
+    int wakesInCall = 0;
+    int wakesOutsideCall = 0;
+    connect(&router, &InputRouter::parkedChanged, &monitor, [&](bool parked) {
+        if (!parked) {
+            ++(inCall ? wakesInCall : wakesOutsideCall);
+        }
+    });
+    auto send = [&](const char *message) {
+        inCall = true;
+        const QByteArray reply = router.handleMessageUtf8(message);
+        inCall = false;
+        return reply;
+    };
+
+    send("{\"type\":\"touch_down\",\"x\":0.9,\"y\":0.5}");
+    send("{\"type\":\"ui_hide\"}");
+    QVERIFY(router.parked());
+    QVERIFY(!monitor.isActive());
+    QCOMPARE(Metrics::gauge(Gauge::Parked), std::int64_t(1));
+    const QByteArray touchReply = send("{\"type\":\"touch_move\",\"x\":0.5,\"y\":0.5}");
+    QCOMPARE(QJsonDocument::fromJson(touchReply).object().value("sector").toInt(), -1);
+    QVERIFY(!router.parked());
+    QVERIFY(monitor.isActive());
+    QCOMPARE(wakesInCall, 1);
+
+    send("{\"type\":\"ui_hide\"}");
+    // The event loop does not run while parked; neither does the monitor.
+    QThread::msleep(600);
+    const QByteArray showReply = send("{\"type\":\"ui_show\"}");
+    QVERIFY(QJsonDocument::fromJson(showReply).object().value("ack").toBool());
+    QVERIFY(!router.parked());
+    QVERIFY(monitor.isActive());
+    QCOMPARE(wakesInCall, 2);
+    QCOMPARE(wakesOutsideCall, 0);
+    // A few monitor intervals after waking.
+    QTest::qWait(60);
+    // The parked interval is not reported as an event-loop stall.
+    QCOMPARE(Metrics::counter(Counter::EventLoopStalls), std::uint64_t(0));
+
+    const QJsonObject stats = QJsonDocument::fromJson(send("{\"type\":\"stats\"}")).object();
+    QVERIFY(stats.value("process").toObject().value("context_switches").toInteger() > 0);
+    QCOMPARE(stats.value("gauges").toObject().value("power.parked").toInt(), 0);
+}
+
+void EngineTests::shapeGesturesMapToActions() {
+    // One sample every dtMs along the polyline.
+    auto draw = [](InputRouter &router, const QVector<QPointF> &corners, int steps, double dtMs = 10.0) {
+        QVector<double> points;
+        for (int i = 0; i + 1 < corners.size(); ++i) {
+            for (int step = 0; step < steps; ++step) {
+                const QPointF point = corners.at(i) + (corners.at(i + 1) - corners.at(i)) * step / steps;
+                points << point.x() << point.y() << dtMs;
+            }
+        }
+        points << corners.last().x() << corners.last().y() << dtMs;
+        const int count = points.size() / 3;
+        router.handleTouchBatch(InputRouter::TouchPhase::Down, points.constData(), 1);
+        router.handleTouchBatch(InputRouter::TouchPhase::Move, points.constData() + 3, count - 2);
+        router.handleTouchBatch(InputRouter::TouchPhase::Up, points.constData() + (count - 1) * 3, 1);
+    };
+    // The overlay's order: every sample in touch_batch frames, then its commit_char for the
+    // selection, then touch_up where the last frame ended.
+    auto overlayDraw = [](InputRouter &router, const QVector<QPointF> &corners, int steps, const char *ch) {
+        QJsonArray points;
+        for (int i = 0; i + 1 < corners.size(); ++i) {
+            for (int step = 0; step < steps; ++step) {
+                const QPointF point = corners.at(i) + (corners.at(i + 1) - corners.at(i)) * step / steps;
+                points << point.x() << point.y() << 10.0;
+            }
+        }
+        points << corners.last().x() << corners.last().y() << 10.0;
+        const QJsonArray first{points.at(0), points.at(1), 0.0};
+        QJsonArray rest;
+        for (int i = 3; i < points.size(); ++i) {
+            rest << points.at(i);
+        }
+        auto send = [&router](const QJsonObject &message) {
+            router.handleMessageUtf8(QJsonDocument(message).toJson(QJsonDocument::Compact));
+        };
+        send({{"type", "touch_batch"}, {"phase", "down"}, {"points", first}});
+        send({{"type", "touch_batch"}, {"phase", "move"}, {"points", rest}});
+        send({{"type", "commit_char"}, {"char", ch}});
+        send({{"type", "touch_up"}, {"x", corners.last().x()}, {"y", corners.last().y()}});
+    };
+    auto ringPoint = [](double angle, double radius) {
+        return QPointF(0.5 + radius * std::sin(angle), 0.5 - radius * std::cos(angle));
+    };
+    // Letter strokes: out from the center, then along the ring to the key, both ways and over
+    // up to a sector and a bit, in every sector.
+    const double sectorWidth = 2.0 * M_PI / 8.0;
+    QVector<QVector<QPointF>> letterStrokes;
+    for (int sector = 0; sector < 8; ++sector) {
+        for (double arc : {-1.2, -0.8, -0.4, 0.4, 0.8, 1.2}) {
+            for (double start : {0.3, 0.5, 0.7}) {
+                const double startAngle = (sector + start) * sectorWidth;
+                QVector<QPointF> stroke;
+                for (int i = 0; i <= 8; ++i) {
+                    stroke << ringPoint(startAngle, 0.4 * i / 8);
+                }
+                for (int i = 1; i <= 12; ++i) {
+                    stroke << ringPoint(startAngle + arc * sectorWidth * i / 12, 0.4);
+                }
+                letterStrokes << stroke;
+            }
+        }
+    }
+
+    QVector<KeyAction> committed;
+    QVector<KeyAction> plain;
+    std::mutex committedMutex;
+    const std::uint64_t shapesBefore = Metrics::counter(Counter::ShapeGestures);
+    {
+        InputRouter router([&](const KeyAction &action) {
+            std::lock_guard<std::mutex> lock(committedMutex);
+            committed.push_back(action);
+        }, std::make_unique<NullHapticsSink>());
+        InputRouter reference([&](const KeyAction &action) {
+            std::lock_guard<std::mutex> lock(committedMutex);
+            plain.push_back(action);
+        }, std::make_unique<NullHapticsSink>());
+        reference.setShapeGesturesEnabled(false);
+        // One action per lift: no corrections when a stroke types a space.
+        router.setAutocorrectEnabled(false);
+        reference.setAutocorrectEnabled(false);
+
+        // Shapes are drawn inside the letter ring.
+        QVector<QPointF> circle;
+        for (int i = 0; i <= 32; ++i) {
+            circle << ringPoint(2.0 * M_PI * i / 32, 0.2);
+        }
+        draw(router, circle, 1);
+        draw(router, {{0.3, 0.55}, {0.4, 0.45}, {0.5, 0.55}, {0.6, 0.45}, {0.7, 0.55}}, 8);
+        // Fast enough to clear the swipe-right thresholds too; the shape wins.
+        draw(router, {{0.32, 0.5}, {0.42, 0.6}, {0.62, 0.36}}, 4);
+        // Straight strokes are still swipes and plain taps still type.
+        draw(router, {{0.7, 0.5}, {0.3, 0.5}}, 4);
+        draw(router, {{0.5, 0.5}, {0.5, 0.15}}, 8);
+        // A circle that ends on a letter-ring key types the key.
+        circle.clear();
+        for (int i = 0; i <= 32; ++i) {
+            circle << ringPoint(2.0 * M_PI * i / 32, 0.3);
+        }
+        draw(router, circle, 1);
+        QCOMPARE(Metrics::counter(Counter::ShapeGestures) - shapesBefore, std::uint64_t(3));
+
+        // Slow enough not to be swipes, quick and curved enough for the shape gates: some of
+        // these match a check mark or a scratch-out, but each types its key as it would with
+        // shapes disabled.
+        for (const QVector<QPointF> &stroke : letterStrokes) {
+            draw(router, stroke, 1, 20.0);
+            draw(reference, stroke, 1, 20.0);
+        }
+        QCOMPARE(Metrics::counter(Counter::ShapeGestures) - shapesBefore, std::uint64_t(3));
+    }
+    QCOMPARE(committed.size(), 6 + letterStrokes.size());
+    QCOMPARE(committed.at(0).type, KeyAction::CapsLock);
+    QCOMPARE(committed.at(1).type, KeyAction::DeleteWord);
+    QCOMPARE(committed.at(2).type, KeyAction::Enter);
+    QCOMPARE(committed.at(3).type, KeyAction::Backspace);
+    QCOMPARE(committed.at(4).type, KeyAction::Char);
+    QCOMPARE(committed.at(5).type, KeyAction::Char);
+    QCOMPARE(plain.size(), letterStrokes.size());
+    for (int i = 0; i < plain.size(); ++i) {
+        QCOMPARE(committed.at(6 + i).type, plain.at(i).type);
+        QCOMPARE(committed.at(6 + i).ch, plain.at(i).ch);
+    }
+
+    // Through the overlay, which commits its selection before touch_up: a shape replaces the
+    // key it sent, a stroke ending on a letter-ring key types the UI's key once.
+    QVector<KeyAction> viaOverlay;
+    {
+        InputRouter router([&](const KeyAction &action) {
+            std::lock_guard<std::mutex> lock(committedMutex);
+            viaOverlay.push_back(action);
+        }, std::make_unique<NullHapticsSink>());
+        router.setAutocorrectEnabled(false);
+        QVector<QPointF> circle;
+        for (int i = 0; i <= 32; ++i) {
+            circle << ringPoint(2.0 * M_PI * i / 32, 0.2);
+        }
+        overlayDraw(router, circle, 1, "a");
+        overlayDraw(router, {{0.32, 0.5}, {0.42, 0.6}, {0.62, 0.36}}, 4, "b");
+        overlayDraw(router, letterStrokes.first(), 1, "c");
+    }
+    QCOMPARE(viaOverlay.size(), 3);
+    QCOMPARE(viaOverlay.at(0).type, KeyAction::CapsLock);
+    QCOMPARE(viaOverlay.at(1).type, KeyAction::Enter);
+    QCOMPARE(viaOverlay.at(2).type, KeyAction::Char);
+    QCOMPARE(viaOverlay.at(2).ch, 'c');
+
+    // The journal drops the word the way ctrl+backspace does.
+    CommitBridge bridge([](const KeyAction &) {});
+    for (QChar ch : QStringLiteral("say the")) {
+        bridge.commitChar(ch);
+    }
+    bridge.commitAction(KeyAction::make(KeyAction::DeleteWord));
+    QCOMPARE(bridge.journal(), QStringLiteral("say "));
+}
+
+void EngineTests::keymapCoalescesShift() {
+    const Keymap us = Keymap::usLayout();
+    for (char32_t ch = U' '; ch < 0x7f; ++ch) {
+        QVERIFY(us.lookup(ch));
+    }
+    QCOMPARE(us.lookup(U'{')->key, std::uint16_t(KEY_LEFTBRACE));
+    QVERIFY(us.lookup(U'{')->shift);
+    QVERIFY(!us.lookup(U'\\')->shift);
+    QVERIFY(!us.lookup(0xe9));
+
+    int fds[2];
+    QCOMPARE(pipe2(fds, O_NONBLOCK | O_CLOEXEC), 0);
+    {
+        UInputKeyboard keyboard(fds[1]);
+        keyboard.sendText(QStringLiteral("ABc"));
+        input_event events[64];
+        const ssize_t bytes = read(fds[0], events, sizeof(events));
+        QVERIFY(bytes > 0);
+        // Shift goes down once for "AB" and comes up before "c".
+        QStringList sequence;
+        for (ssize_t i = 0; i < bytes / ssize_t(sizeof(input_event)); ++i) {
+            if (events[i].type == EV_KEY && events[i].value == 1) {
+                sequence << (events[i].code == KEY_LEFTSHIFT ? QStringLiteral("shift") : QString::number(events[i].code));
+            } else if (events[i].type == EV_KEY && events[i].code == KEY_LEFTSHIFT && events[i].value == 0) {
+                sequence << QStringLiteral("-shift");
+            }
+        }
+        // The leading releases guard against modifiers stuck in the host session.
+        while (!sequence.isEmpty() && sequence.first() == QStringLiteral("-shift")) {
+            sequence.removeFirst();
+        }
+        const Keymap &keymap = Keymap::active();
+        QCOMPARE(sequence, QStringList({QStringLiteral("shift"), QString::number(keymap.lookup(U'A')->key),
+                                        QString::number(keymap.lookup(U'B')->key), QStringLiteral("-shift"),
+                                        QString::number(keymap.lookup(U'c')->key)}));
+        QCOMPARE(read(fds[0], events, sizeof(events)), ssize_t(-1));
+    }
+    close(fds[0]);
+}
+
+void EngineTests::userLexiconReplaysLogTail() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const UserLexiconConfig config{4, 6};
+    {
+        UserLexicon lexicon(config);
+        QVERIFY(lexicon.open(dir.path()));
+        for (const char *word : {"the", "cat", "sat", "the", "cat"}) {
+            lexicon.learnWord(word);
+        }
+        QCOMPARE(lexicon.wordCount("cat"), 2u);
+        QCOMPARE(lexicon.bigramCount("the", "cat"), 2u);
+    }
+    {
+        // Nothing was compacted yet: the whole history comes back from the log.
+        UserLexicon lexicon(config);
+        QVERIFY(lexicon.open(dir.path()));
+        QCOMPARE(lexicon.tailRecords(), 5);
+        QCOMPARE(lexicon.bigramCount("cat", "sat"), 1u);
+        // The sixth record starts a background compaction into the snapshot.
+        lexicon.learnWord("sat");
+        lexicon.waitForCompaction();
+        QCOMPARE(lexicon.snapshotWords(), 3);
+        QCOMPARE(lexicon.tailRecords(), 0);
+        lexicon.learnWord("down");
+        lexicon.breakContext();
+        lexicon.learnWord("Up");
+        lexicon.learnWord("up");
+    }
+    QCOMPARE(QDir(dir.path()).entryList({QStringLiteral("learned-*.log")}, QDir::Files).size(), 1);
+    {
+        // Snapshot plus only the records written after it.
+        UserLexicon lexicon(config);
+        QVERIFY(lexicon.open(dir.path()));
+        QCOMPARE(lexicon.tailRecords(), 2);
+        QCOMPARE(lexicon.wordCount("sat"), 2u);
+        QCOMPARE(lexicon.wordCount("up"), 1u);
+        QCOMPARE(lexicon.wordCount("Up"), 0u);
+        QCOMPARE(lexicon.bigramCount("sat", "down"), 1u);
+        QCOMPARE(lexicon.bigramCount("down", "up"), 0u);
+
+        // A word the user keeps typing is no longer autocorrected.
+        const DefaultRadialLayout layout(kDefaultRadialTables);
+        Autocorrector autocorrect(layout);
+        autocorrect.setUserLexicon(&lexicon);
+        const LayoutPoint t = layout.keyAnchor(0, 1);
+        const LayoutPoint h = layout.keyAnchor(1, 3);
+        const double keyWidth = (2.0 * M_PI / layout.sectors()) / layout.keyCount(0);
+        // The slip of autocorrectFixesNeighborSlip: the last tap drifts towards 'e'.
+        auto typeTht = [&]() {
+            autocorrect.noteLetter('t', layout.angleForPoint(t.x, t.y), true);
+            autocorrect.noteLetter('h', layout.angleForPoint(h.x, h.y), true);
+            autocorrect.noteLetter('t', layout.angleForPoint(t.x, t.y) - 0.3 * keyWidth, true);
+            return autocorrect.finishWord();
+        };
+        QCOMPARE(typeTht().corrected, QByteArray("the"));
+        lexicon.learnWord("tht");
+        lexicon.learnWord("tht");
+        QVERIFY(typeTht().corrected.isEmpty());
+    }
+}
+
+void EngineTests::swipeTemplatesCacheAndRebuild() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const DefaultRadialLayout layout(kDefaultRadialTables);
+    const Dictionary dictionary;
+    const SwipeTemplateSource source = SwipeTemplateSource::capture(layout, dictionary);
+    {
+        // Parallel and single-threaded builds produce identical templates.
+        const std::shared_ptr<const SwipeTemplateSet> parallel = SwipeTemplateSet::build(source, 4);
+        const std::shared_ptr<const SwipeTemplateSet> serial = SwipeTemplateSet::build(source, 1);
+        QCOMPARE(parallel->size(), dictionary.size());
+        QCOMPARE(serial->size(), parallel->size());
+        QVERIFY(std::memcmp(&serial->at(0), &parallel->at(0), parallel->size() * sizeof(SwipeTemplateSet::Template)) == 0);
+    }
+
+    const RadialLayout runtime;
+    InputRouter router([](const KeyAction &) {}, std::make_unique<NullHapticsSink>());
+    auto swipeReply = [&](const QByteArray &word) {
+        QJsonArray points;
+        for (int i = 0; i + 1 < word.size(); ++i) {
+            const LayoutPoint from = source.anchors[word.at(i) - 'a'];
+            const LayoutPoint to = source.anchors[word.at(i + 1) - 'a'];
+            for (int step = 0; step < 10; ++step) {
+                points << from.x + (to.x - from.x) * step / 10.0 << from.y + (to.y - from.y) * step / 10.0;
+            }
+        }
+        const LayoutPoint last = source.anchors[word.at(word.size() - 1) - 'a'];
+        points << last.x << last.y;
+        const QJsonObject message{{"type", "swipe_decode"}, {"points", points}};
+        return QJsonDocument::fromJson(router.handleMessage(QString::fromUtf8(QJsonDocument(message).toJson(QJsonDocument::Compact))).toUtf8()).object();
+    };
+    QCOMPARE(swipeReply("there").value("ready").toBool(), false);
+
+    // First start builds in the background and writes the cache.
+    router.enableSwipeDecoding(dir.path());
+    router.waitForSwipeTemplates();
+    QVERIFY(QFile::exists(router.swipeTemplates().cachePath(source.key())));
+    QVERIFY(!router.swipeTemplates().current()->mapped());
+    const QJsonObject reply = swipeReply("there");
+    QVERIFY(reply.value("ready").toBool());
+    QCOMPARE(reply.value("candidates").toArray().at(0).toObject().value("word").toString(), QString("there"));
+
+    // Later starts map it.
+    SwipeTemplateStore store(dir.path());
+    store.prepare(layout, dictionary);
+    QVERIFY(store.current());
+    QVERIFY(store.current()->mapped());
+    QCOMPARE(store.current()->key(), source.key());
+
+    // A layout change keeps the old templates answering until the rebuild is installed.
+    router.setLayout(&runtime);
+    QVERIFY(router.swipeTemplates().current());
+    router.waitForSwipeTemplates();
+    QCOMPARE(router.swipeTemplates().current()->key(), SwipeTemplateSource::capture(runtime, dictionary).key());
+    QCOMPARE(QDir(dir.path()).entryList({QStringLiteral("templates-*.bin")}, QDir::Files).size(), 1);
+}
+
+void EngineTests::touchSessionMatchesRouter() {
+    // Gestures as (x, y, dtMs) samples: ring tap, group tap, swipes right/left/down, a drag
+    // across sectors lifted on the ring, a deadzone tap and the backspace key.
+    const DefaultRadialLayout layout(kDefaultRadialTables);
+    const LayoutPoint s = layout.keyAnchor(1, 2);
+    const LayoutPoint backspace = layout.keyAnchor(7, 1);
+    const QVector<QVector<double>> gestures = {
+        {s.x, s.y, 0, s.x + 0.005, s.y, 40, s.x + 0.01, s.y, 300},
+        {0.5, 0.3, 0, 0.5, 0.31, 40, 0.5, 0.31, 300},
+        {0.3, 0.5, 0, 0.5, 0.5, 50, 0.7, 0.5, 50},
+        {0.7, 0.5, 0, 0.5, 0.5, 50, 0.3, 0.5, 50},
+        {0.5, 0.3, 0, 0.5, 0.5, 50, 0.5, 0.7, 50},
+        {0.5, 0.25, 0, 0.75, 0.5, 300, 0.5 + 0.27, 0.5 + 0.27, 300},
+        {0.52, 0.5, 0, 0.52, 0.5, 200},
+        {backspace.x, backspace.y, 0, backspace.x, backspace.y, 250},
+    };
+
+    QVector<KeyAction> routed;
+    std::mutex routedMutex;
+    {
+        InputRouter router([&](const KeyAction &action) {
+            std::lock_guard<std::mutex> lock(routedMutex);
+            routed.push_back(action);
+        }, std::make_unique<NullHapticsSink>());
+        router.setAdaptiveTouchEnabled(false);
+        router.setAutocorrectEnabled(false);
+        router.setShapeGesturesEnabled(false);
+        for (const QVector<double> &gesture : gestures) {
+            const int count = gesture.size() / 3;
+            router.handleTouchBatch(InputRouter::TouchPhase::Down, gesture.constData(), count - 1);
+            router.handleTouchBatch(InputRouter::TouchPhase::Up, gesture.constData() + 3 * (count - 1), 1);
+        }
+    }
+
+    struct Recorder final : TouchListener {
+        void selectionChanged(const SelectionState &) override {}
+        void committed(const TouchCommit &commit) override { actions.push_back(commit.action); }
+        void cancelled() override { ++cancels; }
+        void lifted(const GestureFeatures &, SwipeDir swipe, const KeyAction &committed) override {
+            lifts.push_back(qMakePair(swipe, committed.type));
+        }
+        QVector<KeyAction> actions;
+        QVector<QPair<SwipeDir, KeyAction::Type>> lifts;
+        int cancels = 0;
+    } recorder;
+    TouchSession session(layout, recorder);
+    std::int64_t timeMs = 0;
+    for (const QVector<double> &gesture : gestures) {
+        const int count = gesture.size() / 3;
+        timeMs += 10000;
+        for (int i = 0; i < count; ++i) {
+            timeMs += std::llround(gesture.at(3 * i + 2));
+            const TouchSample sample{gesture.at(3 * i), gesture.at(3 * i + 1), timeMs};
+            if (i == 0) {
+                session.touchDown(sample);
+            } else if (i + 1 < count) {
+                session.touchMove(sample);
+            } else {
+                session.touchUp(sample);
+            }
+        }
+    }
+
+    QCOMPARE(recorder.cancels, 1);
+    QCOMPARE(recorder.actions.size(), 6);
+    QCOMPARE(recorder.actions.at(0).ch, 's');
+    QCOMPARE(recorder.actions.at(1).ch, 'e');
+    QCOMPARE(recorder.actions.at(2).type, KeyAction::Space);
+    QCOMPARE(recorder.actions.at(3).type, KeyAction::Backspace);
+    QCOMPARE(recorder.actions.at(5).type, KeyAction::Backspace);
+    // Every lift reaches the tuner hook, the deadzone tap with nothing committed.
+    QCOMPARE(recorder.lifts.size(), gestures.size());
+    QCOMPARE(recorder.lifts.at(2).first, SwipeDir::Right);
+    QCOMPARE(recorder.lifts.at(4).first, SwipeDir::Down);
+    QCOMPARE(recorder.lifts.at(4).second, KeyAction::None);
+    QCOMPARE(recorder.lifts.at(6).second, KeyAction::None);
+    QCOMPARE(routed.size(), recorder.actions.size());
+    for (int i = 0; i < routed.size(); ++i) {
+        QCOMPARE(int(routed.at(i).type), int(recorder.actions.at(i).type));
+        QCOMPARE(routed.at(i).ch, recorder.actions.at(i).ch);
+    }
+}
+
+void EngineTests::gestureTunerLearnsFromCorrections() {
+    // A fast typist: a tenth of the letters are quick short slides that clear the default gates
+    // as a swipe right, get backspaced and are retyped as taps.
+    GestureTuner tuner;
+    GestureRecognizer recognizer;
+    std::int64_t nowMs = 0;
+    auto lift = [&](double distance, double durationMs) {
+        nowMs += 400;
+        recognizer.setThresholds(tuner.thresholds());
+        recognizer.onTouchDown(TouchSample{0.3, 0.5, nowMs});
+        return recognizer.onTouchUp(TouchSample{0.3 + distance, 0.5, nowMs + std::int64_t(durationMs)});
+    };
+    auto tap = [&](int i) {
+        const SwipeDir swipe = lift(0.05 + 0.07 * (i % 5), 250 + 50 * ((3 * i) % 5));
+        tuner.observeLift(recognizer.lastGesture(), swipe, KeyAction::makeChar('e'), nowMs);
+    };
+    auto swipe = [&](int i, KeyAction::Type action) {
+        const double distance = (action == KeyAction::Backspace ? -1.0 : 1.0) * (0.25 + 0.05 * (i % 3));
+        const SwipeDir dir = lift(distance, 80 + 20 * ((i + 1) % 3));
+        tuner.observeLift(recognizer.lastGesture(), dir, KeyAction::make(action), nowMs);
+    };
+    const GestureFeatures accidental{0.15, 125.0, 0.15 / 125.0};
+    int accidentalSwipes = 0;
+    for (int i = 0; i < 600; ++i) {
+        if (i == 30) {
+            QCOMPARE(tuner.thresholds().minDistanceNorm, GestureThresholds().minDistanceNorm);
+        }
+        if (i % 10 < 7) {
+            tap(i);
+        } else if (i % 10 < 9) {
+            swipe(i, KeyAction::Space);
+        } else if (lift(accidental.distance, accidental.durationMs) == SwipeDir::Right) {
+            ++accidentalSwipes;
+            tuner.observeLift(recognizer.lastGesture(), SwipeDir::Right, KeyAction::make(KeyAction::Space),
+                              nowMs);
+            swipe(i, KeyAction::Backspace);
+            tap(i);
+        } else {
+            tuner.observeLift(recognizer.lastGesture(), SwipeDir::None, KeyAction::makeChar('t'), nowMs);
+        }
+    }
+    QVERIFY(accidentalSwipes > 0);
+    QVERIFY(tuner.samples(GestureTuner::Swipe) > 100);
+    const GestureThresholds tuned = tuner.thresholds();
+    const GestureTunerConfig envelope;
+    const GestureThresholds defaults;
+    QVERIFY(tuned.minDistanceNorm > defaults.minDistanceNorm || tuned.minVelocityNormPerMs > defaults.minVelocityNormPerMs);
+    QVERIFY(tuned.minDistanceNorm >= envelope.lower.minDistanceNorm);
+    QVERIFY(tuned.minDistanceNorm <= envelope.upper.minDistanceNorm);
+    QVERIFY(tuned.maxDurationMs >= envelope.lower.maxDurationMs);
+    QVERIFY(tuned.maxDurationMs <= envelope.upper.maxDurationMs);
+    QVERIFY(tuned.minVelocityNormPerMs >= envelope.lower.minVelocityNormPerMs);
+    QVERIFY(tuned.minVelocityNormPerMs <= envelope.upper.minVelocityNormPerMs);
+    // The slip is now a tap, the real swipes still swipe.
+    QCOMPARE(lift(accidental.distance, accidental.durationMs), SwipeDir::None);
+    QCOMPARE(lift(0.25, 100), SwipeDir::Right);
+
+    // Inverted classes (swipes slow and short, taps fast and long) never leave the envelope
+    // and leave the gates they contradict at their defaults.
+    GestureTuner inverted;
+    for (int i = 0; i < 400; ++i) {
+        inverted.observeLift(GestureFeatures{0.01, 2000.0, 0.000005}, SwipeDir::Right,
+                             KeyAction::make(KeyAction::Space), 1000 * i);
+        inverted.observeLift(GestureFeatures{0.9, 5.0, 0.18}, SwipeDir::None, KeyAction::makeChar('e'), 1000 * i + 500);
+    }
+    QCOMPARE(inverted.thresholds().minDistanceNorm, defaults.minDistanceNorm);
+    QCOMPARE(inverted.thresholds().maxDurationMs, defaults.maxDurationMs);
+    QCOMPARE(inverted.thresholds().minVelocityNormPerMs, defaults.minVelocityNormPerMs);
+
+    // Only a lift that types something is the redo: tap, backspace, backspace erases on and
+    // learns nothing about the tap; a cancel in between keeps waiting for the redo.
+    const GestureFeatures tapLift{0.05, 200.0, 0.05 / 200.0};
+    const GestureFeatures backspaceLift{0.3, 100.0, 0.3 / 100.0};
+    GestureTuner erasing;
+    erasing.observeLift(tapLift, SwipeDir::None, KeyAction::makeChar('e'), 0);
+    erasing.observeLift(backspaceLift, SwipeDir::Left, KeyAction::make(KeyAction::Backspace), 400);
+    erasing.observeLift(backspaceLift, SwipeDir::Left, KeyAction::make(KeyAction::Backspace), 800);
+    erasing.observeLift(tapLift, SwipeDir::None, KeyAction::makeChar('e'), 1200);
+    QCOMPARE(erasing.samples(GestureTuner::Tap), 0);
+    QCOMPARE(erasing.samples(GestureTuner::Swipe), 2);
+    GestureTuner cancelled;
+    cancelled.observeLift(tapLift, SwipeDir::None, KeyAction::makeChar('e'), 0);
+    cancelled.observeLift(backspaceLift, SwipeDir::Left, KeyAction::make(KeyAction::Backspace), 400);
+    cancelled.observeLift(tapLift, SwipeDir::None, KeyAction::make(KeyAction::None), 800);
+    cancelled.observeLift(backspaceLift, SwipeDir::Right, KeyAction::make(KeyAction::Space), 1200);
+    QCOMPARE(cancelled.samples(GestureTuner::Swipe), 2);
+    // A shape between the tap and the backspace takes the blame: the tap stood.
+    GestureTuner shaped;
+    shaped.observeLift(tapLift, SwipeDir::None, KeyAction::makeChar('e'), 0);
+    shaped.observeShapeLift();
+    shaped.observeLift(backspaceLift, SwipeDir::Left, KeyAction::make(KeyAction::Backspace), 400);
+    shaped.observeLift(backspaceLift, SwipeDir::Right, KeyAction::make(KeyAction::Space), 800);
+    QCOMPARE(shaped.samples(GestureTuner::Tap), 1);
+    QCOMPARE(shaped.samples(GestureTuner::Swipe), 1);
+
+    // Overlay lifts are committed with commit_char before touch_up and still reach the tuner.
+    InputRouter router([](const KeyAction &) {}, std::make_unique<NullHapticsSink>());
+    router.setAutocorrectEnabled(false);
+    for (int i = 0; i < 4; ++i) {
+        router.handleMessageUtf8("{\"type\":\"touch_batch\",\"phase\":\"down\",\"points\":[0.5,0.2,0]}");
+        router.handleMessageUtf8("{\"type\":\"commit_char\",\"char\":\"a\"}");
+        router.handleMessageUtf8("{\"type\":\"touch_batch\",\"phase\":\"up\",\"points\":[0.5,0.21,120]}");
+    }
+    QCOMPARE(router.gestureTuner().samples(GestureTuner::Tap), 3);
+
+    // Statistics persist; a truncated file is rejected and changes nothing.
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const std::string path = QFile::encodeName(dir.filePath("gesture_tuning.bin")).toStdString();
+    QVERIFY(tuner.save(path));
+    QCOMPARE(tuner.unsavedUpdates(), 0);
+    GestureTuner restored;
+    QVERIFY(restored.load(path));
+    QCOMPARE(restored.thresholds().minDistanceNorm, tuned.minDistanceNorm);
+    QCOMPARE(restored.thresholds().maxDurationMs, tuned.maxDurationMs);
+    QCOMPARE(restored.thresholds().minVelocityNormPerMs, tuned.minVelocityNormPerMs);
+    QVERIFY(::truncate(path.c_str(), 20) == 0);
+    QVERIFY(!restored.load(path));
+    QCOMPARE(restored.thresholds().minDistanceNorm, tuned.minDistanceNorm);
+}
+
 QTEST_MAIN(EngineTests)
 #include "engine_tests.moc"